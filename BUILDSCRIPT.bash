@@ -34,16 +34,25 @@ CXXARCH="${CXXARCH:--march=native}"
 CXXSTD="${CXXSTD:--std=c++2b}"
 CXXFLAGSEXTRA="${CXXFLAGSEXTRA:-}"
 LDFLAGS="${LDFLAGS:--Wall -Wextra -Wl,--as-needed -Wl,-z,now -O3 -flto=auto -s}"
-LDLIBS="${LDLIBS:-$PKG_CONFIG___LIBS_DBUS__ -lcrypto -lsqlite3}"
+LDLIBS="${LDLIBS:-$PKG_CONFIG___LIBS_DBUS__ -lcrypto -lsqlite3 -pthread}"
 BIN="${BIN:-signalbackup-tools}"
 
 # CONFIG: without_dbus
 if [ "$CONFIG" = "without_dbus" ] ; then
   CXXFLAGS="-Wall -Werror=return-type -Wextra -Woverloaded-virtual -Wshadow -pedantic -DWITHOUT_DBUS -O3 -flto"
-  LDLIBS="-lcrypto -lsqlite3"
+  LDLIBS="-lcrypto -lsqlite3 -pthread"
 fi
 
 SRC=("keyvalueframe/statics.cc"
+     "signalbackup/writeattachmentfile.cc"
+     "signalbackup/writequeuedframe.cc"
+     "signalbackup/queueencryptedframe.cc"
+     "signalbackup/htmlprefetchpage.cc"
+     "signalbackup/buildemojitrie.cc"
+     "signalbackup/htmlwritesearchindexshards.cc"
+     "signalbackup/htmlsearchindexadd.cc"
+     "signalbackup/createdeferredindexes.cc"
+     "signalbackup/execsqlstatementframe.cc"
      "signalbackup/tgmapcontacts.cc"
      "signalbackup/tgbuildbody.cc"
      "signalbackup/checkdbintegrity.cc"
@@ -203,6 +212,9 @@ SRC=("keyvalueframe/statics.cc"
      "logger/outputhead.cc"
      "mimetypes/statics.cc"
      "databaseversionframe/statics.cc"
+     "backupv2reader/nextdecryptedchunk.cc"
+     "backupv2reader/decryptmain.cc"
+     "backupv2reader/verifymain.cc"
      "backupv2reader/getframe.cc"
      "backupv2reader/backupv2reader.cc"
      "backupv2reader/readmain.cc"
@@ -210,6 +222,11 @@ SRC=("keyvalueframe/statics.cc"
      "backupv2reader/getkeys.cc"
      "xmldocument/xmldocument.cc"
      "endframe/statics.cc"
+     "sqlcipherdecryptor/read.cc"
+     "sqlcipherdecryptor/getchunk.cc"
+     "sqlcipherdecryptor/loadpages.cc"
+     "sqlcipherdecryptor/decryptpages.cc"
+     "sqlcipherdecryptor/decryptpage.cc"
      "sqlcipherdecryptor/destructor.cc"
      "sqlcipherdecryptor/gethmackey.cc"
      "sqlcipherdecryptor/sqlcipherdecryptor.cc"
@@ -221,8 +238,14 @@ SRC=("keyvalueframe/statics.cc"
      "sqlstatementframe/buildstatement.cc"
      "signalplaintextbackupdatabase/signalplaintextbackupdatabase.cc"
      "backupframe/init.cc"
+     "desktopattachmentreader/readencryptedattachment.cc"
      "desktopattachmentreader/getattachmentdata.cc"
      "memfiledb/statics.cc"
+     "sqlitedb/writequeryprofile.cc"
+     "sqlitedb/printqueryprofile.cc"
+     "sqlitedb/profileprepare.cc"
+     "sqlitedb/profilecallback.cc"
+     "sqlitedb/normalizequery.cc"
      "sqlitedb/valueasstring.cc"
      "sqlitedb/prettyprint.cc"
      "sqlitedb/databasewriteversion.cc"
@@ -259,6 +282,15 @@ SRC=("keyvalueframe/statics.cc"
      "fileencryptor/encryptframe.cc"
      "fileencryptor/fileencryptor.cc"
      "fileencryptor/encryptattachment.cc"
+     "filedecryptor/saveframeindex.cc"
+     "filedecryptor/nextindexentry.cc"
+     "filedecryptor/loadframeindex.cc"
+     "filedecryptor/indexframe.cc"
+     "filedecryptor/frameindexkey.cc"
+     "filedecryptor/usemappedinput.cc"
+     "filedecryptor/getframethreaded.cc"
+     "filedecryptor/scanframe.cc"
+     "filedecryptor/decodeframe.cc"
      "filedecryptor/getframe.cc"
      "filedecryptor/getframebrute.cc"
      "filedecryptor/filedecryptor.cc"
@@ -266,10 +298,20 @@ SRC=("keyvalueframe/statics.cc"
      "filedecryptor/initbackupframe.cc"
      "arg/usage.cc"
      "arg/arg.cc"
+     "cryptbase/initcryptcontext.cc"
      "cryptbase/getbackupkey.cc"
      "cryptbase/getcipherandmac.cc")
 
 OBJ=("keyvalueframe/o/statics.o"
+     "signalbackup/o/writeattachmentfile.o"
+     "signalbackup/o/writequeuedframe.o"
+     "signalbackup/o/queueencryptedframe.o"
+     "signalbackup/o/htmlprefetchpage.o"
+     "signalbackup/o/buildemojitrie.o"
+     "signalbackup/o/htmlwritesearchindexshards.o"
+     "signalbackup/o/htmlsearchindexadd.o"
+     "signalbackup/o/createdeferredindexes.o"
+     "signalbackup/o/execsqlstatementframe.o"
      "signalbackup/o/tgmapcontacts.o"
      "signalbackup/o/tgbuildbody.o"
      "signalbackup/o/checkdbintegrity.o"
@@ -429,6 +471,9 @@ OBJ=("keyvalueframe/o/statics.o"
      "logger/o/outputhead.o"
      "mimetypes/o/statics.o"
      "databaseversionframe/o/statics.o"
+     "backupv2reader/o/nextdecryptedchunk.o"
+     "backupv2reader/o/decryptmain.o"
+     "backupv2reader/o/verifymain.o"
      "backupv2reader/o/getframe.o"
      "backupv2reader/o/backupv2reader.o"
      "backupv2reader/o/readmain.o"
@@ -436,6 +481,11 @@ OBJ=("keyvalueframe/o/statics.o"
      "backupv2reader/o/getkeys.o"
      "xmldocument/o/xmldocument.o"
      "endframe/o/statics.o"
+     "sqlcipherdecryptor/o/read.o"
+     "sqlcipherdecryptor/o/getchunk.o"
+     "sqlcipherdecryptor/o/loadpages.o"
+     "sqlcipherdecryptor/o/decryptpages.o"
+     "sqlcipherdecryptor/o/decryptpage.o"
      "sqlcipherdecryptor/o/destructor.o"
      "sqlcipherdecryptor/o/gethmackey.o"
      "sqlcipherdecryptor/o/sqlcipherdecryptor.o"
@@ -447,8 +497,14 @@ OBJ=("keyvalueframe/o/statics.o"
      "sqlstatementframe/o/buildstatement.o"
      "signalplaintextbackupdatabase/o/signalplaintextbackupdatabase.o"
      "backupframe/o/init.o"
+     "desktopattachmentreader/o/readencryptedattachment.o"
      "desktopattachmentreader/o/getattachmentdata.o"
      "memfiledb/o/statics.o"
+     "sqlitedb/o/writequeryprofile.o"
+     "sqlitedb/o/printqueryprofile.o"
+     "sqlitedb/o/profileprepare.o"
+     "sqlitedb/o/profilecallback.o"
+     "sqlitedb/o/normalizequery.o"
      "sqlitedb/o/valueasstring.o"
      "sqlitedb/o/prettyprint.o"
      "sqlitedb/o/databasewriteversion.o"
@@ -485,6 +541,15 @@ OBJ=("keyvalueframe/o/statics.o"
      "fileencryptor/o/encryptframe.o"
      "fileencryptor/o/fileencryptor.o"
      "fileencryptor/o/encryptattachment.o"
+     "filedecryptor/o/saveframeindex.o"
+     "filedecryptor/o/nextindexentry.o"
+     "filedecryptor/o/loadframeindex.o"
+     "filedecryptor/o/indexframe.o"
+     "filedecryptor/o/frameindexkey.o"
+     "filedecryptor/o/usemappedinput.o"
+     "filedecryptor/o/getframethreaded.o"
+     "filedecryptor/o/scanframe.o"
+     "filedecryptor/o/decodeframe.o"
      "filedecryptor/o/getframe.o"
      "filedecryptor/o/getframebrute.o"
      "filedecryptor/o/filedecryptor.o"
@@ -492,6 +557,7 @@ OBJ=("keyvalueframe/o/statics.o"
      "filedecryptor/o/initbackupframe.o"
      "arg/o/usage.o"
      "arg/o/arg.o"
+     "cryptbase/o/initcryptcontext.o"
      "cryptbase/o/getbackupkey.o"
      "cryptbase/o/getcipherandmac.o")
 
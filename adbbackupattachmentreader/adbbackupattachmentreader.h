@@ -46,6 +46,7 @@ class AdbBackupAttachmentReader final : public AttachmentReader<AdbBackupAttachm
   inline AdbBackupAttachmentReader &operator=(AdbBackupAttachmentReader &&other) = default;
   inline virtual ~AdbBackupAttachmentReader() override = default;
   virtual ReturnCode getAttachment(FrameWithAttachment *frame, bool verbose) override;
+  virtual ReturnCode readAttachment(Sink const &sink, bool verbose) override;
   ReturnCode getAttachmentData(unsigned char **data, bool verbose);
   inline int64_t size() const;
 };
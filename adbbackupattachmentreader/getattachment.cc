@@ -58,3 +58,14 @@ BaseAttachmentReader::ReturnCode AdbBackupAttachmentReader::getAttachment(FrameW
     frame->setAttachmentDataBacked(data, d_size);
   return ret;
 }
+
+BaseAttachmentReader::ReturnCode AdbBackupAttachmentReader::readAttachment(Sink const &sink, bool verbose) // virtual override
+{
+  // the file is authenticated and decrypted as a whole, the result is passed on in chunks
+  unsigned char *data = nullptr;
+  ReturnCode ret = getAttachmentData(&data, verbose);
+  std::unique_ptr<unsigned char[]> attdata(data);
+  if (ret != ReturnCode::OK) [[unlikely]]
+    return ret;
+  return sinkChunked(attdata.get(), d_size, sink);
+}
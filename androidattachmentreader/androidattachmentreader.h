@@ -29,6 +29,7 @@
 #include "../baseattachmentreader/baseattachmentreader.h"
 #include "../framewithattachment/framewithattachment.h"
 #include "../cryptbase/cryptbase.h"
+#include "../mappedfile/mappedfile.h"
 
 class AndroidAttachmentReader final : public AttachmentReader<AndroidAttachmentReader>
 {
@@ -41,23 +42,33 @@ class AndroidAttachmentReader final : public AttachmentReader<AndroidAttachmentR
   unsigned char *d_cipherkey;
   uint32_t d_attachmentdata_size;
   uint32_t d_iv_size;
+  std::shared_ptr<CryptContext const> d_cryptcontext;
+  std::shared_ptr<MappedFile const> d_mappedfile; // if set, data is read from here instead of d_filename
  public:
   inline AndroidAttachmentReader(unsigned char const *iv, uint32_t iv_size,
                                  unsigned char const *mackey, uint64_t mackey_size,
                                  unsigned char const *cipherkey, uint64_t cipherkey_size,
-                                 uint32_t attsize, std::string const &filename, uint64_t filepos);
+                                 std::shared_ptr<CryptContext const> const &cryptcontext,
+                                 uint32_t attsize, std::string const &filename, uint64_t filepos,
+                                 std::shared_ptr<MappedFile const> const &mappedfile = nullptr);
   inline AndroidAttachmentReader(AndroidAttachmentReader const &other);
   inline AndroidAttachmentReader(AndroidAttachmentReader &&other) noexcept;
   inline AndroidAttachmentReader &operator=(AndroidAttachmentReader const &other);
   inline AndroidAttachmentReader &operator=(AndroidAttachmentReader &&other) noexcept;
   inline virtual ~AndroidAttachmentReader() override;
   inline virtual ReturnCode getAttachment(FrameWithAttachment *frame,  bool verbose) override;
+  inline virtual ReturnCode readAttachment(Sink const &sink, bool verbose) override;
+  inline virtual bool fileRegion(std::string *filename, uint64_t *offset, uint64_t *size) const override;
+ private:
+  inline ReturnCode decryptAttachment(unsigned char *target, Sink const *sink, bool verbose) const;
 };
 
 inline AndroidAttachmentReader::AndroidAttachmentReader(unsigned char const *iv, uint32_t iv_size,
                                                         unsigned char const *mackey, uint64_t mackey_size,
                                                         unsigned char const *cipherkey, uint64_t cipherkey_size,
-                                                        uint32_t attsize, std::string const &filename, uint64_t filepos)
+                                                        std::shared_ptr<CryptContext const> const &cryptcontext,
+                                                        uint32_t attsize, std::string const &filename, uint64_t filepos,
+                                                        std::shared_ptr<MappedFile const> const &mappedfile)
   :
   d_filepos(0),
   d_iv(nullptr),
@@ -66,7 +77,9 @@ inline AndroidAttachmentReader::AndroidAttachmentReader(unsigned char const *iv,
   d_cipherkey_size(0),
   d_cipherkey(nullptr),
   d_attachmentdata_size(0),
-  d_iv_size(0)
+  d_iv_size(0),
+  d_cryptcontext(cryptcontext),
+  d_mappedfile(mappedfile)
 {
   d_iv_size = iv_size;
   if (iv)
@@ -106,7 +119,9 @@ inline AndroidAttachmentReader::AndroidAttachmentReader(AndroidAttachmentReader
   d_cipherkey_size(other.d_cipherkey_size),
   d_cipherkey(nullptr),
   d_attachmentdata_size(other.d_attachmentdata_size),
-  d_iv_size(other.d_iv_size)
+  d_iv_size(other.d_iv_size),
+  d_cryptcontext(other.d_cryptcontext),
+  d_mappedfile(other.d_mappedfile)
 {
   if (other.d_iv)
   {
@@ -138,7 +153,9 @@ inline AndroidAttachmentReader::AndroidAttachmentReader(AndroidAttachmentReader
   d_cipherkey_size(other.d_cipherkey_size),
   d_cipherkey(other.d_cipherkey),
   d_attachmentdata_size(other.d_attachmentdata_size),
-  d_iv_size(other.d_iv_size)
+  d_iv_size(other.d_iv_size),
+  d_cryptcontext(std::move(other.d_cryptcontext)),
+  d_mappedfile(std::move(other.d_mappedfile))
 {
   other.d_attachmentdata_size = 0;
   other.d_iv_size = 0;
@@ -182,6 +199,8 @@ inline AndroidAttachmentReader &AndroidAttachmentReader::operator=(AndroidAttach
     d_filename = other.d_filename;
     d_filepos = other.d_filepos;
     d_attachmentdata_size = other.d_attachmentdata_size;
+    d_cryptcontext = other.d_cryptcontext;
+    d_mappedfile = other.d_mappedfile;
   }
   return *this;
 }
@@ -205,6 +224,8 @@ inline AndroidAttachmentReader &AndroidAttachmentReader::operator=(AndroidAttach
     d_filename = std::move(other.d_filename);
     d_filepos = other.d_filepos;
     d_attachmentdata_size = other.d_attachmentdata_size;
+    d_cryptcontext = std::move(other.d_cryptcontext);
+    d_mappedfile = std::move(other.d_mappedfile);
     // invalidate other
     other.d_iv = nullptr;
     other.d_iv_size = 0;
@@ -227,11 +248,47 @@ inline BaseAttachmentReader::ReturnCode AndroidAttachmentReader::getAttachment(F
 {
   //std::cout << " *** REALLY GETTING ATTACHMENT (ANDROID) ***" << std::endl;
 
-  std::ifstream file(d_filename, std::ios_base::binary | std::ios_base::in);
-  if (!file.is_open())
+  std::unique_ptr<unsigned char[]> decryptedattachmentdata(new unsigned char[d_attachmentdata_size]); // to hold the data
+  ReturnCode ret = decryptAttachment(decryptedattachmentdata.get(), nullptr, verbose);
+  if (ret == ReturnCode::ERROR) [[unlikely]]
+    return ret;
+
+  if (frame->setAttachmentDataBacked(decryptedattachmentdata.release(), d_attachmentdata_size))
+    return ret;
+  return ReturnCode::ERROR;
+}
+
+inline BaseAttachmentReader::ReturnCode AndroidAttachmentReader::readAttachment(Sink const &sink, bool verbose) // virtual
+{
+  return decryptAttachment(nullptr, &sink, verbose);
+}
+
+inline bool AndroidAttachmentReader::fileRegion(std::string *filename, uint64_t *offset, uint64_t *size) const // virtual
+{
+  *filename = d_filename;
+  *offset = d_filepos;
+  *size = d_attachmentdata_size + CryptBase::MACSIZE;
+  return true;
+}
+
+// decrypts the attachment into 'target' (which must hold d_attachmentdata_size
+// bytes), or if target is null, passes it to 'sink' chunk by chunk
+inline BaseAttachmentReader::ReturnCode AndroidAttachmentReader::decryptAttachment(unsigned char *target, Sink const *sink, bool verbose) const
+{
+  // when the backup file is mapped into memory, the encrypted data is used in place
+  unsigned char const *mapped = nullptr;
+  if (d_mappedfile && d_filepos + d_attachmentdata_size + CryptBase::MACSIZE <= d_mappedfile->size()) [[likely]]
+    mapped = d_mappedfile->data() + d_filepos;
+
+  std::ifstream file;
+  if (!mapped)
   {
-    Logger::error("Failed to open backup file '", d_filename, "' for reading attachment");
-    return ReturnCode::ERROR;
+    file.open(d_filename, std::ios_base::binary | std::ios_base::in);
+    if (!file.is_open())
+    {
+      Logger::error("Failed to open backup file '", d_filename, "' for reading attachment");
+      return ReturnCode::ERROR;
+    }
   }
 
   if (d_attachmentdata_size == 0) [[unlikely]]
@@ -241,38 +298,21 @@ inline BaseAttachmentReader::ReturnCode AndroidAttachmentReader::getAttachment(F
     Logger::message("Decrypting attachment data, length: ", d_attachmentdata_size);
 
   //std::cout << "Getting attachment: " << frame->filepos() << " + " << frame->length() << std::endl;
-  file.seekg(d_filepos, std::ios_base::beg);
+  if (!mapped)
+    file.seekg(d_filepos, std::ios_base::beg);
 
   // to decrypt the data
   // create context
-  std::unique_ptr<EVP_CIPHER_CTX, decltype(&::EVP_CIPHER_CTX_free)> ctx(EVP_CIPHER_CTX_new(), &::EVP_CIPHER_CTX_free);
-
-  // disable padding
-  EVP_CIPHER_CTX_set_padding(ctx.get(), 0);
-
-  // init
-  if (EVP_DecryptInit_ex(ctx.get(), EVP_aes_256_ctr(), nullptr, d_cipherkey, d_iv) != 1) [[unlikely]]
+  CryptContext::CipherCtx ctx(d_cryptcontext->cipher(d_iv));
+  if (!ctx) [[unlikely]]
   {
     Logger::error("CTX INIT FAILED");
     return ReturnCode::ERROR;
   }
 
   // to calculate the MAC
-#if OPENSSL_VERSION_NUMBER >= 0x30000000L
-  std::unique_ptr<EVP_MAC, decltype(&::EVP_MAC_free)> mac(EVP_MAC_fetch(nullptr, "hmac", nullptr), &::EVP_MAC_free);
-  std::unique_ptr<EVP_MAC_CTX, decltype(&::EVP_MAC_CTX_free)> hctx(EVP_MAC_CTX_new(mac.get()), &::EVP_MAC_CTX_free);
-  char digest[] = "SHA256";
-  OSSL_PARAM params[] = {OSSL_PARAM_construct_utf8_string("digest", digest, 0), OSSL_PARAM_construct_end()};
-#else
-  std::unique_ptr<HMAC_CTX, decltype(&::HMAC_CTX_free)> hctx(HMAC_CTX_new(), &::HMAC_CTX_free);
-#endif
-
-
-#if OPENSSL_VERSION_NUMBER >= 0x30000000L
-  if (EVP_MAC_init(hctx.get(), d_mackey, d_mackey_size, params) != 1) [[unlikely]]
-#else
-  if (HMAC_Init_ex(hctx.get(), d_mackey, d_mackey_size, EVP_sha256(), nullptr) != 1) [[unlikely]]
-#endif
+  CryptContext::HmacCtx hctx(d_cryptcontext->hmac());
+  if (!hctx) [[unlikely]]
   {
     Logger::error("Failed to initialize HMAC context");
     return ReturnCode::ERROR;
@@ -287,26 +327,34 @@ inline BaseAttachmentReader::ReturnCode AndroidAttachmentReader::getAttachment(F
     return ReturnCode::ERROR;
   }
 
-  // read and process attachment data in 32MB chunks
-  uint32_t const BUFFERSIZE = 32 * 1024;
-  unsigned char encrypteddatabuffer[BUFFERSIZE];
+  // read and process attachment data in chunks
   uint32_t processed = 0;
   uint32_t size = d_attachmentdata_size;
-  std::unique_ptr<unsigned char[]> decryptedattachmentdata(new unsigned char[size]); // to hold the data
+  uint32_t const BUFFERSIZE = std::min(static_cast<uint64_t>(size), s_chunksize);
+  std::unique_ptr<unsigned char[]> encrypteddatabuffer(mapped ? nullptr : new unsigned char[BUFFERSIZE]);
+  std::unique_ptr<unsigned char[]> decrypteddatabuffer(target ? nullptr : new unsigned char[BUFFERSIZE]);
   while (processed < size)
   {
-    if (!file.read(reinterpret_cast<char *>(encrypteddatabuffer), std::min(size - processed, BUFFERSIZE))) [[unlikely]]
+    uint32_t read = std::min(size - processed, BUFFERSIZE);
+    unsigned char const *encrypteddata = nullptr;
+    if (mapped)
+      encrypteddata = mapped + processed;
+    else
     {
-      Logger::error("STOPPING BEFORE END OF ATTACHMENT!!!", (file.eof() ? " (EOF) " : ""));
-      return ReturnCode::ERROR;
+      if (!file.read(reinterpret_cast<char *>(encrypteddatabuffer.get()), read)) [[unlikely]]
+      {
+        Logger::error("STOPPING BEFORE END OF ATTACHMENT!!!", (file.eof() ? " (EOF) " : ""));
+        return ReturnCode::ERROR;
+      }
+      read = file.gcount();
+      encrypteddata = encrypteddatabuffer.get();
     }
-    uint32_t read = file.gcount();
 
     // update MAC with read data
 #if OPENSSL_VERSION_NUMBER >= 0x30000000L
-    if (EVP_MAC_update(hctx.get(), encrypteddatabuffer, read) != 1) [[unlikely]]
+    if (EVP_MAC_update(hctx.get(), encrypteddata, read) != 1) [[unlikely]]
 #else
-    if (HMAC_Update(hctx.get(), encrypteddatabuffer, read) != 1) [[unlikely]]
+    if (HMAC_Update(hctx.get(), encrypteddata, read) != 1) [[unlikely]]
 #endif
     {
       Logger::error("Failed to update HMAC");
@@ -314,15 +362,18 @@ inline BaseAttachmentReader::ReturnCode AndroidAttachmentReader::getAttachment(F
     }
 
     // decrypt the read data;
-    int spaceleft = size - processed;
-    if (EVP_DecryptUpdate(ctx.get(), decryptedattachmentdata.get() + processed, &spaceleft, encrypteddatabuffer, read) != 1) [[unlikely]]
+    unsigned char *decrypteddata = target ? target + processed : decrypteddatabuffer.get();
+    int decryptedsize = read;
+    if (EVP_DecryptUpdate(ctx.get(), decrypteddata, &decryptedsize, encrypteddata, read) != 1) [[unlikely]]
     {
       Logger::error("Failed to decrypt data");
       return ReturnCode::ERROR;
     }
 
+    if (sink && !(*sink)(decrypteddata, decryptedsize)) [[unlikely]]
+      return ReturnCode::ERROR;
+
     processed += read;
-    //return;
   }
   DEBUGOUT("Read ", processed, " bytes");
 
@@ -339,7 +390,9 @@ inline BaseAttachmentReader::ReturnCode AndroidAttachmentReader::getAttachment(F
   }
 
   unsigned char theirMac[CryptBase::MACSIZE];
-  if (!file.read(reinterpret_cast<char *>(theirMac), CryptBase::MACSIZE)) [[unlikely]]
+  if (mapped)
+    std::memcpy(theirMac, mapped + size, CryptBase::MACSIZE);
+  else if (!file.read(reinterpret_cast<char *>(theirMac), CryptBase::MACSIZE)) [[unlikely]]
   {
     Logger::error("STOPPING BEFORE END OF ATTACHMENT!!! 2 ");
     return ReturnCode::ERROR;
@@ -347,24 +400,13 @@ inline BaseAttachmentReader::ReturnCode AndroidAttachmentReader::getAttachment(F
   DEBUGOUT("theirMac         : ", bepaald::bytesToHexString(theirMac, CryptBase::MACSIZE));
   DEBUGOUT("ourMac           : ", bepaald::bytesToHexString(hash, SHA256_DIGEST_LENGTH));
 
-  bool badmac = false;
-
   if (std::memcmp(theirMac, hash, CryptBase::MACSIZE) != 0) [[unlikely]]
   {
     Logger::warning("Bad MAC in attachmentdata: theirMac: ", bepaald::bytesToHexString(theirMac, CryptBase::MACSIZE));
     Logger::warning_indent("                             ourMac: ", bepaald::bytesToHexString(hash, SHA256_DIGEST_LENGTH));
-    badmac = true;
+    return ReturnCode::BADMAC;
   }
-  else
-    badmac = false;
-
-  if (frame->setAttachmentDataBacked(decryptedattachmentdata.release(), d_attachmentdata_size))
-  {
-    if (badmac)
-      return ReturnCode::BADMAC;
-    return ReturnCode::OK;
-  }
-  return ReturnCode::ERROR;
+  return ReturnCode::OK;
 }
 
 #endif
@@ -67,6 +67,7 @@ Arg::Arg(int argc, char *argv[])
   d_desktopdirs_1(std::string()),
   d_desktopdirs_2(std::string()),
   d_dumpdesktopdb(std::string()),
+  d_profilequeries(std::string()),
   d_mapxmlcontacts(std::vector<std::pair<std::string,long long int>>()),
   d_selectxmlchats(std::vector<std::string>()),
   d_setchatcolors(std::vector<std::pair<long long int, std::string>>()),
@@ -107,6 +108,7 @@ Arg::Arg(int argc, char *argv[])
   d_desktopdbversion(4),
   d_hiperfall(-1),
   d_onlylargerthan(-1),
+  d_threads(1),
   d_removedoubles(0),
   d_importstickers(false),
   d_migratedb(false),
@@ -173,6 +175,11 @@ Arg::Arg(int argc, char *argv[])
   d_checkdbintegrity(false),
   d_includemms(true),
   d_ignorewal(false),
+  d_deduplicatemedia(false),
+  d_shardedsearchindex(false),
+  d_lazydesktopdb(false),
+  d_frameindex(false),
+  d_mmap(false),
   d_exporthtml_required(false),
   d_input_required(false),
   d_replaceattachments_bool(false),
@@ -741,6 +748,19 @@ bool Arg::parseArgs(std::vector<std::string> const &arguments)
       }
       continue;
     }
+    if (option == "--profilequeries")
+    {
+      if (i < argsize - 1)
+      {
+        d_profilequeries = std::move(arguments[++i]);
+      }
+      else
+      {
+        std::cerr << "[ Error parsing command line option `" << option << "': Missing argument. ]" << std::endl;
+        ok = false;
+      }
+      continue;
+    }
     if (option == "--mapxmlcontacts")
     {
       if (i < argsize - 1)
@@ -1397,6 +1417,23 @@ bool Arg::parseArgs(std::vector<std::string> const &arguments)
       }
       continue;
     }
+    if (option == "--threads")
+    {
+      if (i < argsize - 1)
+      {
+        if (!ston(&d_threads, arguments[++i]))
+        {
+          std::cerr << "[ Error parsing command line option `" << option << "': Bad argument. Got '" << arguments[i] << "', expected integer. ]" << std::endl;
+          ok = false;
+        }
+      }
+      else
+      {
+        std::cerr << "[ Error parsing command line option `" << option << "': Missing argument. ]" << std::endl;
+        ok = false;
+      }
+      continue;
+    }
     if (option == "--removedoubles")
     {
       d_removedoubles_bool = true;
@@ -2076,6 +2113,56 @@ bool Arg::parseArgs(std::vector<std::string> const &arguments)
       d_ignorewal = false;
       continue;
     }
+    if (option == "--deduplicatemedia")
+    {
+      d_deduplicatemedia = true;
+      continue;
+    }
+    if (option == "--no-deduplicatemedia")
+    {
+      d_deduplicatemedia = false;
+      continue;
+    }
+    if (option == "--shardedsearchindex")
+    {
+      d_shardedsearchindex = true;
+      continue;
+    }
+    if (option == "--no-shardedsearchindex")
+    {
+      d_shardedsearchindex = false;
+      continue;
+    }
+    if (option == "--lazydesktopdb")
+    {
+      d_lazydesktopdb = true;
+      continue;
+    }
+    if (option == "--no-lazydesktopdb")
+    {
+      d_lazydesktopdb = false;
+      continue;
+    }
+    if (option == "--frameindex")
+    {
+      d_frameindex = true;
+      continue;
+    }
+    if (option == "--no-frameindex")
+    {
+      d_frameindex = false;
+      continue;
+    }
+    if (option == "--mmap")
+    {
+      d_mmap = true;
+      continue;
+    }
+    if (option == "--no-mmap")
+    {
+      d_mmap = false;
+      continue;
+    }
     if (option == "--allhtmlpages")
     {
       d_includecalllog = true;
@@ -31,7 +31,7 @@
 
 class Arg
 {
-  std::array<std::string, 219> const d_alloptions{"--appendbody", "--rawdesktopdb", "--desktopkey", "--dumpmedia", "--dumpavatars", "--importcsv", "--setselfid", "--generatedummyfordesktop", "--generatedummy", "--setcountrycode", "--mapxmladdressesfromfile", "--mapxmlcontactnamesfromfile", "--onlyolderthan", "--onlynewerthan", "-p", "--passphrase", "--prependbody", "-l", "--logfile", "--exporthtml", "--exportdesktophtml", "--importadbbackup", "--adbpassphrase", "--exportadbbackuptohtml", "--jsonshowcontactmap", "--listjsonchats", "--importtelegram", "--split-by", "--exportdesktoptxt", "--exporttxt", "--desktopdir", "--querymode", "-sp", "--sourcepassphrase", "--exportxml", "-s", "--source", "-i", "--input", "-op", "--opassphrase", "-o", "--output", "--desktopdirs", "--dumpdesktopdb", "--mapxmlcontacts", "--selectxmlchats", "--setchatcolors", "--replaceattachments", "--croptodates", "--listxmlcontacts", "--limittodates", "--mergerecipients", "--croptothreadsbyname", "--croptothreads", "--exportplaintextbackuphtml", "--importplaintextbackup", "--preventjsonmapping", "--mapjsoncontacts", "--selectjsonchats", "--limittothreadsbyname", "--limittothreads", "--importthreadsbyname", "--importthreads", "--mapcsvfields", "--runsqlquery", "--editattachmentsize", "--runprettysqlquery", "--rundtsqlquery", "--rundtprettysqlquery", "--mapxmladdresses", "--htmlignoremediatypes", "--mapxmlcontactnames", "--onlyinthreads", "--onlytype", "--exportcsv", "--mergegroups", "--limitcontacts", "--setorigin", "--findrecipient", "--split", "--onlysmallerthan", "--desktopdbversion", "--hiperfall", "--onlylargerthan", "--removedoubles", "--importstickers", "--no-importstickers", "--migratedb", "--no-migratedb", "--append", "--no-append", "--aggressivefilenamesanitizing", "--no-aggressivefilenamesanitizing", "--htmlpagemenu", "--no-htmlpagemenu", "--autofixfkc", "--no-autofixfkc", "--allowhugeattachments", "--no-allowhugeattachments", "--jsonprependforward", "--no-jsonprependforward", "--jsonmarkdelivered", "--no-jsonmarkdelivered", "--jsonmarkread", "--no-jsonmarkread", "--xmlmarkdelivered", "--no-xmlmarkdelivered", "--xmlmarkread", "--no-xmlmarkread", "--targetisdummy", "--no-targetisdummy", "--compactfilenames", "--no-compactfilenames", "--fulldecode", "--no-fulldecode", "--xmlautogroupnames", "--no-xmlautogroupnames", "--custom_hugogithubs", "--no-custom_hugogithubs", "--truncate", "--no-truncate", "--skipmessagereorder", "--no-skipmessagereorder", "--migrate_to_191", "--no-migrate_to_191", "--linkify", "--no-linkify", "--showprogress", "--no-showprogress", "--migratedesktopdb", "--no-migratedesktopdb", "--importfromdesktop", "--no-importfromdesktop", "--scramble", "--no-scramble", "--showdbinfo", "--no-showdbinfo", "--scanmissingattachments", "--no-scanmissingattachments", "-h", "--help", "--no-help", "--deleteattachments", "--no-deleteattachments", "--dbusverbose", "--no-dbusverbose", "-v", "--verbose", "--no-verbose", "--stoponerror", "--no-stoponerror", "--reordermmssmsids", "--no-reordermmssmsids", "--autolimitdates", "--no-autolimitdates", "--listrecipients", "--no-listrecipients", "--listthreads", "--no-listthreads", "--overwrite", "--no-overwrite", "--onlydb", "--no-onlydb", "--devcustom", "--no-devcustom", "--excludestickers", "--no-excludestickers", "--excludequotes", "--no-excludequotes", "--showdesktopkey", "--no-showdesktopkey", "--assumebadframesizeonbadmac", "--no-assumebadframesizeonbadmac", "--force", "--no-force", "--searchpage", "--no-searchpage", "--generatemissingstoragekeys", "--no-generatemissingstoragekeys", "--importdesktopcontacts", "--no-importdesktopcontacts", "--addincompletedataforhtmlexport", "--no-addincompletedataforhtmlexport", "--htmlfocusend", "--no-htmlfocusend", "--originalfilenames", "--no-originalfilenames", "--excludeexpiring", "--no-excludeexpiring", "--chatfolders", "--no-chatfolders", "--includereceipts", "--no-includereceipts", "--stickerpacks", "--no-stickerpacks", "--light", "--no-light", "--themeswitching", "--no-themeswitching", "--includefullcontactlist", "--no-includefullcontactlist", "--includesettings", "--no-includesettings", "--includeblockedlist", "--no-includeblockedlist", "--includecalllog", "--no-includecalllog", "--addexportdetails", "--no-addexportdetails", "--interactive", "--no-interactive", "--checkdbintegrity", "--no-checkdbintegrity", "--includemms", "--no-includemms", "--ignorewal", "--no-ignorewal", "--allhtmlpages"};
+  std::array<std::string, 231> const d_alloptions{"--appendbody", "--rawdesktopdb", "--desktopkey", "--dumpmedia", "--dumpavatars", "--importcsv", "--setselfid", "--generatedummyfordesktop", "--generatedummy", "--setcountrycode", "--mapxmladdressesfromfile", "--mapxmlcontactnamesfromfile", "--onlyolderthan", "--onlynewerthan", "-p", "--passphrase", "--prependbody", "-l", "--logfile", "--exporthtml", "--exportdesktophtml", "--importadbbackup", "--adbpassphrase", "--exportadbbackuptohtml", "--jsonshowcontactmap", "--listjsonchats", "--importtelegram", "--split-by", "--exportdesktoptxt", "--exporttxt", "--desktopdir", "--querymode", "-sp", "--sourcepassphrase", "--exportxml", "-s", "--source", "-i", "--input", "-op", "--opassphrase", "-o", "--output", "--desktopdirs", "--dumpdesktopdb", "--profilequeries", "--mapxmlcontacts", "--selectxmlchats", "--setchatcolors", "--replaceattachments", "--croptodates", "--listxmlcontacts", "--limittodates", "--mergerecipients", "--croptothreadsbyname", "--croptothreads", "--exportplaintextbackuphtml", "--importplaintextbackup", "--preventjsonmapping", "--mapjsoncontacts", "--selectjsonchats", "--limittothreadsbyname", "--limittothreads", "--importthreadsbyname", "--importthreads", "--mapcsvfields", "--runsqlquery", "--editattachmentsize", "--runprettysqlquery", "--rundtsqlquery", "--rundtprettysqlquery", "--mapxmladdresses", "--htmlignoremediatypes", "--mapxmlcontactnames", "--onlyinthreads", "--onlytype", "--exportcsv", "--mergegroups", "--limitcontacts", "--setorigin", "--findrecipient", "--split", "--onlysmallerthan", "--desktopdbversion", "--hiperfall", "--onlylargerthan", "--threads", "--removedoubles", "--importstickers", "--no-importstickers", "--migratedb", "--no-migratedb", "--append", "--no-append", "--aggressivefilenamesanitizing", "--no-aggressivefilenamesanitizing", "--htmlpagemenu", "--no-htmlpagemenu", "--autofixfkc", "--no-autofixfkc", "--allowhugeattachments", "--no-allowhugeattachments", "--jsonprependforward", "--no-jsonprependforward", "--jsonmarkdelivered", "--no-jsonmarkdelivered", "--jsonmarkread", "--no-jsonmarkread", "--xmlmarkdelivered", "--no-xmlmarkdelivered", "--xmlmarkread", "--no-xmlmarkread", "--targetisdummy", "--no-targetisdummy", "--compactfilenames", "--no-compactfilenames", "--fulldecode", "--no-fulldecode", "--xmlautogroupnames", "--no-xmlautogroupnames", "--custom_hugogithubs", "--no-custom_hugogithubs", "--truncate", "--no-truncate", "--skipmessagereorder", "--no-skipmessagereorder", "--migrate_to_191", "--no-migrate_to_191", "--linkify", "--no-linkify", "--showprogress", "--no-showprogress", "--migratedesktopdb", "--no-migratedesktopdb", "--importfromdesktop", "--no-importfromdesktop", "--scramble", "--no-scramble", "--showdbinfo", "--no-showdbinfo", "--scanmissingattachments", "--no-scanmissingattachments", "-h", "--help", "--no-help", "--deleteattachments", "--no-deleteattachments", "--dbusverbose", "--no-dbusverbose", "-v", "--verbose", "--no-verbose", "--stoponerror", "--no-stoponerror", "--reordermmssmsids", "--no-reordermmssmsids", "--autolimitdates", "--no-autolimitdates", "--listrecipients", "--no-listrecipients", "--listthreads", "--no-listthreads", "--overwrite", "--no-overwrite", "--onlydb", "--no-onlydb", "--devcustom", "--no-devcustom", "--excludestickers", "--no-excludestickers", "--excludequotes", "--no-excludequotes", "--showdesktopkey", "--no-showdesktopkey", "--assumebadframesizeonbadmac", "--no-assumebadframesizeonbadmac", "--force", "--no-force", "--searchpage", "--no-searchpage", "--generatemissingstoragekeys", "--no-generatemissingstoragekeys", "--importdesktopcontacts", "--no-importdesktopcontacts", "--addincompletedataforhtmlexport", "--no-addincompletedataforhtmlexport", "--htmlfocusend", "--no-htmlfocusend", "--originalfilenames", "--no-originalfilenames", "--excludeexpiring", "--no-excludeexpiring", "--chatfolders", "--no-chatfolders", "--includereceipts", "--no-includereceipts", "--stickerpacks", "--no-stickerpacks", "--light", "--no-light", "--themeswitching", "--no-themeswitching", "--includefullcontactlist", "--no-includefullcontactlist", "--includesettings", "--no-includesettings", "--includeblockedlist", "--no-includeblockedlist", "--includecalllog", "--no-includecalllog", "--addexportdetails", "--no-addexportdetails", "--interactive", "--no-interactive", "--checkdbintegrity", "--no-checkdbintegrity", "--includemms", "--no-includemms", "--ignorewal", "--no-ignorewal", "--deduplicatemedia", "--no-deduplicatemedia", "--shardedsearchindex", "--no-shardedsearchindex", "--lazydesktopdb", "--no-lazydesktopdb", "--frameindex", "--no-frameindex", "--mmap", "--no-mmap", "--allhtmlpages"};
   size_t d_positionals;
   size_t d_maxpositional;
   std::string d_progname;
@@ -75,6 +75,7 @@ class Arg
   std::string d_desktopdirs_1;
   std::string d_desktopdirs_2;
   std::string d_dumpdesktopdb;
+  std::string d_profilequeries;
   std::vector<std::pair<std::string,long long int>> d_mapxmlcontacts;
   std::vector<std::string> d_selectxmlchats;
   std::vector<std::pair<long long int, std::string>> d_setchatcolors;
@@ -115,6 +116,7 @@ class Arg
   long long int d_desktopdbversion;
   long long int d_hiperfall;
   long long int d_onlylargerthan;
+  long long int d_threads;
   int d_removedoubles;
   bool d_importstickers;
   bool d_migratedb;
@@ -181,6 +183,11 @@ class Arg
   bool d_checkdbintegrity;
   bool d_includemms;
   bool d_ignorewal;
+  bool d_deduplicatemedia;
+  bool d_shardedsearchindex;
+  bool d_lazydesktopdb;
+  bool d_frameindex;
+  bool d_mmap;
   bool d_exporthtml_required;
   bool d_input_required;
   bool d_replaceattachments_bool;
@@ -236,6 +243,7 @@ class Arg
   inline std::string const &desktopdirs_1() const;
   inline std::string const &desktopdirs_2() const;
   inline std::string const &dumpdesktopdb() const;
+  inline std::string const &profilequeries() const;
   inline std::vector<std::pair<std::string,long long int>> const &mapxmlcontacts() const;
   inline std::vector<std::string> const &selectxmlchats() const;
   inline std::vector<std::pair<long long int, std::string>> const &setchatcolors() const;
@@ -278,6 +286,7 @@ class Arg
   inline long long int desktopdbversion() const;
   inline long long int hiperfall() const;
   inline long long int onlylargerthan() const;
+  inline long long int threads() const;
   inline int removedoubles() const;
   inline bool removedoubles_bool() const;
   inline bool importstickers() const;
@@ -345,6 +354,11 @@ class Arg
   inline bool checkdbintegrity() const;
   inline bool includemms() const;
   inline bool ignorewal() const;
+  inline bool deduplicatemedia() const;
+  inline bool shardedsearchindex() const;
+  inline bool lazydesktopdb() const;
+  inline bool frameindex() const;
+  inline bool mmap() const;
   inline bool exporthtml_required() const;
   inline bool input_required() const;
  private:
@@ -578,6 +592,11 @@ inline std::string const &Arg::dumpdesktopdb() const
   return d_dumpdesktopdb;
 }
 
+inline std::string const &Arg::profilequeries() const
+{
+  return d_profilequeries;
+}
+
 inline std::vector<std::pair<std::string,long long int>> const &Arg::mapxmlcontacts() const
 {
   return d_mapxmlcontacts;
@@ -788,6 +807,11 @@ inline long long int Arg::onlylargerthan() const
   return d_onlylargerthan;
 }
 
+inline long long int Arg::threads() const
+{
+  return d_threads;
+}
+
 inline int Arg::removedoubles() const
 {
   return d_removedoubles;
@@ -1123,6 +1147,31 @@ inline bool Arg::ignorewal() const
   return d_ignorewal;
 }
 
+inline bool Arg::deduplicatemedia() const
+{
+  return d_deduplicatemedia;
+}
+
+inline bool Arg::shardedsearchindex() const
+{
+  return d_shardedsearchindex;
+}
+
+inline bool Arg::lazydesktopdb() const
+{
+  return d_lazydesktopdb;
+}
+
+inline bool Arg::frameindex() const
+{
+  return d_frameindex;
+}
+
+inline bool Arg::mmap() const
+{
+  return d_mmap;
+}
+
 inline bool Arg::exporthtml_required() const
 {
   return d_exporthtml_required;
@@ -48,6 +48,18 @@ changes, you must provide one of the output options.
 -l, --logfile <LOG>            Write programs output to file <LOG>. If the output file exists, it will
                                be overwritten without warning.
 --interactive                  Prompt for all passphrases
+--threads <N>                  Use N threads to verify and decrypt the backup file while reading it (and
+                               the Signal Desktop database), and to export threads with `--exporthtml'.
+                               When N is 0, all available cores are used (default 1).
+--mmap                         Map the backup file into memory instead of reading it frame by frame. Can
+                               be faster on large backups, not supported on Windows.
+--frameindex                   Store the position of every frame in '<INPUT>.sbtindex' on the first run,
+                               and use it on later runs to decode all frames in parallel. Only used (and
+                               created) when reading with `--threads' (N > 1), ignored otherwise.
+--profilequeries <FILE>        Time every SQL statement that is run. At exit, print the 20 statements that
+                               took the most time, and write the full profile to <FILE> as JSON.
+--lazydesktopdb                Decrypt the pages of the Signal Desktop database when they are needed,
+                               instead of decrypting the entire database into memory first.
 --runsqlquery <QUERY>          Run <QUERY> against the backup's internal SQL database.
 --runprettysqlquery <QUERY>    As above, but try show output in a pretty table. If the output is not too
                                large for your terminal, this is often much more readable.
@@ -90,6 +102,10 @@ changes, you must provide one of the output options.
                                          the media dump.
    --excludestickers                     Optional modifier for `--dumpmedia'. Exclude stickers from the
                                          media dump.
+   --deduplicatemedia                    Optional modifier for `--dumpmedia', `--exporthtml' and
+                                         `--output' (to a directory). Identical attachments are written
+                                         only once, the other copies are linked to that file (a reflink if
+                                         the filesystem supports it, otherwise a hard link).
 --dumpavatars <DIRECTORY>                Save all avatars to DIRECTORY.
    --limitcontacts <CONTACTS>            Optional modifier for `--dumpavatars'. Only the avatars of
                                          listed contacts are saved. CONTACTS is a list "Name 1,Name
@@ -152,6 +168,10 @@ R"*(
    --searchpage                          Optional modifier for `--exporthtml'. Generates a page from where
                                          conversations can be searched. This adds JavaScript to the page.
                                          Also, a search index is generated to facilitate searching.
+   --shardedsearchindex                  Optional modifier for `--searchpage'. Splits the search index
+                                         into many small files (in `searchidx/'), including an index of
+                                         all words. The search page only loads the files it needs, which
+                                         is much faster for large exports.
    --includecalllog                      Optional modifier for `--exporthtml'. Generate a call log-page.
    --stickerpacks                        Optional modifier for `--exporthtml'. Generate an overview of
                                          installed and known stickerpacks.
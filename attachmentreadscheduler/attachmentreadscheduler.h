@@ -0,0 +1,231 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ATTACHMENTREADSCHEDULER_H_
+#define ATTACHMENTREADSCHEDULER_H_
+
+#include <algorithm>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if !defined(_WIN32) && !defined(__MINGW64__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "../framewithattachment/framewithattachment.h"
+
+// Has the kernel read the attachments an exporter is going to need into the
+// page cache, ahead of the exporter, in order of their position in the backup
+// file. The attachments are passed in the order the exporter will use them, and
+// are advised (posix_fadvise(WILLNEED)) a window (of at most s_windowitems
+// attachments, or s_windowbytes bytes) at a time. Within a window the regions
+// are sorted by file offset, and regions close together are merged into a
+// single request. A background thread keeps at most s_aheadbytes advised
+// beyond the exporter's position, so the data is not evicted before it is used.
+//
+// Nothing is loaded into memory here: the exporter still streams every
+// attachment from the backup file itself. It calls reading(frame) when it
+// starts on an attachment, so the scheduler knows how far along it is. This may
+// happen out of order (with concurrent writers), the furthest attachment counts.
+// Attachments that are not read from a larger file, or that are large enough to
+// be read efficiently on their own (over s_maxitembytes), are not advised.
+// Without posix_fadvise(), this does nothing.
+class AttachmentReadScheduler
+{
+  static unsigned int constexpr s_windowitems = 256;
+  static uint64_t constexpr s_windowbytes = 32 * 1024 * 1024;
+  static uint64_t constexpr s_aheadbytes = 2 * s_windowbytes;
+  static uint64_t constexpr s_maxitembytes = 8 * 1024 * 1024;
+  static uint64_t constexpr s_maxgap = 64 * 1024; // regions closer together than this are advised as one
+
+  struct Region
+  {
+    uint64_t offset;   // the region of d_files[file] holding the attachment
+    uint64_t size;     // 0: not advised
+    unsigned int file;
+  };
+
+  std::vector<Region> d_regions;        // in the order the exporter uses them
+  std::vector<uint64_t> d_bytesbefore;  // total size of the advised regions before each one
+  std::unordered_map<FrameWithAttachment const *, unsigned int> d_index;
+  std::vector<std::string> d_files;
+  std::mutex d_mutex;
+  std::condition_variable d_cv;
+  unsigned int d_position;  // the furthest attachment the exporter has started on
+  bool d_stop;
+  std::thread d_advisor;    // declared last, started when everything else is initialized
+
+ public:
+  inline explicit AttachmentReadScheduler(std::vector<FrameWithAttachment *> const &frames);
+  AttachmentReadScheduler(AttachmentReadScheduler const &other) = delete;
+  AttachmentReadScheduler &operator=(AttachmentReadScheduler const &other) = delete;
+  AttachmentReadScheduler(AttachmentReadScheduler &&other) = delete;
+  AttachmentReadScheduler &operator=(AttachmentReadScheduler &&other) = delete;
+  inline ~AttachmentReadScheduler();
+  inline void reading(FrameWithAttachment const *frame);
+
+ private:
+  inline void advise();
+  inline unsigned int windowEnd(unsigned int begin) const;
+  inline void adviseWindow(unsigned int begin, unsigned int end, std::vector<int> *fds) const;
+};
+
+inline AttachmentReadScheduler::AttachmentReadScheduler(std::vector<FrameWithAttachment *> const &frames)
+  :
+  d_position(0),
+  d_stop(false)
+{
+  std::map<std::string, unsigned int> fileidx;
+  uint64_t totalbytes = 0;
+  d_regions.reserve(frames.size());
+  d_bytesbefore.reserve(frames.size() + 1);
+  for (FrameWithAttachment *frame : frames)
+  {
+    if (!frame || !d_index.emplace(frame, d_regions.size()).second) [[unlikely]]
+      continue;
+
+    Region region{0, 0, 0};
+    std::string filename;
+    if (!frame->reader() || !frame->reader()->fileRegion(&filename, &region.offset, &region.size) ||
+        region.size > s_maxitembytes)
+      region.size = 0;
+    else
+      region.file = fileidx.try_emplace(filename, fileidx.size()).first->second;
+
+    d_bytesbefore.push_back(totalbytes);
+    totalbytes += region.size;
+    d_regions.push_back(region);
+  }
+  d_bytesbefore.push_back(totalbytes);
+  d_files.resize(fileidx.size());
+  for (auto const &f : fileidx)
+    d_files[f.second] = f.first;
+
+#if !defined(_WIN32) && !defined(__MINGW64__) && defined(POSIX_FADV_WILLNEED)
+  if (totalbytes > 0)
+    d_advisor = std::thread(&AttachmentReadScheduler::advise, this);
+#endif
+}
+
+inline AttachmentReadScheduler::~AttachmentReadScheduler()
+{
+  {
+    std::lock_guard<std::mutex> lock(d_mutex);
+    d_stop = true;
+  }
+  d_cv.notify_all();
+  if (d_advisor.joinable())
+    d_advisor.join();
+}
+
+inline void AttachmentReadScheduler::reading(FrameWithAttachment const *frame)
+{
+  auto it = d_index.find(frame);
+  if (it == d_index.end())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(d_mutex);
+    if (it->second <= d_position)
+      return;
+    d_position = it->second;
+  }
+  d_cv.notify_all();
+}
+
+// the advising thread
+inline void AttachmentReadScheduler::advise()
+{
+  std::vector<int> fds(d_files.size(), -1);
+
+  for (unsigned int begin = 0; begin < d_regions.size();)
+  {
+    unsigned int end = windowEnd(begin);
+    {
+      std::unique_lock<std::mutex> lock(d_mutex);
+      d_cv.wait(lock, [&]() { return d_stop || d_bytesbefore[begin] < d_bytesbefore[d_position] + s_aheadbytes; });
+      if (d_stop)
+        break;
+    }
+    adviseWindow(begin, end, &fds);
+    begin = end;
+  }
+
+#if !defined(_WIN32) && !defined(__MINGW64__)
+  for (int fd : fds)
+    if (fd != -1)
+      ::close(fd);
+#endif
+}
+
+// the window starting at 'begin': up to s_windowitems attachments to advise,
+// s_windowbytes in total (but at least one)
+inline unsigned int AttachmentReadScheduler::windowEnd(unsigned int begin) const
+{
+  unsigned int count = 0;
+  uint64_t bytes = 0;
+  unsigned int end = begin;
+  for (; end < d_regions.size(); ++end)
+  {
+    if (d_regions[end].size == 0)
+      continue;
+    if (count == s_windowitems || (count > 0 && bytes + d_regions[end].size > s_windowbytes))
+      break;
+    ++count;
+    bytes += d_regions[end].size;
+  }
+  return end;
+}
+
+inline void AttachmentReadScheduler::adviseWindow([[maybe_unused]] unsigned int begin, [[maybe_unused]] unsigned int end,
+                                                  [[maybe_unused]] std::vector<int> *fds) const
+{
+#if !defined(_WIN32) && !defined(__MINGW64__) && defined(POSIX_FADV_WILLNEED)
+  std::vector<unsigned int> window;
+  for (unsigned int i = begin; i < end; ++i)
+    if (d_regions[i].size > 0)
+      window.push_back(i);
+  std::sort(window.begin(), window.end(), [this](unsigned int a, unsigned int b)
+  {
+    return d_regions[a].file < d_regions[b].file || (d_regions[a].file == d_regions[b].file && d_regions[a].offset < d_regions[b].offset);
+  });
+
+  for (unsigned int i = 0; i < window.size();)
+  {
+    Region const &first = d_regions[window[i]];
+    uint64_t regionend = first.offset + first.size;
+    for (++i; i < window.size() && d_regions[window[i]].file == first.file && d_regions[window[i]].offset <= regionend + s_maxgap; ++i)
+      regionend = std::max(regionend, d_regions[window[i]].offset + d_regions[window[i]].size);
+
+    int &fd = (*fds)[first.file];
+    if (fd == -1)
+      fd = ::open(d_files[first.file].c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd != -1)
+      ::posix_fadvise(fd, first.offset, regionend - first.offset, POSIX_FADV_WILLNEED);
+  }
+#endif
+}
+
+#endif
@@ -45,11 +45,18 @@
   - from the backupid and key1, we hkdf derive the AESkey and MACkey
   - then we can read and decrypt d_snapshotdir/main with the
     AESkey and MACkey. The decrypted data is gzipped, so we gunzip it
-    and process the protobuf Frames inside.
+    and process the protobuf Frames inside. After the MAC has been
+    checked, 'main' is decrypted in chunks on a separate thread, while
+    the frames are gunzipped and processed as the chunks come in.
 */
 
 BackupV2Reader::BackupV2Reader(std::string const &inputdir, std::string_view passphrase, bool verbose)
   :
+  d_main_data_encrypted_size(0),
+  d_main_iv{},
+  d_decrypt_done(false),
+  d_decrypt_failed(false),
+  d_decrypt_stop(false),
   d_main_data_gzipped_size(0),
   d_gunzip_buffer(487),//(10 * 1024 * 1024), // 10MB // interesting values: 44, 487
   d_gzip_res(0),
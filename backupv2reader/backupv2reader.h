@@ -22,10 +22,16 @@
 #ifndef BACKUPV2READER_H_
 #define BACKUPV2READER_H_
 
+#include <condition_variable>
+#include <deque>
+#include <fstream>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 
 #include "../logger/logger.h"
+#include "../cryptbase/cryptcontext.h"
 
 #include <zlib.h>
 
@@ -33,9 +39,27 @@ class BackupV2Reader
 {
   static constexpr size_t d_hmackey_size{32};
   static constexpr size_t d_aeskey_size{32};
+  static constexpr size_t s_main_ivsize{16};
+  static constexpr size_t s_main_macsize{32};
+  static constexpr size_t s_main_chunksize{1024 * 1024}; // must be a multiple of the AES block size
+  static constexpr size_t s_main_maxqueuedchunks{4};
 
   std::pair<std::unique_ptr<unsigned char []>, size_t> d_hmac_aes_keys;
-  std::unique_ptr<unsigned char []> d_main_data_gzipped;
+  std::unique_ptr<CryptContext> d_main_cryptcontext;
+  std::ifstream d_main_file;
+  uint64_t d_main_data_encrypted_size;
+  unsigned char d_main_iv[s_main_ivsize];
+
+  // decrypted chunks of 'main', produced by d_decrypt_thread, consumed by getFrame()
+  std::deque<std::pair<std::unique_ptr<unsigned char []>, size_t>> d_decrypted_chunks;
+  std::pair<std::unique_ptr<unsigned char []>, size_t> d_current_chunk;
+  std::mutex d_decrypt_mutex;
+  std::condition_variable d_decrypt_cv;
+  bool d_decrypt_done;
+  bool d_decrypt_failed;
+  bool d_decrypt_stop;
+  std::thread d_decrypt_thread;
+
   std::unique_ptr<unsigned char []> d_gzip_output;
   size_t d_main_data_gzipped_size;
   size_t d_gunzip_buffer;
@@ -58,7 +82,7 @@ class BackupV2Reader
  public:
   BackupV2Reader(std::string const &inputdir, std::string_view passphrase, bool verbose);
   BackupV2Reader(BackupV2Reader const &other) = delete;
-  BackupV2Reader(BackupV2Reader &&other) = default;
+  BackupV2Reader(BackupV2Reader &&other) = delete;
   inline ~BackupV2Reader();
   inline bool ok() const;
   std::pair<unsigned char *, size_t> getFrame();
@@ -68,6 +92,9 @@ class BackupV2Reader
   std::string readPassphrase(std::string_view passphrase) const;
   bool getKeys();
   bool readMain();
+  bool verifyMain();
+  void decryptMain();
+  bool nextDecryptedChunk();
 
   //bool handleFrame(unsigned char const *const data, size_t size, SignalBackup *sb) const;
   //bool handleRecipientFrame(BackupV2::Frame const &f, SignalBackup *sb) const;
@@ -75,6 +102,16 @@ class BackupV2Reader
 
 inline BackupV2Reader::~BackupV2Reader()
 {
+  if (d_decrypt_thread.joinable())
+  {
+    {
+      std::lock_guard<std::mutex> lock(d_decrypt_mutex);
+      d_decrypt_stop = true;
+    }
+    d_decrypt_cv.notify_all();
+    d_decrypt_thread.join();
+  }
+
   if (d_gzipstream_initialized)
     if (inflateEnd(&d_gunzip_stream) != Z_OK)
       Logger::error("Failed to end gunzip stream");
@@ -0,0 +1,86 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifdef BEPAALD_BV2_ENABLED
+
+#include "backupv2reader.h"
+
+#include <algorithm>
+
+// runs on d_decrypt_thread: reads and decrypts 'main' chunk by chunk, and
+// queues the decrypted chunks for getFrame(). At most s_main_maxqueuedchunks
+// are held at any time, so memory use does not depend on the size of the
+// backup. Errors are not logged here (the logger is not thread safe), they
+// are reported by nextDecryptedChunk() on the main thread.
+void BackupV2Reader::decryptMain()
+{
+  auto finish = [this](bool failed)
+  {
+    {
+      std::lock_guard<std::mutex> lock(d_decrypt_mutex);
+      d_decrypt_done = true;
+      d_decrypt_failed = failed;
+    }
+    d_decrypt_cv.notify_all();
+  };
+
+  CryptContext::CipherCtx ctx(d_main_cryptcontext->cipher(d_main_iv));
+  if (!ctx) [[unlikely]]
+    return finish(true);
+  EVP_CIPHER_CTX_set_padding(ctx.get(), 1); // the context template has padding disabled
+
+  std::unique_ptr<unsigned char []> encrypted(new unsigned char[s_main_chunksize]);
+  uint64_t processed = 0;
+  while (processed < d_main_data_encrypted_size)
+  {
+    uint64_t size = std::min(d_main_data_encrypted_size - processed, static_cast<uint64_t>(s_main_chunksize));
+    if (!d_main_file.read(reinterpret_cast<char *>(encrypted.get()), size)) [[unlikely]]
+      return finish(true);
+    processed += size;
+
+    // with padding enabled, DecryptUpdate may hold back the last block
+    // (released by DecryptFinal), the output needs room for one extra block
+    std::pair<std::unique_ptr<unsigned char []>, size_t> chunk{new unsigned char[size + 16], 0};
+    int written = 0;
+    if (EVP_DecryptUpdate(ctx.get(), chunk.first.get(), &written, encrypted.get(), size) != 1) [[unlikely]]
+      return finish(true);
+    chunk.second = written;
+    if (processed == d_main_data_encrypted_size)
+    {
+      int lastbits = 0;
+      if (EVP_DecryptFinal_ex(ctx.get(), chunk.first.get() + written, &lastbits) != 1) [[unlikely]]
+        return finish(true);
+      chunk.second += lastbits;
+    }
+
+    if (chunk.second == 0) [[unlikely]]
+      continue;
+
+    std::unique_lock<std::mutex> lock(d_decrypt_mutex);
+    d_decrypt_cv.wait(lock, [this]() { return d_decrypt_stop || d_decrypted_chunks.size() < s_main_maxqueuedchunks; });
+    if (d_decrypt_stop)
+      return;
+    d_decrypted_chunks.emplace_back(std::move(chunk));
+    lock.unlock();
+    d_decrypt_cv.notify_all();
+  }
+  finish(false);
+}
+
+#endif
@@ -28,7 +28,9 @@ std::pair<unsigned char *, size_t> BackupV2Reader::getFrame()
   //std::unique_ptr<unsigned char []> medianame_bytes;
   while (true)
   {
-    // now we repeatedly inflate into out output buffer (gzip_output)
+    // now we repeatedly inflate into out output buffer (gzip_output),
+    // feeding it the chunks of decrypted data as they come in from the
+    // decrypt thread
     // whenever the zstream has made some gunzipped data available in
     // the output stream, we read frames (protobuf messages) from it
     // until we cant anymore. Reading a frame means:
@@ -59,6 +61,12 @@ std::pair<unsigned char *, size_t> BackupV2Reader::getFrame()
     {
       d_gzip_previous_blocks_in = d_gunzip_stream.total_in;
 
+      // the previous decrypted chunk has been fully consumed, get the next. When
+      // there is none, inflate() may still have output pending, unless decryption
+      // failed (which has already been reported by nextDecryptedChunk())
+      if (d_gunzip_stream.avail_in == 0 && !nextDecryptedChunk() && d_decrypt_failed) [[unlikely]]
+        return {nullptr, 0};
+
       d_gzip_res = inflate(&d_gunzip_stream, Z_NO_FLUSH);
       if (d_gzip_res != Z_OK &&
           d_gzip_res != Z_STREAM_END) [[unlikely]]
@@ -83,16 +91,22 @@ std::pair<unsigned char *, size_t> BackupV2Reader::getFrame()
       //std::cout << "avail: " << available << std::endl;
       if (available == 0)
       {
-        if (d_gzip_res != Z_STREAM_END) [[unlikely]]
-          Logger::error("No bytes available, but not at ZSTREAM_END");
-        else
+        if (d_gzip_res != Z_STREAM_END)
         {
-          //std::cout << "Used data size: " << d_main_data_gzipped_size << std::endl
-          //          << "Corrected size: " << d_gunzip_stream.total_in << std::endl;
-
-          // we now have the _real_ gzipped data size...
-          d_main_data_gzipped_size = d_gunzip_stream.total_in;
+          // all output has been consumed, but the stream has not ended (the
+          // input ran out halfway): reset the output buffer and inflate the
+          // next decrypted chunk
+          d_gunzip_stream.next_out = d_gzip_output.get();
+          d_gunzip_stream.avail_out = d_gunzip_buffer;
+          d_gzip_reset = true;
+          break;
         }
+
+        //std::cout << "Used data size: " << d_main_data_gzipped_size << std::endl
+        //          << "Corrected size: " << d_gunzip_stream.total_in << std::endl;
+
+        // we now have the _real_ gzipped data size...
+        d_main_data_gzipped_size = d_gunzip_stream.total_in;
         return {nullptr, 0};
       }
 
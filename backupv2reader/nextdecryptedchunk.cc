@@ -0,0 +1,50 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifdef BEPAALD_BV2_ENABLED
+
+#include "backupv2reader.h"
+
+// waits for the next decrypted chunk of 'main' and sets it as input for the
+// gunzip stream. Returns false when there is no more data (or decryption
+// failed).
+bool BackupV2Reader::nextDecryptedChunk()
+{
+  {
+    std::unique_lock<std::mutex> lock(d_decrypt_mutex);
+    d_decrypt_cv.wait(lock, [this]() { return d_decrypt_done || !d_decrypted_chunks.empty(); });
+    if (d_decrypted_chunks.empty()) // implies d_decrypt_done
+    {
+      d_current_chunk.first.reset();
+      d_current_chunk.second = 0;
+      if (d_decrypt_failed) [[unlikely]]
+        Logger::error("Failed to decrypt '", d_snapshotdir, "/main'.");
+      return false;
+    }
+    d_current_chunk = std::move(d_decrypted_chunks.front());
+    d_decrypted_chunks.pop_front();
+  }
+  d_decrypt_cv.notify_all();
+
+  d_gunzip_stream.next_in = d_current_chunk.first.get();
+  d_gunzip_stream.avail_in = d_current_chunk.second;
+  return true;
+}
+
+#endif
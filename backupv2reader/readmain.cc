@@ -21,75 +21,58 @@
 
 #include "backupv2reader.h"
 
-#include <cstring>
-#include <memory>
-
-#include "../common_crypto.h"
+#include "../common_bytes.h"
 #include "../common_filesystem.h"
 
 bool BackupV2Reader::readMain()
 {
-  // now open 'main' and decrypt it:
-  auto [main_file_data, main_file_size] = bepaald::readFileFully(d_snapshotdir + "/main");
-  if (!main_file_data || main_file_size == 0) [[unlikely]]
-    return false;
-
-  unsigned char *main_iv = main_file_data.get();
-  unsigned char *main_data_encrypted = main_file_data.get() + 16;
-  unsigned char *main_mac = main_file_data.get() + (main_file_size - 32);
-  if (d_verbose) [[unlikely]]
-  {
-    Logger::message("  IV: ", bepaald::bytesToHexString(main_iv, 16));
-    Logger::message("  MAC: ", bepaald::bytesToHexString(main_mac, 32));
-  }
-
-  // check MAC
-  if (!bepaald::checkHmac_sha256(d_hmackey, d_hmackey_size,
-                                 main_iv, main_file_size - 32,
-                                 main_mac, SHA256_DIGEST_LENGTH)) [[unlikely]]
+  // now open 'main', it is laid out as [IV (16)][ENCRYPTED DATA][MAC (32)]
+  std::string main_filename(d_snapshotdir + "/main");
+  uint64_t main_file_size = bepaald::fileSize(main_filename);
+  if (main_file_size <= s_main_ivsize + s_main_macsize) [[unlikely]]
   {
-    Logger::error("Message authentication checksum failed for '", d_snapshotdir, "/main'. Your file may be corrupted");
+    Logger::error("Unexpected size of '", main_filename, "' (", main_file_size, " bytes)");
     return false;
   }
+  d_main_data_encrypted_size = main_file_size - s_main_ivsize - s_main_macsize;
 
-  // decrypt
-  int main_data_encrypted_length = main_file_size - 16 - 32;
-  size_t main_data_gzipped_size_padded = 0;
-  std::tie(d_main_data_gzipped, main_data_gzipped_size_padded) =
-    bepaald::decrypt_aes_256_cbc(d_aeskey, main_iv, main_data_encrypted, main_data_encrypted_length);
-  if (!d_main_data_gzipped || main_data_gzipped_size_padded == 0) [[unlikely]]
+  d_main_file.open(main_filename, std::ios_base::in | std::ios_base::binary);
+  if (!d_main_file.is_open() ||
+      !d_main_file.read(reinterpret_cast<char *>(d_main_iv), s_main_ivsize)) [[unlikely]]
   {
-    Logger::error("Failed to decrypt '", d_snapshotdir, "/main'.");
+    Logger::error("Failed to read '", main_filename, "'");
     return false;
   }
 
   if (d_verbose) [[unlikely]]
-  {
-    Logger::message("Encrypted main (truncated): ", bepaald::bytesToHexString(main_data_encrypted, 35), "...");
-    Logger::message("Decrypted main (truncated): ", bepaald::bytesToHexString(d_main_data_gzipped, 35), "... (", main_data_gzipped_size_padded, " bytes total (padded))");
-  }
+    Logger::message("  IV: ", bepaald::bytesToHexString(d_main_iv, s_main_ivsize));
+
+  d_main_cryptcontext = std::make_unique<CryptContext>(EVP_aes_256_cbc(), d_aeskey, false, d_hmackey, d_hmackey_size);
+  if (!d_main_cryptcontext->ok()) [[unlikely]]
+    return false;
 
+  // check MAC (a full pass over the file, in chunks: the data is not
+  // decrypted or processed before it is authenticated)
+  if (!verifyMain()) [[unlikely]]
+    return false;
 
+  // decrypt (on a separate thread, chunks are picked up in getFrame())
+  d_main_file.clear();
+  d_main_file.seekg(s_main_ivsize, std::ios_base::beg);
+  d_decrypt_thread = std::thread(&BackupV2Reader::decryptMain, this);
 
 
 
   // gunzip this decrypted main-data, and proces frames as we do....
 
-  // the last 4 bytes of the _actual_ gzip data stream are the uncompressed size
-  // the gzipped data is 0-padded, of course the uncompressed size can contain
-  // 0s but we will be off by at most 3 bytes, and get a more accurate progress
-  // indicator.
-  d_main_data_gzipped_size = main_data_gzipped_size_padded;
-  for (unsigned int i = main_data_gzipped_size_padded; i--; )
-    if (d_main_data_gzipped[i] > 0)
-    {
-      d_main_data_gzipped_size = i + 4;
-      break;
-    }
-
-  // set input
-  d_gunzip_stream.next_in = d_main_data_gzipped.get();
-  d_gunzip_stream.avail_in = d_main_data_gzipped_size;
+  // the real size of the gzipped data is only known once the stream has ended
+  // (the decrypted data is 0-padded), until then, the encrypted size is a close
+  // enough estimate for the progress indicator.
+  d_main_data_gzipped_size = d_main_data_encrypted_size;
+
+  // set input (nothing yet, getFrame() feeds the decrypted chunks)
+  d_gunzip_stream.next_in = Z_NULL;
+  d_gunzip_stream.avail_in = 0;
   d_gunzip_stream.zalloc = Z_NULL; // use default
   d_gunzip_stream.zfree = Z_NULL;
   d_gunzip_stream.opaque = Z_NULL;
@@ -0,0 +1,105 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifdef BEPAALD_BV2_ENABLED
+
+#include "backupv2reader.h"
+
+#include <openssl/sha.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "../common_bytes.h"
+
+// checks the MAC over IV + encrypted data, reading 'main' in chunks. The
+// file position is left at the end of the encrypted data.
+bool BackupV2Reader::verifyMain()
+{
+  CryptContext::HmacCtx hctx(d_main_cryptcontext->hmac());
+  if (!hctx) [[unlikely]]
+  {
+    Logger::error("Failed to initialize HMAC context");
+    return false;
+  }
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  if (EVP_MAC_update(hctx.get(), d_main_iv, s_main_ivsize) != 1) [[unlikely]]
+#else
+  if (HMAC_Update(hctx.get(), d_main_iv, s_main_ivsize) != 1) [[unlikely]]
+#endif
+  {
+    Logger::error("Failed to update HMAC");
+    return false;
+  }
+
+  std::unique_ptr<unsigned char []> buffer(new unsigned char[s_main_chunksize]);
+  uint64_t processed = 0;
+  while (processed < d_main_data_encrypted_size)
+  {
+    uint64_t size = std::min(d_main_data_encrypted_size - processed, static_cast<uint64_t>(s_main_chunksize));
+    if (!d_main_file.read(reinterpret_cast<char *>(buffer.get()), size)) [[unlikely]]
+    {
+      Logger::error("Failed to read '", d_snapshotdir, "/main'");
+      return false;
+    }
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    if (EVP_MAC_update(hctx.get(), buffer.get(), size) != 1) [[unlikely]]
+#else
+    if (HMAC_Update(hctx.get(), buffer.get(), size) != 1) [[unlikely]]
+#endif
+    {
+      Logger::error("Failed to update HMAC");
+      return false;
+    }
+    processed += size;
+  }
+
+  unsigned char hash[SHA256_DIGEST_LENGTH];
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  if (EVP_MAC_final(hctx.get(), hash, nullptr, SHA256_DIGEST_LENGTH) != 1) [[unlikely]]
+#else
+  unsigned int digest_size = SHA256_DIGEST_LENGTH;
+  if (HMAC_Final(hctx.get(), hash, &digest_size) != 1) [[unlikely]]
+#endif
+  {
+    Logger::error("Failed to finalize MAC");
+    return false;
+  }
+
+  unsigned char main_mac[s_main_macsize];
+  if (!d_main_file.read(reinterpret_cast<char *>(main_mac), s_main_macsize)) [[unlikely]]
+  {
+    Logger::error("Failed to read '", d_snapshotdir, "/main'");
+    return false;
+  }
+
+  if (d_verbose) [[unlikely]]
+    Logger::message("  MAC: ", bepaald::bytesToHexString(main_mac, s_main_macsize));
+
+  if (std::memcmp(hash, main_mac, s_main_macsize) != 0) [[unlikely]]
+  {
+    Logger::error("HMAC check failed. Mac read: ", bepaald::bytesToHexString(main_mac, s_main_macsize));
+    Logger::error_indent("             Mac calculated: ", bepaald::bytesToHexString(hash, SHA256_DIGEST_LENGTH));
+    Logger::error("Message authentication checksum failed for '", d_snapshotdir, "/main'. Your file may be corrupted");
+    return false;
+  }
+  return true;
+}
+
+#endif
@@ -21,6 +21,9 @@
 #define BASEATTACHMENTREADER_H_
 
 #include <cstdint>
+#include <functional>
+#include <algorithm>
+#include <string>
 
 class FrameWithAttachment;
 
@@ -34,6 +37,11 @@ class BaseAttachmentReader
     ERROR // note, windows defines 'ERROR' and error macro in wingdi.h. This is disabled by #define NOGDI in this tool
   };
 
+  // receives the attachment data in chunks of (at most) s_chunksize bytes,
+  // returning false aborts reading.
+  using Sink = std::function<bool(unsigned char const *data, uint64_t size)>;
+  static uint64_t constexpr s_chunksize = 1024 * 1024;
+
   BaseAttachmentReader() = default;
   BaseAttachmentReader(BaseAttachmentReader const &other) = default;
   BaseAttachmentReader(BaseAttachmentReader &&other) = default;
@@ -43,10 +51,26 @@ class BaseAttachmentReader
   virtual BaseAttachmentReader *clone() const = 0;
 
   inline virtual ReturnCode getAttachment(FrameWithAttachment *frame, bool verbose) = 0;
+  // passes the attachment data to 'sink' without keeping all of it in memory.
+  // note, data may already have been passed on when BADMAC is returned.
+  inline virtual ReturnCode readAttachment(Sink const &sink, bool verbose) = 0;
   // this can be overridden in attachment readers to do more cleanup if needed
   inline virtual void clearData() {}
+  // where the (encrypted) data is stored, for readers that read it from a part of
+  // a larger file. Used to read many attachments in file order.
+  inline virtual bool fileRegion(std::string *, uint64_t *, uint64_t *) const { return false; }
+
+  inline static ReturnCode sinkChunked(unsigned char const *data, uint64_t size, Sink const &sink);
 };
 
+inline BaseAttachmentReader::ReturnCode BaseAttachmentReader::sinkChunked(unsigned char const *data, uint64_t size, Sink const &sink) // static
+{
+  for (uint64_t pos = 0; pos < size; pos += s_chunksize)
+    if (!sink(data + pos, std::min(s_chunksize, size - pos))) [[unlikely]]
+      return ReturnCode::ERROR;
+  return ReturnCode::OK;
+}
+
 template <typename T>
 class AttachmentReader : public BaseAttachmentReader
 {
@@ -98,6 +98,7 @@ namespace bepaald
   inline std::string toUpper(std::string s);
   inline void replaceAll(std::string *in, char from, std::string const &to);
   inline void replaceAll(std::string *in, std::string const &from, std::string const &to);
+  inline void appendJsonString(std::string *out, std::string_view str);
   template <typename... Args>
 #if __cpp_constexpr >= 202110L
   inline constexpr std::string concat(Args const &... args);
@@ -342,6 +343,58 @@ inline void bepaald::replaceAll(std::string *in, std::string const &from, std::s
   }
 }
 
+// appends 'str' to 'out' as a (quoted) JSON string. The escaping is the same
+// as sqlite's json_object() does: only '"', '\' and control characters are
+// escaped, everything else (including multibyte UTF-8) is copied as is.
+inline void bepaald::appendJsonString(std::string *out, std::string_view str)
+{
+  out->reserve(out->size() + str.size() + 2);
+  out->push_back('"');
+
+  std::string_view::size_type start = 0; // start of the current run of characters that need no escaping
+  for (std::string_view::size_type pos = 0; pos < str.size(); ++pos)
+  {
+    unsigned char c = static_cast<unsigned char>(str[pos]);
+    if (c >= 0x20 && c != '"' && c != '\\') [[likely]]
+      continue;
+
+    out->append(str, start, pos - start);
+    start = pos + 1;
+
+    out->push_back('\\');
+    switch (c)
+    {
+      case '"':
+      case '\\':
+        out->push_back(c);
+        break;
+      case '\b':
+        out->push_back('b');
+        break;
+      case '\t':
+        out->push_back('t');
+        break;
+      case '\n':
+        out->push_back('n');
+        break;
+      case '\f':
+        out->push_back('f');
+        break;
+      case '\r':
+        out->push_back('r');
+        break;
+      default:
+        out->append("u00");
+        out->push_back("0123456789abcdef"[c >> 4]);
+        out->push_back("0123456789abcdef"[c & 0xf]);
+        break;
+    }
+  }
+  out->append(str, start, str.size() - start);
+
+  out->push_back('"');
+}
+
 template <typename... Args>
 #if __cpp_constexpr >= 202110L
 inline constexpr std::string bepaald::concat(Args const &... args)
@@ -49,6 +49,7 @@ namespace bepaald
   inline bool createDir(std::string_view path);
   inline bool isEmpty(std::string_view path);
   inline bool clearDirectory(std::string_view path);
+  inline bool caseInsensitiveDir(std::string const &dir);
   inline uint64_t fileSize(std::string_view path);
   inline std::pair<std::unique_ptr<unsigned char[]>, size_t> readFileFully(std::string_view path);
 #if defined(_WIN32) || defined(__MINGW64__)
@@ -105,6 +106,26 @@ inline bool bepaald::clearDirectory(std::string_view path)
   return true;
 }
 
+// checks if the (existing) directory 'dir' is on a filesystem that ignores case,
+// by creating a file and looking for it under another case. If no file can be
+// created there, the platform's usual filesystem behaviour is assumed.
+inline bool bepaald::caseInsensitiveDir(std::string const &dir)
+{
+  std::string const probe(dir + "/.sbt_casetest.tmp");
+  if (!std::ofstream(WIN_LONGPATH(probe), std::ios_base::binary).is_open()) [[unlikely]]
+  {
+#if defined(_WIN32) || defined(__MINGW64__) || defined(__APPLE__)
+    return true;
+#else
+    return false;
+#endif
+  }
+  bool result = fileOrDirExists(dir + "/.SBT_CASETEST.TMP");
+  std::error_code ec;
+  std::filesystem::remove(WIN_LONGPATH(probe), ec);
+  return result;
+}
+
 inline uint64_t bepaald::fileSize(std::string_view path)
 {
   std::error_code ec;
@@ -22,9 +22,11 @@
 
 #include <cstring>
 #include <cctype>
+#include <memory>
 
 #include "../common_be.h"
 #include "../common_bytes.h"
+#include "cryptcontext.h"
 
 class CryptBase
 {
@@ -40,6 +42,7 @@ class CryptBase
   unsigned char *d_salt;
   uint64_t d_salt_size;
   uint64_t d_counter;
+  std::shared_ptr<CryptContext const> d_cryptcontext; // immutable once set, shared by copies (same keys)
  public:
   unsigned int static constexpr MACSIZE = 10;
  protected:
@@ -56,6 +59,7 @@ class CryptBase
  protected:
   bool getCipherAndMac(unsigned int hashoutputsize, size_t outputsize);
   bool getBackupKey(std::string const &passphrase);
+  bool initCryptContext(bool encrypt);
   inline void uintToFourBytes(unsigned char *bytes, uint32_t val) const;
   inline uint32_t fourBytesToUint(unsigned char const *b) const;
 };
@@ -73,6 +77,7 @@ inline CryptBase::CryptBase(bool verbose)
   d_salt(nullptr),
   d_salt_size(0),
   d_counter(0),
+  d_cryptcontext(nullptr),
   d_ok(false),
   d_verbose(verbose)
 {}
@@ -90,6 +95,7 @@ inline CryptBase::CryptBase(CryptBase const &other)
   d_salt(nullptr),
   d_salt_size(other.d_salt_size),
   d_counter(other.d_counter),
+  d_cryptcontext(other.d_cryptcontext),
   d_ok(false),
   d_verbose(other.d_verbose)
 {
@@ -170,6 +176,7 @@ inline CryptBase &CryptBase::operator=(CryptBase const &other)
       std::memcpy(d_salt, other.d_salt, d_salt_size);
     }
     d_counter = other.d_counter;
+    d_cryptcontext = other.d_cryptcontext;
     d_verbose = other.d_verbose;
     d_ok = other.d_ok;
   }
@@ -189,6 +196,7 @@ inline CryptBase::CryptBase(CryptBase &&other) noexcept
   d_salt(other.d_salt),
   d_salt_size(other.d_salt_size),
   d_counter(other.d_counter),
+  d_cryptcontext(std::move(other.d_cryptcontext)),
   d_ok(other.d_ok),
   d_verbose(other.d_verbose)
 {
@@ -229,6 +237,7 @@ inline CryptBase &CryptBase::operator=(CryptBase &&other) noexcept
     d_salt = other.d_salt;
     d_salt_size = other.d_salt_size;
     d_counter = other.d_counter;
+    d_cryptcontext = std::move(other.d_cryptcontext);
 
     // invalidate other
     other.d_backupkey = nullptr;
@@ -0,0 +1,168 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CRYPTCONTEXT_H_
+#define CRYPTCONTEXT_H_
+
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+
+#include <atomic>
+#include <memory>
+
+#include "../logger/logger.h"
+
+/*
+  Holds a cipher and an HMAC context that are initialized once for a given
+  (cipher key, mac key) pair. Every use gets a cheap copy of these templates
+  (or resets the IV on an existing cipher context), instead of fetching the
+  algorithm from the provider and setting up the keys all over again. The
+  templates are never modified after construction, so copies can be taken
+  from multiple threads.
+*/
+class CryptContext
+{
+ public:
+  using CipherCtx = std::unique_ptr<EVP_CIPHER_CTX, decltype(&::EVP_CIPHER_CTX_free)>;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  using HmacCtx = std::unique_ptr<EVP_MAC_CTX, decltype(&::EVP_MAC_CTX_free)>;
+#else
+  using HmacCtx = std::unique_ptr<HMAC_CTX, decltype(&::HMAC_CTX_free)>;
+#endif
+
+ private:
+  CipherCtx d_cipher;
+  HmacCtx d_hmac;
+  bool d_ok;
+
+  static inline std::atomic<uint64_t> s_fetches_avoided{0};
+
+ public:
+  inline CryptContext(EVP_CIPHER const *cipher, unsigned char const *cipherkey, bool encrypt,
+                      unsigned char const *mackey, uint64_t mackey_size, char const *digestname = "SHA256");
+  CryptContext(CryptContext const &other) = delete;
+  CryptContext &operator=(CryptContext const &other) = delete;
+  inline bool ok() const;
+  inline CipherCtx cipher(unsigned char const *iv) const;
+  inline bool resetCipher(EVP_CIPHER_CTX *ctx, unsigned char const *iv) const;
+  inline HmacCtx hmac() const;
+  inline static uint64_t fetchesAvoided();
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  inline static EVP_MAC *hmacAlgorithm();
+#endif
+};
+
+inline CryptContext::CryptContext(EVP_CIPHER const *cipher, unsigned char const *cipherkey, bool encrypt,
+                                  unsigned char const *mackey, uint64_t mackey_size, char const *digestname)
+  :
+  d_cipher(EVP_CIPHER_CTX_new(), &::EVP_CIPHER_CTX_free),
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  d_hmac(EVP_MAC_CTX_new(hmacAlgorithm()), &::EVP_MAC_CTX_free),
+#else
+  d_hmac(HMAC_CTX_new(), &::HMAC_CTX_free),
+#endif
+  d_ok(false)
+{
+  if (!d_cipher || !d_hmac) [[unlikely]]
+  {
+    Logger::error("Failed to create crypto contexts");
+    return;
+  }
+
+  if (EVP_CipherInit_ex(d_cipher.get(), cipher, nullptr, cipherkey, nullptr, encrypt ? 1 : 0) != 1) [[unlikely]]
+  {
+    Logger::error("CTX INIT FAILED");
+    return;
+  }
+  // disable padding
+  EVP_CIPHER_CTX_set_padding(d_cipher.get(), 0);
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  OSSL_PARAM params[] = {OSSL_PARAM_construct_utf8_string("digest", const_cast<char *>(digestname), 0), OSSL_PARAM_construct_end()};
+  if (EVP_MAC_init(d_hmac.get(), mackey, mackey_size, params) != 1) [[unlikely]]
+#else
+  if (HMAC_Init_ex(d_hmac.get(), mackey, mackey_size, EVP_get_digestbyname(digestname), nullptr) != 1) [[unlikely]]
+#endif
+  {
+    Logger::error("Failed to initialize HMAC context");
+    return;
+  }
+
+  d_ok = true;
+}
+
+inline bool CryptContext::ok() const
+{
+  return d_ok;
+}
+
+// returns a copy of the (keyed) cipher context, with the given iv set
+inline CryptContext::CipherCtx CryptContext::cipher(unsigned char const *iv) const
+{
+  CipherCtx ctx(EVP_CIPHER_CTX_new(), &::EVP_CIPHER_CTX_free);
+  if (!ctx || EVP_CIPHER_CTX_copy(ctx.get(), d_cipher.get()) != 1 ||
+      EVP_CipherInit_ex(ctx.get(), nullptr, nullptr, nullptr, iv, -1) != 1) [[unlikely]]
+    return CipherCtx(nullptr, &::EVP_CIPHER_CTX_free);
+  ++s_fetches_avoided;
+  return ctx;
+}
+
+// reuse a context previously obtained from cipher(): keeps the key (schedule), sets a new iv
+inline bool CryptContext::resetCipher(EVP_CIPHER_CTX *ctx, unsigned char const *iv) const
+{
+  if (EVP_CipherInit_ex(ctx, nullptr, nullptr, nullptr, iv, -1) != 1) [[unlikely]]
+    return false;
+  ++s_fetches_avoided;
+  return true;
+}
+
+// returns a copy of the (keyed) hmac context, ready for update()
+inline CryptContext::HmacCtx CryptContext::hmac() const
+{
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  HmacCtx ctx(EVP_MAC_CTX_dup(d_hmac.get()), &::EVP_MAC_CTX_free);
+#else
+  HmacCtx ctx(HMAC_CTX_new(), &::HMAC_CTX_free);
+  if (ctx && HMAC_CTX_copy(ctx.get(), d_hmac.get()) != 1) [[unlikely]]
+    ctx.reset();
+#endif
+  if (ctx) [[likely]]
+    ++s_fetches_avoided;
+  return ctx;
+}
+
+inline uint64_t CryptContext::fetchesAvoided() // static
+{
+  return s_fetches_avoided;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+// the hmac algorithm is independent of the key, it is fetched only once for the
+// entire program
+inline EVP_MAC *CryptContext::hmacAlgorithm() // static
+{
+  static std::unique_ptr<EVP_MAC, decltype(&::EVP_MAC_free)> mac(EVP_MAC_fetch(nullptr, "hmac", nullptr), &::EVP_MAC_free);
+  static std::atomic<bool> fetched{false};
+  if (fetched.exchange(true)) [[likely]]
+    ++s_fetches_avoided;
+  return mac.get();
+}
+#endif
+
+#endif
@@ -0,0 +1,34 @@
+/*
+  Copyright (C) 2019-2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "cryptbase.ih"
+
+// sets up the (cached) cipher and hmac contexts for the current keys,
+// must be called after getCipherAndMac()
+bool CryptBase::initCryptContext(bool encrypt)
+{
+  if (!d_cipherkey || !d_mackey) [[unlikely]]
+    return false;
+
+  std::shared_ptr<CryptContext> context(new CryptContext(EVP_aes_256_ctr(), d_cipherkey, encrypt, d_mackey, d_mackey_size));
+  if (!context->ok()) [[unlikely]]
+    return false;
+
+  d_cryptcontext = std::move(context);
+  return true;
+}
@@ -54,12 +54,14 @@ class DesktopAttachmentReader final : public AttachmentReader<DesktopAttachmentR
   inline DesktopAttachmentReader &operator=(DesktopAttachmentReader &&other) = default;
   inline virtual ~DesktopAttachmentReader() override = default;
   inline virtual ReturnCode getAttachment(FrameWithAttachment *frame, bool verbose) override;
+  inline virtual ReturnCode readAttachment(Sink const &sink, bool verbose) override;
   ReturnCode getAttachmentData(unsigned char **data, bool verbose);
   //inline uint64_t getDecryptedSize() const;
   //decryptdata
  private:
   ReturnCode getEncryptedAttachment(FrameWithAttachment *frame, bool verbose);
   inline ReturnCode getRawAttachment(FrameWithAttachment *frame, bool verbose);
+  ReturnCode readEncryptedAttachment(Sink const &sink, bool verbose);
 };
 
 inline DesktopAttachmentReader::DesktopAttachmentReader(std::string const &path)
@@ -91,6 +93,17 @@ inline BaseAttachmentReader::ReturnCode DesktopAttachmentReader::getRawAttachmen
   return raw.getAttachment(frame, verbose);
 }
 
+inline BaseAttachmentReader::ReturnCode DesktopAttachmentReader::readAttachment(Sink const &sink, bool verbose)
+{
+  if (d_version >= 2) [[likely]]
+    return readEncryptedAttachment(sink, verbose);
+
+  if (verbose) [[unlikely]]
+    Logger::message("Starting read raw DesktopAttachment data");
+  RawFileAttachmentReader raw(d_path);
+  return raw.readAttachment(sink, verbose);
+}
+
 //inline uint64_t DesktopAttachmentReader::getDecryptedSize() const
 //{
 //  return d_decryptedsize;
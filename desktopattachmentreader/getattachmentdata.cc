@@ -21,6 +21,7 @@
 
 #include "../common_filesystem.h"
 #include "../common_crypto.h"
+#include "../cryptbase/cryptcontext.h"
 
 BaseAttachmentReader::ReturnCode DesktopAttachmentReader::getAttachmentData(unsigned char **rawdata, bool verbose)
 {
@@ -103,8 +104,8 @@ BaseAttachmentReader::ReturnCode DesktopAttachmentReader::getAttachmentData(unsi
   evp_md_st const *digest = EVP_sha256();
 #if OPENSSL_VERSION_NUMBER >= 0x30000000L
   char digestname[] = "SHA256";
-  std::unique_ptr<EVP_MAC, decltype(&::EVP_MAC_free)> mac(EVP_MAC_fetch(nullptr, "hmac", nullptr), &::EVP_MAC_free);
-  std::unique_ptr<EVP_MAC_CTX, decltype(&::EVP_MAC_CTX_free)> hctx(EVP_MAC_CTX_new(mac.get()), &::EVP_MAC_CTX_free);
+  // every attachment has its own key, but the hmac algorithm only needs to be fetched once
+  std::unique_ptr<EVP_MAC_CTX, decltype(&::EVP_MAC_CTX_free)> hctx(EVP_MAC_CTX_new(CryptContext::hmacAlgorithm()), &::EVP_MAC_CTX_free);
   OSSL_PARAM params[] = {OSSL_PARAM_construct_utf8_string("digest", digestname, 0), OSSL_PARAM_construct_end()};
   if (EVP_MAC_init(hctx.get(), mackey, mackey_length, params) != 1) [[unlikely]]
   {
@@ -0,0 +1,220 @@
+/*
+  Copyright (C) 2024-2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "desktopattachmentreader.h"
+
+#include "../common_filesystem.h"
+#include "../cryptbase/cryptcontext.h"
+
+// like getAttachmentData(), but without reading the entire file into memory. The
+// file is read twice, once to check the MAC, and once to decrypt the data.
+BaseAttachmentReader::ReturnCode DesktopAttachmentReader::readEncryptedAttachment(Sink const &sink, bool verbose)
+{
+  if (verbose) [[unlikely]]
+    Logger::message("Starting read encrypted DesktopAttachment data");
+
+  // set AES+MAC key
+  auto [tmpdata, key_data_length] = Base64::base64StringToBytes(d_key);
+  std::unique_ptr<unsigned char[]> key_data(tmpdata);
+  if (!tmpdata || key_data_length != 64) [[unlikely]]
+  {
+    Logger::error("Failed to get key data for decrypting attachment.");
+    return ReturnCode::ERROR;
+  }
+  unsigned char *aeskey = key_data.get();
+  uint64_t constexpr mackey_length = 32;
+  unsigned char *mackey = key_data.get() + 32;
+
+  // open file
+  std::ifstream file(std::filesystem::path(d_path), std::ios_base::in | std::ios_base::binary);
+  if (!file.is_open()) [[unlikely]]
+  {
+    Logger::error("Failed to open file '", d_path, "'");
+    return ReturnCode::ERROR;
+  }
+
+  // set iv/data length.
+  int64_t constexpr iv_length = 16;
+  int64_t data_length = bepaald::fileSize(d_path) - static_cast<int64_t>(iv_length + mackey_length);
+  if (data_length <= 0) [[unlikely]]
+  {
+    Logger::error("Got bad data length (", data_length, ")");
+    return ReturnCode::ERROR;
+  }
+
+  if (verbose) [[unlikely]]
+  {
+    Logger::message("Attachment length (iv + data + mackey): ", iv_length, " + ", data_length, " + ", mackey_length);
+    Logger::message("                                d_size: ", d_size);
+  }
+
+  // set iv
+  unsigned char iv[iv_length];
+  if (!file.read(reinterpret_cast<char *>(iv), iv_length) ||
+      file.gcount() != iv_length) [[unlikely]]
+  {
+    Logger::error("Failed to read iv");
+    return ReturnCode::ERROR;
+  }
+
+  // reads the next chunk of (encrypted) data
+  std::unique_ptr<unsigned char[]> data(new unsigned char[std::min(static_cast<uint64_t>(data_length), s_chunksize)]);
+  auto readchunk = [&](int64_t processed) -> int64_t
+  {
+    int64_t chunksize = std::min(static_cast<uint64_t>(data_length - processed), s_chunksize);
+    if (!file.read(reinterpret_cast<char *>(data.get()), chunksize) ||
+        file.gcount() != chunksize) [[unlikely]]
+    {
+      Logger::error("Failed to read in file data");
+      return -1;
+    }
+    return chunksize;
+  };
+
+  // calculate MAC
+  evp_md_st const *digest = EVP_sha256();
+  unsigned char calculatedmac[SHA256_DIGEST_LENGTH];
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  char digestname[] = "SHA256";
+  std::unique_ptr<EVP_MAC_CTX, decltype(&::EVP_MAC_CTX_free)> hctx(EVP_MAC_CTX_new(CryptContext::hmacAlgorithm()), &::EVP_MAC_CTX_free);
+  OSSL_PARAM params[] = {OSSL_PARAM_construct_utf8_string("digest", digestname, 0), OSSL_PARAM_construct_end()};
+  if (EVP_MAC_init(hctx.get(), mackey, mackey_length, params) != 1 ||
+      EVP_MAC_update(hctx.get(), iv, iv_length) != 1) [[unlikely]]
+  {
+    Logger::error("Failed to initialize HMAC context");
+    return ReturnCode::ERROR;
+  }
+#else // OPENSSL 1.x
+  std::unique_ptr<HMAC_CTX, decltype(&::HMAC_CTX_free)> hctx(HMAC_CTX_new(), &::HMAC_CTX_free);
+  if (HMAC_Init_ex(hctx.get(), mackey, mackey_length, digest, nullptr) != 1 ||
+      HMAC_Update(hctx.get(), iv, iv_length) != 1) [[unlikely]]
+  {
+    Logger::error("Failed to initialize HMAC context");
+    return ReturnCode::ERROR;
+  }
+#endif
+  for (int64_t processed = 0; processed < data_length;)
+  {
+    int64_t chunksize = readchunk(processed);
+    if (chunksize < 0) [[unlikely]]
+      return ReturnCode::ERROR;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    if (EVP_MAC_update(hctx.get(), data.get(), chunksize) != 1) [[unlikely]]
+#else
+    if (HMAC_Update(hctx.get(), data.get(), chunksize) != 1) [[unlikely]]
+#endif
+    {
+      Logger::error("Failed to update/finalize hmac");
+      return ReturnCode::ERROR;
+    }
+    processed += chunksize;
+  }
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  if (EVP_MAC_final(hctx.get(), calculatedmac, nullptr, EVP_MD_size(digest)) != 1) [[unlikely]]
+#else
+  unsigned int finalsize = EVP_MD_size(digest);
+  if (HMAC_Final(hctx.get(), calculatedmac, &finalsize) != 1) [[unlikely]]
+#endif
+  {
+    Logger::error("Failed to update/finalize hmac");
+    return ReturnCode::ERROR;
+  }
+
+  // set theirMAC
+  int64_t constexpr theirmac_length = 32;
+  unsigned char theirmac[theirmac_length];
+  if (!file.read(reinterpret_cast<char *>(theirmac), theirmac_length) ||
+      file.gcount() != theirmac_length) [[unlikely]]
+  {
+    Logger::error("Failed to read theirmac");
+    return ReturnCode::ERROR;
+  }
+
+  if (std::memcmp(calculatedmac, theirmac, theirmac_length) != 0) [[unlikely]]
+  {
+    Logger::error("MAC failed! (theirMAC: ", bepaald::bytesToHexString(theirmac, theirmac_length));
+    Logger::error_indent("               ourMAC: ", bepaald::bytesToHexString(calculatedmac, theirmac_length), ")");
+    return ReturnCode::BADMAC;
+  }
+  if (verbose) [[unlikely]]
+    Logger::message("MAC check OK!");
+
+  // decrypt the data, only passing on the first d_size bytes (the rest is padding)
+  std::unique_ptr<EVP_CIPHER_CTX, decltype(&::EVP_CIPHER_CTX_free)> ctx(EVP_CIPHER_CTX_new(), &::EVP_CIPHER_CTX_free);
+  if (EVP_DecryptInit_ex(ctx.get(), EVP_aes_256_cbc(), nullptr, aeskey, iv) != 1) [[unlikely]]
+  {
+    Logger::error("CTX INIT FAILED");
+    return ReturnCode::ERROR;
+  }
+
+  if (!file.seekg(iv_length, std::ios_base::beg)) [[unlikely]]
+  {
+    Logger::error("Failed to seek to start of file data");
+    return ReturnCode::ERROR;
+  }
+
+  uint64_t passed = 0;
+  std::unique_ptr<unsigned char[]> output(new unsigned char[std::min(static_cast<uint64_t>(data_length), s_chunksize) + EVP_MAX_BLOCK_LENGTH]);
+  auto pass = [&](int len)
+  {
+    uint64_t n = std::min(static_cast<uint64_t>(len), d_size - passed);
+    if (n == 0)
+      return true;
+    passed += n;
+    return sink(output.get(), n);
+  };
+
+  for (int64_t processed = 0; processed < data_length;)
+  {
+    int64_t chunksize = readchunk(processed);
+    if (chunksize < 0) [[unlikely]]
+      return ReturnCode::ERROR;
+    int out_len = 0;
+    if (EVP_DecryptUpdate(ctx.get(), output.get(), &out_len, data.get(), chunksize) != 1) [[unlikely]]
+    {
+      Logger::error("Failed to decrypt data");
+      return ReturnCode::ERROR;
+    }
+    if (!pass(out_len)) [[unlikely]]
+      return ReturnCode::ERROR;
+    processed += chunksize;
+  }
+
+  int tail_len = 0;
+  if (EVP_DecryptFinal_ex(ctx.get(), output.get(), &tail_len) != 1) [[unlikely]]
+  {
+    Logger::error("Failed to finalize decrypt");
+    return ReturnCode::ERROR;
+  }
+  if (!pass(tail_len)) [[unlikely]]
+    return ReturnCode::ERROR;
+
+  if (passed < d_size) [[unlikely]]
+  {
+    Logger::warning("Decrypted size is smaller than attachment size.");
+    Logger::warning_indent("The total size was likely imported from Desktop incorrectly");
+    Logger::warning_indent("Attachment path: ", d_path);
+    Logger::warning_indent("Attachment size (as found in database): ", d_size);
+    Logger::warning_indent("Attachment size (as decoded): ", passed);
+  }
+
+  if (verbose) [[unlikely]]
+    Logger::message("Successfully read DesktopAttachment data");
+
+  return ReturnCode::OK;
+}
@@ -39,6 +39,8 @@ class DesktopDatabase
   std::unique_ptr<SqlCipherDecryptor> d_cipherdb;
   std::unique_ptr<unsigned char[]> d_rawdb;
   long long int d_cipherversion;
+  unsigned int d_threads;
+  bool d_lazy;
   bool d_ok;
   bool d_verbose;
   bool d_dbus_verbose;
@@ -47,10 +49,10 @@ class DesktopDatabase
   bool d_showkey;
  public:
   inline DesktopDatabase(std::string const &hexkey, bool verbose, bool ignorewal, long long int cipherversion,
-                         bool truncate, bool showkey, bool dbus_verbose);
+                         bool truncate, bool showkey, bool dbus_verbose, unsigned int threads = 1, bool lazy = false);
   inline DesktopDatabase(std::string const &configdir, std::string const &databasedir, std::string const &rawdb,
                          std::string const &hexkey, bool verbose, bool ignorewal, long long int cipherversion,
-                         bool truncate, bool showkey, bool dbus_verbose);
+                         bool truncate, bool showkey, bool dbus_verbose, unsigned int threads = 1, bool lazy = false);
   DesktopDatabase(DesktopDatabase const &other) = delete;
   DesktopDatabase(DesktopDatabase &&other) = delete;
   DesktopDatabase &operator=(DesktopDatabase const &other) = delete;
@@ -86,19 +88,22 @@ class DesktopDatabase
 
 inline DesktopDatabase::DesktopDatabase(std::string const &hexkey, bool verbose, bool ignorewal,
                                         long long int cipherversion, bool truncate, bool showkey,
-                                        bool dbus_verbose)
+                                        bool dbus_verbose, unsigned int threads, bool lazy)
   :
-  DesktopDatabase(std::string(), std::string(), std::string(), hexkey, verbose, ignorewal, cipherversion, truncate, showkey, dbus_verbose)
+  DesktopDatabase(std::string(), std::string(), std::string(), hexkey, verbose, ignorewal, cipherversion, truncate, showkey, dbus_verbose,
+                  threads, lazy)
 {}
 
 inline DesktopDatabase::DesktopDatabase(std::string const &configdir, std::string const &databasedir, std::string const &rawdb,
                                         std::string const &hexkey, bool verbose, bool ignorewal, long long int cipherversion,
-                                        bool truncate, bool showkey, bool dbus_verbose)
+                                        bool truncate, bool showkey, bool dbus_verbose, unsigned int threads, bool lazy)
   :
   d_configdir(configdir),
   d_databasedir(databasedir),
   d_hexkey(hexkey),
   d_cipherversion(cipherversion),
+  d_threads(threads),
+  d_lazy(lazy),
   d_ok(false),
   d_verbose(verbose),
   d_dbus_verbose(dbus_verbose),
@@ -1,5 +1,5 @@
 /*
-  Copyright (C) 2024-2025  Selwin van Dijk
+  Copyright (C) 2024-2026  Selwin van Dijk
 
   This file is part of signalbackup-tools.
 
@@ -19,6 +19,7 @@
 
 #include "desktopdatabase.ih"
 
+#include <algorithm>
 #include <tuple>
 #include <fstream>
 
@@ -95,22 +96,37 @@ bool DesktopDatabase::init(std::string const &rawdb)
     Logger::message("Signal Desktop key (hex): ", d_hexkey);
 
   // decrypt the database
-  d_cipherdb.reset(new SqlCipherDecryptor(d_databasedir + "/sql/db.sqlite", d_hexkey, d_cipherversion, d_verbose));
+  d_cipherdb.reset(new SqlCipherDecryptor(d_databasedir + "/sql/db.sqlite", d_hexkey, d_cipherversion, d_threads, d_lazy, d_verbose));
   if (!d_cipherdb->ok())
     return false;
 
-  // get the decrypted data
-  auto [data, size] = d_cipherdb->data(); // unsigned char *, uint64_t
-
   // disable WAL (Write-Ahead Logging) on database, reading from memory
   // otherwise will not work see https://www.sqlite.org/fileformat.html
-  if (data[0x12] == 2)
-    data[0x12] = 1;
-  if (data[0x13] == 2)
-    data[0x13] = 1;
+  unsigned char *header = d_cipherdb->header();
+  if (header[0x12] == 2)
+    header[0x12] = 1;
+  if (header[0x13] == 2)
+    header[0x13] = 1;
+
+  if (d_cipherdb->lazy())
+  {
+    // pages are decrypted when sqlite reads them
+    MemFileDB::LazyData desktopdata = {{header, std::min(d_cipherdb->size(), static_cast<uint64_t>(100))}, // the 100 byte database header
+                                       d_cipherdb->size(), d_cipherdb.get(),
+                                       [](void *context, unsigned char *buffer, uint64_t size, uint64_t offset)
+                                       {
+                                         return reinterpret_cast<SqlCipherDecryptor *>(context)->read(buffer, size, offset);
+                                       }};
+    d_database = MemSqliteDB(&desktopdata);
+  }
+  else
+  {
+    // get the decrypted data
+    auto [data, size] = d_cipherdb->data(); // unsigned char *, uint64_t
+    std::pair<unsigned char *, uint64_t> desktopdata = {data, size};
+    d_database = MemSqliteDB(&desktopdata);
+  }
 
-  std::pair<unsigned char *, uint64_t> desktopdata = {data, size};
-  d_database = MemSqliteDB(&desktopdata);
   if (!d_database.ok())
   {
     Logger::error("Failed to open database");
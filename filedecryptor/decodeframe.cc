@@ -0,0 +1,91 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "filedecryptor.ih"
+
+// Verifies and decrypts a single frame. This function may be called from any
+// thread: it only reads the (fixed) keys and crypto contexts and does not log
+// anything, any errors are reported through the returned status (and info string).
+FileDecryptor::DecodedFrame FileDecryptor::decodeFrame(RawFrame const &raw) const
+{
+  DecodedFrame result{nullptr, std::string(), raw.framenumber, DecodeStatus::ERROR};
+
+  // calculate MAC over (encrypted) length and frame data
+  CryptContext::HmacCtx hctx(d_cryptcontext->hmac());
+  if (!hctx) [[unlikely]]
+  {
+    result.info = "Failed to initialize HMAC context";
+    return result;
+  }
+
+  unsigned char hash[SHA256_DIGEST_LENGTH];
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  if (EVP_MAC_update(hctx.get(), reinterpret_cast<unsigned char const *>(&raw.encryptedlength), sizeof(decltype(raw.encryptedlength))) != 1 ||
+      EVP_MAC_update(hctx.get(), raw.data, raw.length - MACSIZE) != 1 ||
+      EVP_MAC_final(hctx.get(), hash, nullptr, SHA256_DIGEST_LENGTH) != 1) [[unlikely]]
+#else
+  unsigned int digest_size = SHA256_DIGEST_LENGTH;
+  if (HMAC_Update(hctx.get(), reinterpret_cast<unsigned char const *>(&raw.encryptedlength), sizeof(decltype(raw.encryptedlength))) != 1 ||
+      HMAC_Update(hctx.get(), raw.data, raw.length - MACSIZE) != 1 ||
+      HMAC_Final(hctx.get(), hash, &digest_size) != 1) [[unlikely]]
+#endif
+  {
+    result.info = "Failed to calculate MAC";
+    return result;
+  }
+
+  if (std::memcmp(raw.data + (raw.length - MACSIZE), hash, MACSIZE) != 0) [[unlikely]]
+  {
+    result.info = bepaald::concat("Bad MAC in frame: theirMac: ", bepaald::bytesToHexString(raw.data + (raw.length - MACSIZE), MACSIZE),
+                                  "\n                              ourMac: ", bepaald::bytesToHexString(hash, SHA256_DIGEST_LENGTH));
+    result.status = DecodeStatus::BADMAC;
+    return result;
+  }
+
+  // decrypt, the first four bytes of keystream were used for the frame length
+  CryptContext::CipherCtx ctx(d_cryptcontext->cipher(raw.iv.data()));
+  if (!ctx) [[unlikely]]
+  {
+    result.info = "CTX INIT FAILED";
+    return result;
+  }
+
+  uint32_t framelength = 0;
+  int framelength_size = sizeof(decltype(framelength));
+  int decodedframelength = raw.length - MACSIZE;
+  std::unique_ptr<unsigned char[]> decodedframe(new unsigned char[decodedframelength]);
+  if (EVP_DecryptUpdate(ctx.get(), reinterpret_cast<unsigned char *>(&framelength), &framelength_size,
+                        reinterpret_cast<unsigned char const *>(&raw.encryptedlength), sizeof(decltype(raw.encryptedlength))) != 1 ||
+      EVP_DecryptUpdate(ctx.get(), decodedframe.get(), &decodedframelength, raw.data, raw.length - MACSIZE) != 1) [[unlikely]]
+  {
+    result.info = "Failed to decrypt data";
+    return result;
+  }
+
+  result.frame.reset(initBackupFrame(decodedframe.get(), decodedframelength, raw.framenumber));
+  if (!result.frame) [[unlikely]]
+  {
+    result.info = bepaald::bytesToHexString(decodedframe.get(), decodedframelength);
+    result.status = DecodeStatus::INVALID;
+    return result;
+  }
+
+  result.status = DecodeStatus::OK;
+  return result;
+}
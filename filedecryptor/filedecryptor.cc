@@ -30,9 +30,19 @@ FileDecryptor::FileDecryptor(std::string const &filename, std::string const &pas
   d_framecount(0),
   d_filesize(0),
   d_backupfileversion(0),
+  d_mappedfile(nullptr),
+  d_mappos(0),
+  d_framebuffer(nullptr),
+  d_framebuffer_size(0),
+  d_frameindexpos(0),
+  d_frameindexloaded(false),
+  d_recordframeindex(false),
+  d_threads(1),
   d_badmac(false),
   d_assumebadframesize(assumebadframesize),
-  d_stoponerror(stoponerror)
+  d_stoponerror(stoponerror),
+  d_scandone(false),
+  d_threadpool(nullptr)
 {
   std::ifstream file(d_filename, std::ios_base::binary | std::ios_base::in);
   if (!file.is_open())
@@ -101,6 +111,13 @@ FileDecryptor::FileDecryptor(std::string const &filename, std::string const &pas
     return;
   }
 
+  if (!initCryptContext(false))
+  {
+    Logger::error("Failed to initialize crypto contexts");
+    delete headerframe;
+    return;
+  }
+
   d_backupfileversion = reinterpret_cast<HeaderFrame *>(headerframe)->version();
 
   //headerframe->printInfo();
@@ -20,26 +20,82 @@
 #ifndef FILEDECRYPTOR_H_
 #define FILEDECRYPTOR_H_
 
+#include <array>
 #include <cstring>
+#include <deque>
 #include <fstream>
+#include <future>
 #include <memory>
 
 #include "../common_be.h"
 #include "../backupframe/backupframe.h"
 #include "../cryptbase/cryptbase.h"
 #include "../logger/logger.h"
+#include "../mappedfile/mappedfile.h"
+#include "../threadpool/threadpool.h"
 
 class  FileDecryptor final : public CryptBase
 {
+  // an encrypted frame as read from file, to be verified and decrypted (possibly on another thread)
+  struct RawFrame
+  {
+    std::unique_ptr<unsigned char[]> owneddata; // not used when data points into the mapped file
+    unsigned char const *data;
+    std::array<unsigned char, 16> iv;
+    uint64_t framenumber;
+    uint32_t length;
+    uint32_t encryptedlength; // the (still encrypted) length field, it is covered by the MAC
+  };
+
+  enum class DecodeStatus : std::uint8_t
+  {
+    OK,
+    BADMAC,
+    INVALID,
+    ERROR,
+  };
+
+  struct DecodedFrame
+  {
+    std::unique_ptr<BackupFrame> frame;
+    std::string info; // details for error messages, these are logged by the consuming thread
+    uint64_t framenumber;
+    DecodeStatus status;
+  };
+
+  // position and properties of a single frame, as stored in the frame index file
+  struct FrameIndexEntry
+  {
+    uint64_t offset;
+    uint64_t counter;
+    uint64_t rowid;      // attachment frames only
+    uint64_t uniqueid;   // attachment frames only
+    uint32_t length;
+    uint32_t attachmentsize;
+    uint32_t type;
+  };
+
   std::string d_filename;
   std::vector<long long int> d_editattachments;
   std::unique_ptr<BackupFrame> d_headerframe;
   uint64_t d_framecount;
   uint64_t d_filesize;
   uint32_t d_backupfileversion;
+  std::shared_ptr<MappedFile const> d_mappedfile; // shared with the AndroidAttachmentReaders
+  uint64_t d_mappos;
+  std::unique_ptr<unsigned char[]> d_framebuffer; // decrypted frame data, reused for every frame
+  uint32_t d_framebuffer_size;
+  std::vector<FrameIndexEntry> d_frameindex;
+  uint64_t d_frameindexpos; // next entry to be used when reading with a loaded index
+  bool d_frameindexloaded;
+  bool d_recordframeindex;
+  unsigned int d_threads;
   bool d_badmac;
   bool d_assumebadframesize;
   bool d_stoponerror;
+  bool d_scandone;
+  std::deque<std::future<DecodedFrame>> d_pendingframes;
+  std::unique_ptr<ThreadPool> d_threadpool; // declared last: workers are joined before anything else is destroyed
 
  public:
   FileDecryptor(std::string const &filename, std::string const &passphrase, bool verbose, bool stoponerror = false, bool assumebadframesize = false, std::vector<long long int> const &editattachments = std::vector<long long int>());
@@ -52,6 +108,12 @@ class  FileDecryptor final : public CryptBase
   std::unique_ptr<BackupFrame> getFrame(std::ifstream &file);
   inline uint64_t total() const;
   inline bool badMac() const;
+  inline void setThreads(unsigned int threads);
+  bool useMappedInput();
+  inline uint64_t position(std::ifstream &file) const;
+  bool loadFrameIndex(std::string const &indexfile);
+  bool saveFrameIndex(std::string const &indexfile) const;
+  inline void recordFrameIndex(bool record);
 
   // temporary /* CUSTOMS */
   // void ashmorgan(std::ifstream &file);
@@ -66,6 +128,15 @@ class  FileDecryptor final : public CryptBase
   inline uint32_t getNextFrameBlockSize(std::ifstream &file);
   inline bool getNextFrameBlock(std::ifstream &file, unsigned char *data, size_t length);
   BackupFrame *initBackupFrame(unsigned char *data, size_t length, uint64_t count = 0) const;
+  inline unsigned char const *nextBytes(std::ifstream &file, uint32_t length, unsigned char *buffer);
+  std::unique_ptr<BackupFrame> getFrameThreaded(std::ifstream &file);
+  bool scanFrame(std::ifstream &file);
+  inline FileDecryptor &stopDecoding();
+  DecodedFrame decodeFrame(RawFrame const &raw) const;
+  void indexFrame(uint64_t offset, uint64_t counter, uint32_t length, unsigned int type, BackupFrame const *frame);
+  FrameIndexEntry const *nextIndexEntry(uint64_t offset, uint64_t counter, uint32_t length);
+  inline void dropFrameIndex();
+  bool frameIndexKey(unsigned char *key) const;
   //virtual int getAttachment(FrameWithAttachment *frame) override;
 
   std::unique_ptr<BackupFrame> bruteForceFrom(std::ifstream &file, uint64_t filepos, uint32_t previousframelength);
@@ -81,9 +152,20 @@ inline FileDecryptor::FileDecryptor(FileDecryptor const &other)
   d_framecount(other.d_framecount),
   d_filesize(other.d_filesize),
   d_backupfileversion(other.d_backupfileversion),
+  d_mappedfile(other.d_mappedfile),
+  d_mappos(other.d_mappos),
+  d_framebuffer(nullptr),
+  d_framebuffer_size(0),
+  d_frameindex(other.d_frameindex),
+  d_frameindexpos(other.d_frameindexpos),
+  d_frameindexloaded(other.d_frameindexloaded),
+  d_recordframeindex(other.d_recordframeindex),
+  d_threads(other.d_threads),
   d_badmac(other.d_badmac),
   d_assumebadframesize(other.d_assumebadframesize),
-  d_stoponerror(other.d_stoponerror)
+  d_stoponerror(other.d_stoponerror),
+  d_scandone(false),
+  d_threadpool(nullptr)
 {
   d_ok = false;
 
@@ -98,6 +180,9 @@ inline FileDecryptor &FileDecryptor::operator=(FileDecryptor const &other)
 {
   if (this != &other)
   {
+    // stop our decoding before any member the workers use is replaced
+    stopDecoding();
+
     CryptBase::operator=(other);
     d_filename = other.d_filename;
     d_editattachments = other.d_editattachments;
@@ -106,32 +191,57 @@ inline FileDecryptor &FileDecryptor::operator=(FileDecryptor const &other)
     d_framecount = other.d_framecount;
     d_filesize = other.d_filesize;
     d_backupfileversion = other.d_backupfileversion;
+    d_mappedfile = other.d_mappedfile;
+    d_mappos = other.d_mappos;
+    d_frameindex = other.d_frameindex;
+    d_frameindexpos = other.d_frameindexpos;
+    d_frameindexloaded = other.d_frameindexloaded;
+    d_recordframeindex = other.d_recordframeindex;
+    d_threads = other.d_threads;
     d_badmac = other.d_badmac;
     d_assumebadframesize = other.d_assumebadframesize;
     d_stoponerror = other.d_stoponerror;
+    d_scandone = false;
     d_ok = other.d_ok;
   }
   return *this;
 }
 
+// work in progress is not taken over: its tasks are bound to 'other'
 inline FileDecryptor::FileDecryptor(FileDecryptor &&other) noexcept
   :
-  CryptBase(std::move(other)),
+  CryptBase(std::move(other.stopDecoding())),
   d_filename(std::move(other.d_filename)),
   d_editattachments(std::move(other.d_editattachments)),
   d_headerframe(std::move(other.d_headerframe)),
   d_framecount(other.d_framecount),
   d_filesize(other.d_filesize),
   d_backupfileversion(other.d_backupfileversion),
+  d_mappedfile(std::move(other.d_mappedfile)),
+  d_mappos(other.d_mappos),
+  d_framebuffer(std::move(other.d_framebuffer)),
+  d_framebuffer_size(other.d_framebuffer_size),
+  d_frameindex(std::move(other.d_frameindex)),
+  d_frameindexpos(other.d_frameindexpos),
+  d_frameindexloaded(other.d_frameindexloaded),
+  d_recordframeindex(other.d_recordframeindex),
+  d_threads(other.d_threads),
   d_badmac(other.d_badmac),
   d_assumebadframesize(other.d_assumebadframesize),
-  d_stoponerror(other.d_stoponerror)
+  d_stoponerror(other.d_stoponerror),
+  d_scandone(other.d_scandone),
+  d_threadpool(nullptr)
 {}
 
 inline FileDecryptor &FileDecryptor::operator=(FileDecryptor &&other) noexcept
 {
   if (this != &other)
   {
+    // stop decoding (both ours and other's, whose tasks are bound to other)
+    // before any member the workers use is replaced or moved
+    stopDecoding();
+    other.stopDecoding();
+
     CryptBase::operator=(std::move(other));
     d_filename = std::move(other.d_filename);
     d_editattachments = std::move(other.d_editattachments);
@@ -139,14 +249,35 @@ inline FileDecryptor &FileDecryptor::operator=(FileDecryptor &&other) noexcept
     d_framecount = other.d_framecount;
     d_filesize = other.d_filesize;
     d_backupfileversion = other.d_backupfileversion;
+    d_mappedfile = std::move(other.d_mappedfile);
+    d_mappos = other.d_mappos;
+    d_framebuffer = std::move(other.d_framebuffer);
+    d_framebuffer_size = other.d_framebuffer_size;
+    d_frameindex = std::move(other.d_frameindex);
+    d_frameindexpos = other.d_frameindexpos;
+    d_frameindexloaded = other.d_frameindexloaded;
+    d_recordframeindex = other.d_recordframeindex;
+    d_threads = other.d_threads;
     d_badmac = other.d_badmac;
     d_assumebadframesize = other.d_assumebadframesize;
     d_stoponerror = other.d_stoponerror;
+    d_scandone = other.d_scandone;
     d_ok = other.d_ok;
   }
   return *this;
 }
 
+// discards the frames queued for decoding and joins the workers. The frames
+// were already read from file, so reading can not continue after this
+inline FileDecryptor &FileDecryptor::stopDecoding()
+{
+  if (!d_pendingframes.empty())
+    d_scandone = true;
+  d_pendingframes.clear();
+  d_threadpool.reset();
+  return *this;
+}
+
 inline uint64_t FileDecryptor::total() const
 {
   return d_filesize;
@@ -157,6 +288,55 @@ inline bool FileDecryptor::badMac() const
   return d_badmac;
 }
 
+inline void FileDecryptor::setThreads(unsigned int threads)
+{
+  d_threads = threads ? threads : 1;
+}
+
+// when set, the position of every frame read is kept, to be written
+// out with saveFrameIndex() when the entire file has been read
+inline void FileDecryptor::recordFrameIndex(bool record)
+{
+  d_recordframeindex = record;
+}
+
+// called when the loaded frame index turns out not to match the backup file,
+// the rest of the file is then read as if there never was an index
+inline void FileDecryptor::dropFrameIndex()
+{
+  Logger::warning("Frame index does not match backup file, ignoring it");
+  d_frameindexloaded = false;
+  d_frameindex.clear();
+}
+
+// the position of the next frame in the backup file. When reading from a
+// mapped file, the stream is not used (nor moved) at all
+inline uint64_t FileDecryptor::position(std::ifstream &file) const
+{
+  if (d_mappedfile)
+    return d_mappos;
+  return file.tellg();
+}
+
+// returns the next 'length' bytes of the backup file and advances the read
+// position. From a mapped file, this points into the mapping, otherwise the data
+// is read into 'buffer' (which must hold 'length' bytes). Returns nullptr when
+// not enough data is available
+inline unsigned char const *FileDecryptor::nextBytes(std::ifstream &file, uint32_t length, unsigned char *buffer)
+{
+  if (d_mappedfile)
+  {
+    if (d_mappos + length > d_filesize) [[unlikely]]
+      return nullptr;
+    unsigned char const *data = d_mappedfile->data() + d_mappos;
+    d_mappos += length;
+    return data;
+  }
+  if (!getNextFrameBlock(file, buffer, length)) [[unlikely]]
+    return nullptr;
+  return buffer;
+}
+
 // only used by getFrameOld(), used in older backups where frame length was not encrypted
 inline uint32_t FileDecryptor::getNextFrameBlockSize(std::ifstream &file)
 {
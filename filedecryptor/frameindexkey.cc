@@ -0,0 +1,51 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "filedecryptor.ih"
+
+#include <openssl/evp.h>
+
+// The frame index is only valid for the exact backup file it was created from.
+// The key is a SHA-256 over the (unencrypted) header frame, which contains the
+// random salt and iv of this backup, and the size of the file.
+bool FileDecryptor::frameIndexKey(unsigned char *key) const
+{
+  std::ifstream file(d_filename, std::ios_base::binary | std::ios_base::in);
+  if (!file.is_open()) [[unlikely]]
+    return false;
+
+  unsigned char headersize[4];
+  if (!file.read(reinterpret_cast<char *>(headersize), 4)) [[unlikely]]
+    return false;
+  uint32_t headerlength = fourBytesToUint(headersize);
+  if (headerlength < 2 || headerlength > 10240) [[unlikely]]
+    return false;
+  std::unique_ptr<unsigned char[]> header(new unsigned char[headerlength]);
+  if (!file.read(reinterpret_cast<char *>(header.get()), headerlength)) [[unlikely]]
+    return false;
+
+  std::unique_ptr<EVP_MD_CTX, decltype(&::EVP_MD_CTX_free)> mdctx(EVP_MD_CTX_new(), &::EVP_MD_CTX_free);
+  unsigned int keysize = 0;
+  return mdctx &&
+    EVP_DigestInit_ex(mdctx.get(), EVP_sha256(), nullptr) == 1 &&
+    EVP_DigestUpdate(mdctx.get(), headersize, 4) == 1 &&
+    EVP_DigestUpdate(mdctx.get(), header.get(), headerlength) == 1 &&
+    EVP_DigestUpdate(mdctx.get(), &d_filesize, sizeof(decltype(d_filesize))) == 1 &&
+    EVP_DigestFinal_ex(mdctx.get(), key, &keysize) == 1;
+}
@@ -21,53 +21,53 @@
 
 #include "../invalidframe/invalidframe.h"
 
+// Reads the next frame from the backup file. The same code is used when reading
+// from a stream and from a memory mapped file (--mmap), only the source of the
+// bytes differs (see nextBytes()). When mapped, the encrypted data is verified
+// and decrypted straight from the mapping.
 std::unique_ptr<BackupFrame> FileDecryptor::getFrame(std::ifstream &file)
 {
   if (d_backupfileversion == 0) [[unlikely]]
     return getFrameOld(file);
 
-  unsigned long long int filepos = file.tellg();
+  if (d_threads > 1)
+    return getFrameThreaded(file);
+
+  uint64_t filepos = position(file);
 
   if (d_verbose) [[unlikely]]
     Logger::message("Getting frame at filepos: ", filepos, " (COUNTER: ", d_counter, ")");
 
-  if (static_cast<uint64_t>(filepos) == d_filesize) [[unlikely]]
+  if (filepos == d_filesize) [[unlikely]]
   {
     if (d_verbose) [[unlikely]]
       Logger::message("Read entire backup file...");
+    if (d_mappedfile) // from here on, the mapping is only used to get attachment data
+      d_mappedfile->advise(MappedFile::Access::RANDOM);
     return std::unique_ptr<BackupFrame>(nullptr);
   }
 
   if (d_headerframe) [[unlikely]]
   {
-    file.seekg(4 + d_headerframe->dataSize());
+    if (d_mappedfile)
+      d_mappos = 4 + d_headerframe->dataSize();
+    else
+      file.seekg(4 + d_headerframe->dataSize());
     return std::unique_ptr<BackupFrame>(d_headerframe.release());
   }
 
-  uint32_t encrypted_encryptedframelength = 0;
-  if (!file.read(reinterpret_cast<char *>(&encrypted_encryptedframelength), sizeof(decltype(encrypted_encryptedframelength)))) [[unlikely]]
+  unsigned char encrypted_encryptedframelength_buffer[sizeof(uint32_t)];
+  unsigned char const *encrypted_encryptedframelength = nextBytes(file, sizeof(uint32_t), encrypted_encryptedframelength_buffer);
+  if (!encrypted_encryptedframelength) [[unlikely]]
   {
-    Logger::error("Failed to read ", sizeof(decltype(encrypted_encryptedframelength)),
-                  " bytes from file to get next frame size... (", file.tellg(),
+    Logger::error("Failed to read ", sizeof(uint32_t), " bytes from file to get next frame size... (", filepos,
                   " / ", d_filesize, ")");
     return std::unique_ptr<BackupFrame>(nullptr);
   }
 
   // set up context for calculating MAC
-#if OPENSSL_VERSION_NUMBER >= 0x30000000L
-  std::unique_ptr<EVP_MAC, decltype(&::EVP_MAC_free)> mac(EVP_MAC_fetch(nullptr, "hmac", nullptr), &::EVP_MAC_free);
-  std::unique_ptr<EVP_MAC_CTX, decltype(&::EVP_MAC_CTX_free)> hctx(EVP_MAC_CTX_new(mac.get()), &::EVP_MAC_CTX_free);
-  char digest[] = "SHA256";
-  OSSL_PARAM params[] = {OSSL_PARAM_construct_utf8_string("digest", digest, 0), OSSL_PARAM_construct_end()};
-#else
-  std::unique_ptr<HMAC_CTX, decltype(&::HMAC_CTX_free)> hctx(HMAC_CTX_new(), &::HMAC_CTX_free);
-#endif
-
-#if OPENSSL_VERSION_NUMBER >= 0x30000000L
-  if (EVP_MAC_init(hctx.get(), d_mackey, d_mackey_size, params) != 1) [[unlikely]]
-#else
-  if (HMAC_Init_ex(hctx.get(), d_mackey, d_mackey_size, EVP_sha256(), nullptr) != 1) [[unlikely]]
-#endif
+  CryptContext::HmacCtx hctx(d_cryptcontext->hmac());
+  if (!hctx) [[unlikely]]
   {
     Logger::error("Failed to initialize HMAC context");
     return std::unique_ptr<BackupFrame>(nullptr);
@@ -75,9 +75,9 @@ std::unique_ptr<BackupFrame> FileDecryptor::getFrame(std::ifstream &file)
 
   // update MAC with frame length
 #if OPENSSL_VERSION_NUMBER >= 0x30000000L
-  if (EVP_MAC_update(hctx.get(), reinterpret_cast<unsigned char *>(&encrypted_encryptedframelength), sizeof(decltype(encrypted_encryptedframelength))) != 1) [[unlikely]]
+  if (EVP_MAC_update(hctx.get(), encrypted_encryptedframelength, sizeof(uint32_t)) != 1) [[unlikely]]
 #else
-  if (HMAC_Update(hctx.get(), reinterpret_cast<unsigned char *>(&encrypted_encryptedframelength), sizeof(decltype(encrypted_encryptedframelength))) != 1) [[unlikely]]
+  if (HMAC_Update(hctx.get(), encrypted_encryptedframelength, sizeof(uint32_t)) != 1) [[unlikely]]
 #endif
   {
     Logger::error("Failed to update HMAC");
@@ -85,27 +85,24 @@ std::unique_ptr<BackupFrame> FileDecryptor::getFrame(std::ifstream &file)
   }
 
   // decrypt encrypted_encryptedframelength
+  uint64_t const framecounter = d_counter;
   uintToFourBytes(d_iv, d_counter++);
 
   // create context
-  std::unique_ptr<EVP_CIPHER_CTX, decltype(&::EVP_CIPHER_CTX_free)> ctx(EVP_CIPHER_CTX_new(), &::EVP_CIPHER_CTX_free);
-  // disable padding
-  EVP_CIPHER_CTX_set_padding(ctx.get(), 0);
-
-  if (EVP_DecryptInit_ex(ctx.get(), EVP_aes_256_ctr(), nullptr, d_cipherkey, d_iv) != 1) [[unlikely]]
+  CryptContext::CipherCtx ctx(d_cryptcontext->cipher(d_iv));
+  if (!ctx) [[unlikely]]
   {
     Logger::error("CTX INIT FAILED");
-    return nullptr;
+    return std::unique_ptr<BackupFrame>(nullptr);
   }
 
   uint32_t encryptedframelength = 0;
   int encryptedframelength_size = sizeof(decltype(encryptedframelength));
   if (EVP_DecryptUpdate(ctx.get(), reinterpret_cast<unsigned char *>(&encryptedframelength), &encryptedframelength_size,
-                        reinterpret_cast<unsigned char *>(&encrypted_encryptedframelength),
-                        sizeof(decltype(encrypted_encryptedframelength))) != 1) [[unlikely]]
+                        encrypted_encryptedframelength, sizeof(uint32_t)) != 1) [[unlikely]]
   {
     Logger::error("Failed to decrypt data");
-    return nullptr;
+    return std::unique_ptr<BackupFrame>(nullptr);
   }
 
   encryptedframelength = bepaald::swap_endian<uint32_t>(encryptedframelength);
@@ -122,44 +119,35 @@ std::unique_ptr<BackupFrame> FileDecryptor::getFrame(std::ifstream &file)
     return std::unique_ptr<BackupFrame>(nullptr);
   }
 
-  // read in the encrypted frame data
-  std::unique_ptr<unsigned char[]> encryptedframe(new unsigned char[encryptedframelength]);
-
-  if (!getNextFrameBlock(file, encryptedframe.get(), encryptedframelength)) [[unlikely]]
+  // get the encrypted frame data (only needs a buffer when not reading from the mapping)
+  std::unique_ptr<unsigned char[]> encryptedframe_buffer(d_mappedfile ? nullptr : new unsigned char[encryptedframelength]);
+  unsigned char const *encryptedframe = nextBytes(file, encryptedframelength, encryptedframe_buffer.get());
+  if (!encryptedframe) [[unlikely]]
   {
     Logger::error("Failed to read next frame (", encryptedframelength, " bytes at filepos ", filepos, ")");
     return std::unique_ptr<BackupFrame>(nullptr);
   }
 
-  // update MAC with read data
-#if OPENSSL_VERSION_NUMBER >= 0x30000000L
-  if (EVP_MAC_update(hctx.get(), encryptedframe.get(), encryptedframelength - MACSIZE) != 1) [[unlikely]]
-#else
-  if (HMAC_Update(hctx.get(), encryptedframe.get(), encryptedframelength - MACSIZE) != 1) [[unlikely]]
-#endif
-  {
-    Logger::error("Failed to update HMAC");
-    return std::unique_ptr<BackupFrame>(nullptr);
-  }
-
-  // finalize MAC
+  // update and finalize MAC
   unsigned char hash[SHA256_DIGEST_LENGTH];
 #if OPENSSL_VERSION_NUMBER >= 0x30000000L
-  if (EVP_MAC_final(hctx.get(), hash, nullptr, SHA256_DIGEST_LENGTH) != 1) [[unlikely]]
+  if (EVP_MAC_update(hctx.get(), encryptedframe, encryptedframelength - MACSIZE) != 1 ||
+      EVP_MAC_final(hctx.get(), hash, nullptr, SHA256_DIGEST_LENGTH) != 1) [[unlikely]]
 #else
   unsigned int digest_size = SHA256_DIGEST_LENGTH;
-  if (HMAC_Final(hctx.get(), hash, &digest_size) != 1) [[unlikely]]
+  if (HMAC_Update(hctx.get(), encryptedframe, encryptedframelength - MACSIZE) != 1 ||
+      HMAC_Final(hctx.get(), hash, &digest_size) != 1) [[unlikely]]
 #endif
   {
-    Logger::error("Failed to finalize MAC");
+    Logger::error("Failed to update/finalize MAC");
     return std::unique_ptr<BackupFrame>(nullptr);
   }
 
   // check MAC
-  if (std::memcmp(encryptedframe.get() + (encryptedframelength - MACSIZE), hash, 10) != 0) [[unlikely]]
+  if (std::memcmp(encryptedframe + (encryptedframelength - MACSIZE), hash, MACSIZE) != 0) [[unlikely]]
   {
     Logger::message("\n");
-    Logger::warning("Bad MAC in frame: theirMac: ", bepaald::bytesToHexString(encryptedframe.get() + (encryptedframelength - MACSIZE), MACSIZE),
+    Logger::warning("Bad MAC in frame: theirMac: ", bepaald::bytesToHexString(encryptedframe + (encryptedframelength - MACSIZE), MACSIZE),
                     "\n                              ourMac: ", bepaald::bytesToHexString(hash, SHA256_DIGEST_LENGTH));
 
     if (d_framecount == 1) [[unlikely]]
@@ -172,22 +160,26 @@ std::unique_ptr<BackupFrame> FileDecryptor::getFrame(std::ifstream &file)
   if (d_verbose) [[unlikely]]
   {
     Logger::message("Calculated mac: ", bepaald::bytesToHexString(hash, SHA256_DIGEST_LENGTH));
-    Logger::message("Mac in file   : ", bepaald::bytesToHexString(encryptedframe.get() + (encryptedframelength - MACSIZE), MACSIZE));
+    Logger::message("Mac in file   : ", bepaald::bytesToHexString(encryptedframe + (encryptedframelength - MACSIZE), MACSIZE));
   }
 
-  // decode frame data
+  // decode frame data, into a buffer that is reused for every frame
   int decodedframelength = encryptedframelength - MACSIZE;
-  std::unique_ptr<unsigned char[]> decodedframe(new unsigned char[decodedframelength]);
+  if (d_framebuffer_size < encryptedframelength) [[unlikely]]
+  {
+    d_framebuffer.reset(new unsigned char[encryptedframelength]);
+    d_framebuffer_size = encryptedframelength;
+  }
 
-  if (EVP_DecryptUpdate(ctx.get(), decodedframe.get(), &decodedframelength, encryptedframe.get(), encryptedframelength - MACSIZE) != 1) [[unlikely]]
+  if (EVP_DecryptUpdate(ctx.get(), d_framebuffer.get(), &decodedframelength, encryptedframe, encryptedframelength - MACSIZE) != 1) [[unlikely]]
   {
     Logger::error("Failed to decrypt data");
     return std::unique_ptr<BackupFrame>(nullptr);
   }
 
-  encryptedframe.reset(); // dont need this anymore, lets reclaim the memory....
+  encryptedframe_buffer.reset(); // dont need this anymore, lets reclaim the memory....
 
-  std::unique_ptr<BackupFrame> frame(initBackupFrame(decodedframe.get(), decodedframelength, d_framecount++));
+  std::unique_ptr<BackupFrame> frame(initBackupFrame(d_framebuffer.get(), decodedframelength, d_framecount++));
 
   /*
     This was originally used to work around a short-lived bug in Signal (#9154).
@@ -221,7 +213,7 @@ std::unique_ptr<BackupFrame> FileDecryptor::getFrame(std::ifstream &file)
     else
     {
       Logger::error_indent("Data was verified ok, but does not represent a valid frame... Don't know what happened, but it's bad... :(");
-      Logger::error_indent("Decrypted frame data: ", bepaald::bytesToHexString(decodedframe.get(), decodedframelength));
+      Logger::error_indent("Decrypted frame data: ", bepaald::bytesToHexString(d_framebuffer.get(), decodedframelength));
       return std::make_unique<InvalidFrame>();
     }
     return std::unique_ptr<BackupFrame>(nullptr);
@@ -243,7 +235,7 @@ std::unique_ptr<BackupFrame> FileDecryptor::getFrame(std::ifstream &file)
        frame->frameType() == BackupFrame::FRAMETYPE::STICKER))
   {
 
-    if ((file.tellg() < 0 && file.eof()) || (attsize + static_cast<uint64_t>(file.tellg()) > d_filesize)) [[unlikely]]
+    if ((!d_mappedfile && file.tellg() < 0 && file.eof()) || (attsize + position(file) > d_filesize)) [[unlikely]]
     {
       /* needed for #9154 */
       //if (!d_assumebadframesize)
@@ -258,11 +250,17 @@ std::unique_ptr<BackupFrame> FileDecryptor::getFrame(std::ifstream &file)
     reinterpret_cast<FrameWithAttachment *>(frame.get())->setReader(new AndroidAttachmentReader(d_iv, d_iv_size,
                                                                                                 d_mackey, d_mackey_size,
                                                                                                 d_cipherkey, d_cipherkey_size,
-                                                                                                attsize, d_filename, file.tellg()));
+                                                                                                d_cryptcontext,
+                                                                                                attsize, d_filename, position(file),
+                                                                                                d_mappedfile));
 
-    file.seekg(attsize + MACSIZE, std::ios_base::cur);
+    if (d_mappedfile)
+      d_mappos += attsize + MACSIZE;
+    else
+      file.seekg(attsize + MACSIZE, std::ios_base::cur);
   }
   //std::cout << "FILEPOS: " << file.tellg() << std::endl;
+  indexFrame(filepos, framecounter, encryptedframelength, frame->frameType(), frame.get());
   return frame;
 }
 
@@ -455,6 +453,7 @@ std::unique_ptr<BackupFrame> FileDecryptor::getFrameOld(std::ifstream &file)
     reinterpret_cast<FrameWithAttachment *>(frame.get())->setReader(new AndroidAttachmentReader(d_iv, d_iv_size,
                                                                                                 d_mackey, d_mackey_size,
                                                                                                 d_cipherkey, d_cipherkey_size,
+                                                                                                d_cryptcontext,
                                                                                                 attsize, d_filename, file.tellg()));
 
     file.seekg(attsize + MACSIZE, std::ios_base::cur);
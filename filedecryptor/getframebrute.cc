@@ -172,6 +172,7 @@ std::unique_ptr<BackupFrame> FileDecryptor::getFrameBrute(std::ifstream &file, u
     reinterpret_cast<FrameWithAttachment *>(frame.get())->setReader(new AndroidAttachmentReader(d_iv, d_iv_size,
                                                                                                 d_mackey, d_mackey_size,
                                                                                                 d_cipherkey, d_cipherkey_size,
+                                                                                                d_cryptcontext,
                                                                                                 attsize, d_filename, file.tellg()));
 
     file.seekg(attsize + MACSIZE, std::ios_base::cur);
@@ -0,0 +1,94 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "filedecryptor.ih"
+
+#include "../invalidframe/invalidframe.h"
+
+// Same as getFrame(), but the MAC verification, decryption and parsing of frames
+// is done by a pool of worker threads. The calling thread reads ahead a number of
+// frames from file, and the decoded frames are returned in file order.
+std::unique_ptr<BackupFrame> FileDecryptor::getFrameThreaded(std::ifstream &file)
+{
+  if (d_headerframe) [[unlikely]]
+  {
+    if (d_mappedfile)
+      d_mappos = 4 + d_headerframe->dataSize();
+    else
+      file.seekg(4 + d_headerframe->dataSize());
+    return std::unique_ptr<BackupFrame>(d_headerframe.release());
+  }
+
+  if (!d_threadpool) [[unlikely]]
+  {
+    d_threadpool.reset(new ThreadPool(d_threads));
+    if (d_verbose) [[unlikely]]
+      Logger::message("Decoding frames using ", d_threads, " threads");
+  }
+
+  // keep the workers busy, but limit the number of frames in memory
+  unsigned int const readahead = d_threads * 64;
+  while (!d_scandone && d_pendingframes.size() < readahead)
+    if (!scanFrame(file))
+      d_scandone = true;
+
+  if (d_pendingframes.empty())
+  {
+    if (d_verbose && position(file) == d_filesize) [[unlikely]]
+      Logger::message("Read entire backup file...");
+    return std::unique_ptr<BackupFrame>(nullptr);
+  }
+
+  DecodedFrame df = d_pendingframes.front().get();
+  d_pendingframes.pop_front();
+
+  switch (df.status)
+  {
+    case DecodeStatus::OK: [[likely]]
+      return std::move(df.frame);
+    case DecodeStatus::BADMAC:
+    {
+      Logger::message("\n");
+      Logger::warning(df.info);
+      if (df.framenumber == 1) [[unlikely]] // d_framecount has been advanced by the read-ahead
+        Logger::message(Logger::Control::BOLD, " *** NOTE : IT IS LIKELY AN INCORRECT PASSPHRASE WAS PROVIDED ***", Logger::Control::NORMAL);
+      d_badmac = true;
+      break;
+    }
+    case DecodeStatus::INVALID:
+    {
+      Logger::error("Failed to get valid frame from decoded data...");
+      Logger::error_indent("Data was verified ok, but does not represent a valid frame... Don't know what happened, but it's bad... :(");
+      Logger::error_indent("Decrypted frame data: ", df.info);
+      return std::make_unique<InvalidFrame>();
+    }
+    case DecodeStatus::ERROR:
+    {
+      if (!df.info.empty())
+        Logger::error(df.info);
+      break;
+    }
+  }
+
+  // a frame failed, stop reading. Any frames still pending
+  // are finished by the workers and discarded
+  d_scandone = true;
+  d_pendingframes.clear();
+  return std::unique_ptr<BackupFrame>(nullptr);
+}
@@ -0,0 +1,45 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "filedecryptor.ih"
+
+// Adds a frame to the frame index, if one is being recorded. When the decoded
+// frame is not (yet) available, only its type (as peeked from the first byte) is
+// stored. This is fine for all frames except those followed by attachment data.
+void FileDecryptor::indexFrame(uint64_t offset, uint64_t counter, uint32_t length, unsigned int type, BackupFrame const *frame)
+{
+  if (!d_recordframeindex) [[likely]]
+    return;
+
+  FrameIndexEntry entry{offset, counter, 0, 0, length, 0, type};
+  if (frame)
+  {
+    entry.type = frame->frameType();
+    if (entry.type == BackupFrame::FRAMETYPE::ATTACHMENT ||
+        entry.type == BackupFrame::FRAMETYPE::AVATAR ||
+        entry.type == BackupFrame::FRAMETYPE::STICKER)
+      entry.attachmentsize = frame->attachmentSize();
+    if (entry.type == BackupFrame::FRAMETYPE::ATTACHMENT)
+    {
+      entry.rowid = reinterpret_cast<AttachmentFrame const *>(frame)->rowId();
+      entry.uniqueid = reinterpret_cast<AttachmentFrame const *>(frame)->attachmentId();
+    }
+  }
+  d_frameindex.emplace_back(entry);
+}
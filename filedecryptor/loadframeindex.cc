@@ -0,0 +1,84 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "filedecryptor.ih"
+
+#include "../common_filesystem.h"
+
+// Reads a frame index as written by saveFrameIndex(). Returns false (and leaves
+// this FileDecryptor untouched) if there is no usable index for this backup file.
+bool FileDecryptor::loadFrameIndex(std::string const &indexfile)
+{
+  if (d_backupfileversion == 0 || !bepaald::fileOrDirExists(indexfile))
+    return false;
+
+  std::ifstream in(indexfile, std::ios_base::binary | std::ios_base::in);
+  if (!in.is_open()) [[unlikely]]
+    return false;
+
+  char magic[8];
+  uint32_t version = 0;
+  unsigned char filekey[SHA256_DIGEST_LENGTH];
+  uint64_t count = 0;
+  if (!in.read(magic, 8) || std::memcmp(magic, "SBTFRIDX", 8) != 0 ||
+      !in.read(reinterpret_cast<char *>(&version), sizeof(decltype(version))) || version != 1 ||
+      !in.read(reinterpret_cast<char *>(filekey), SHA256_DIGEST_LENGTH) ||
+      !in.read(reinterpret_cast<char *>(&count), sizeof(decltype(count)))) [[unlikely]]
+  {
+    Logger::warning("Ignoring frame index '", indexfile, "': not a (supported) frame index file");
+    return false;
+  }
+
+  unsigned char key[SHA256_DIGEST_LENGTH];
+  if (!frameIndexKey(key) || std::memcmp(key, filekey, SHA256_DIGEST_LENGTH) != 0)
+  {
+    Logger::warning("Ignoring frame index '", indexfile, "': it was created for a different backup file");
+    return false;
+  }
+
+  // every frame takes at least 4 + 11 bytes in the backup file
+  if (count > d_filesize / 15) [[unlikely]]
+  {
+    Logger::warning("Ignoring frame index '", indexfile, "': bad number of entries");
+    return false;
+  }
+
+  std::vector<FrameIndexEntry> frameindex(count);
+  for (auto &e : frameindex)
+  {
+    if (!in.read(reinterpret_cast<char *>(&e.offset), sizeof(decltype(e.offset))) ||
+        !in.read(reinterpret_cast<char *>(&e.counter), sizeof(decltype(e.counter))) ||
+        !in.read(reinterpret_cast<char *>(&e.rowid), sizeof(decltype(e.rowid))) ||
+        !in.read(reinterpret_cast<char *>(&e.uniqueid), sizeof(decltype(e.uniqueid))) ||
+        !in.read(reinterpret_cast<char *>(&e.length), sizeof(decltype(e.length))) ||
+        !in.read(reinterpret_cast<char *>(&e.attachmentsize), sizeof(decltype(e.attachmentsize))) ||
+        !in.read(reinterpret_cast<char *>(&e.type), sizeof(decltype(e.type)))) [[unlikely]]
+    {
+      Logger::warning("Ignoring frame index '", indexfile, "': file is truncated");
+      return false;
+    }
+  }
+
+  d_frameindex = std::move(frameindex);
+  d_frameindexpos = 0;
+  d_frameindexloaded = true;
+  if (d_verbose) [[unlikely]]
+    Logger::message("Loaded frame index (", count, " frames) from '", indexfile, "'");
+  return true;
+}
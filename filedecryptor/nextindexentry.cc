@@ -0,0 +1,39 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "filedecryptor.ih"
+
+// Returns the entry in the (loaded) frame index for the frame being read, after
+// checking it matches what was actually found in the file. On any mismatch, the
+// index is dropped and the file is read as if there never was one.
+FileDecryptor::FrameIndexEntry const *FileDecryptor::nextIndexEntry(uint64_t offset, uint64_t counter, uint32_t length)
+{
+  if (!d_frameindexloaded)
+    return nullptr;
+
+  if (d_frameindexpos < d_frameindex.size()) [[likely]]
+  {
+    FrameIndexEntry const *entry = &d_frameindex[d_frameindexpos++];
+    if (entry->offset == offset && entry->counter == counter && entry->length == length) [[likely]]
+      return entry;
+  }
+
+  dropFrameIndex();
+  return nullptr;
+}
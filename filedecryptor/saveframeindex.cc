@@ -0,0 +1,83 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "filedecryptor.ih"
+
+/*
+  Frame index file format (all numbers in native byte order):
+   - magic "SBTFRIDX"
+   - uint32_t format version, this doubles as a byte order check
+   - 32 byte key (see frameIndexKey())
+   - uint64_t number of entries
+   - per entry: offset, counter, rowid, uniqueid (uint64_t),
+                length, attachmentsize, type (uint32_t)
+*/
+bool FileDecryptor::saveFrameIndex(std::string const &indexfile) const
+{
+  if (d_backupfileversion == 0) // not supported for old format backups
+    return false;
+
+  // only a complete and verified index is useful
+  if (d_badmac || d_frameindex.empty() || d_frameindex.size() + 1 != d_framecount) [[unlikely]]
+  {
+    Logger::warning("Not writing frame index: backup file was not read completely");
+    return false;
+  }
+
+  unsigned char key[SHA256_DIGEST_LENGTH];
+  if (!frameIndexKey(key)) [[unlikely]]
+  {
+    Logger::warning("Failed to create frame index key");
+    return false;
+  }
+
+  std::ofstream out(indexfile, std::ios_base::binary | std::ios_base::trunc);
+  if (!out.is_open()) [[unlikely]]
+  {
+    Logger::warning("Failed to open frame index file '", indexfile, "' for writing");
+    return false;
+  }
+
+  uint32_t const version = 1;
+  uint64_t const count = d_frameindex.size();
+  out.write("SBTFRIDX", 8);
+  out.write(reinterpret_cast<char const *>(&version), sizeof(decltype(version)));
+  out.write(reinterpret_cast<char const *>(key), SHA256_DIGEST_LENGTH);
+  out.write(reinterpret_cast<char const *>(&count), sizeof(decltype(count)));
+  for (auto const &e : d_frameindex)
+  {
+    out.write(reinterpret_cast<char const *>(&e.offset), sizeof(decltype(e.offset)));
+    out.write(reinterpret_cast<char const *>(&e.counter), sizeof(decltype(e.counter)));
+    out.write(reinterpret_cast<char const *>(&e.rowid), sizeof(decltype(e.rowid)));
+    out.write(reinterpret_cast<char const *>(&e.uniqueid), sizeof(decltype(e.uniqueid)));
+    out.write(reinterpret_cast<char const *>(&e.length), sizeof(decltype(e.length)));
+    out.write(reinterpret_cast<char const *>(&e.attachmentsize), sizeof(decltype(e.attachmentsize)));
+    out.write(reinterpret_cast<char const *>(&e.type), sizeof(decltype(e.type)));
+  }
+
+  if (!out.good()) [[unlikely]]
+  {
+    Logger::warning("Failed to write frame index file '", indexfile, "'");
+    return false;
+  }
+
+  if (d_verbose) [[unlikely]]
+    Logger::message("Wrote frame index (", count, " frames) to '", indexfile, "'");
+  return true;
+}
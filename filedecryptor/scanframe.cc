@@ -0,0 +1,216 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "filedecryptor.ih"
+
+// Reads the next frame from file and queues it for decoding by the threadpool. Only
+// the frame length and the IV counter need to be processed in order. The exception
+// are frames that are followed by attachment data: we need to decode those here to
+// know how much data to skip (and to set up the AttachmentReader with the correct
+// counter). Returns false when no (more) frames are available.
+bool FileDecryptor::scanFrame(std::ifstream &file)
+{
+  uint64_t filepos = position(file);
+  if (filepos == d_filesize) [[unlikely]]
+  {
+    if (d_mappedfile) // from here on, the mapping is only used to get attachment data
+      d_mappedfile->advise(MappedFile::Access::RANDOM);
+    return false;
+  }
+
+  auto queueReady = [&](DecodedFrame &&df)
+  {
+    std::promise<DecodedFrame> p;
+    p.set_value(std::move(df));
+    d_pendingframes.emplace_back(p.get_future());
+  };
+
+  RawFrame raw;
+  unsigned char const *encryptedlength = nextBytes(file, sizeof(decltype(raw.encryptedlength)),
+                                                   reinterpret_cast<unsigned char *>(&raw.encryptedlength));
+  if (!encryptedlength) [[unlikely]]
+  {
+    Logger::error("Failed to read ", sizeof(decltype(raw.encryptedlength)),
+                  " bytes from file to get next frame size... (", filepos,
+                  " / ", d_filesize, ")");
+    return false;
+  }
+  if (d_mappedfile)
+    std::memcpy(&raw.encryptedlength, encryptedlength, sizeof(decltype(raw.encryptedlength)));
+
+  uint64_t const framecounter = d_counter;
+  uintToFourBytes(d_iv, d_counter++);
+  std::memcpy(raw.iv.data(), d_iv, std::min(static_cast<uint64_t>(raw.iv.size()), d_iv_size));
+
+  CryptContext::CipherCtx ctx(d_cryptcontext->cipher(raw.iv.data()));
+  if (!ctx) [[unlikely]]
+  {
+    Logger::error("CTX INIT FAILED");
+    return false;
+  }
+
+  int framelength_size = sizeof(decltype(raw.length));
+  if (EVP_DecryptUpdate(ctx.get(), reinterpret_cast<unsigned char *>(&raw.length), &framelength_size,
+                        reinterpret_cast<unsigned char *>(&raw.encryptedlength), sizeof(decltype(raw.encryptedlength))) != 1) [[unlikely]]
+  {
+    Logger::error("Failed to decrypt data");
+    return false;
+  }
+  raw.length = bepaald::swap_endian<uint32_t>(raw.length);
+  raw.framenumber = d_framecount++;
+
+  if (raw.length > 115343360 /*110MB*/ || raw.length < 11) [[unlikely]]
+  {
+    Logger::error("Failed to read next frame (", raw.length, " bytes at filepos ", filepos, ")");
+    if (raw.framenumber == 1)
+      Logger::message(Logger::Control::BOLD, " *** NOTE : IT IS LIKELY AN INCORRECT PASSPHRASE WAS PROVIDED ***", Logger::Control::NORMAL);
+    return false;
+  }
+
+  // the mapping outlives the pending frames, only copy the data when reading from the stream
+  if (!d_mappedfile)
+    raw.owneddata.reset(new unsigned char[raw.length]);
+  raw.data = nextBytes(file, raw.length, raw.owneddata.get());
+  if (!raw.data) [[unlikely]]
+  {
+    Logger::error("Failed to read next frame (", raw.length, " bytes at filepos ", filepos, ")");
+    return false;
+  }
+
+  // peek at the frame type: decrypt just the first byte (the keystream continues after the length)
+  unsigned char firstbyte = 0;
+  int firstbyte_size = 1;
+  if (EVP_DecryptUpdate(ctx.get(), &firstbyte, &firstbyte_size, raw.data, 1) != 1) [[unlikely]]
+  {
+    Logger::error("Failed to decrypt data");
+    return false;
+  }
+
+  int fieldnum = BackupFrame::getFieldnumber(firstbyte);
+  bool const hasattachment = (fieldnum == BackupFrame::FRAMETYPE::ATTACHMENT ||
+                              fieldnum == BackupFrame::FRAMETYPE::AVATAR ||
+                              fieldnum == BackupFrame::FRAMETYPE::STICKER);
+
+  // with a (matching) frame index, the size of any attachment data following
+  // this frame is already known, so the frame does not need to be decoded here.
+  // An entry saying no attachment data follows is only trusted for frame types
+  // that have none: a stale or corrupt index would otherwise make us read the
+  // next frame from the wrong offset
+  bool checkindexentry = false;
+  if (FrameIndexEntry const *entry = nextIndexEntry(filepos, framecounter, raw.length); entry)
+  {
+    uint32_t attsize = entry->attachmentsize;
+    if (entry->type != static_cast<unsigned int>(fieldnum) || (attsize > 0 && !hasattachment)) [[unlikely]]
+      dropFrameIndex();
+    else if (attsize == 0 && !hasattachment) [[likely]]
+    {
+      d_pendingframes.emplace_back(d_threadpool->submit([this, r = std::move(raw)]() { return decodeFrame(r); }));
+      return true;
+    }
+    else if (attsize == 0) // decoded below, to make sure it really has no attachment data
+      checkindexentry = true;
+    else
+    {
+      uint64_t attpos = position(file);
+      if (attsize + attpos > d_filesize) [[unlikely]]
+      {
+        Logger::error("Unexpectedly hit end of file while reading attachment!");
+        return false;
+      }
+
+      uintToFourBytes(d_iv, d_counter++);
+      std::array<unsigned char, 16> attiv;
+      std::memcpy(attiv.data(), d_iv, std::min(static_cast<uint64_t>(attiv.size()), d_iv_size));
+
+      d_pendingframes.emplace_back(d_threadpool->submit([this, r = std::move(raw), attiv, attsize, attpos]()
+      {
+        DecodedFrame df = decodeFrame(r);
+        if (df.status != DecodeStatus::OK) [[unlikely]]
+          return df;
+        if (df.frame->attachmentSize() != attsize) [[unlikely]]
+        {
+          df.status = DecodeStatus::ERROR;
+          df.info = "Frame index does not match backup file (unexpected attachment size)";
+          df.frame.reset();
+          return df;
+        }
+        reinterpret_cast<FrameWithAttachment *>(df.frame.get())->setReader(new AndroidAttachmentReader(attiv.data(), d_iv_size,
+                                                                                                       d_mackey, d_mackey_size,
+                                                                                                       d_cipherkey, d_cipherkey_size,
+                                                                                                       d_cryptcontext,
+                                                                                                       attsize, d_filename, attpos,
+                                                                                                       d_mappedfile));
+        return df;
+      }));
+
+      if (d_mappedfile)
+        d_mappos += attsize + MACSIZE;
+      else
+        file.seekg(attsize + MACSIZE, std::ios_base::cur);
+      return true;
+    }
+  }
+
+  if (!hasattachment) [[likely]]
+  {
+    indexFrame(filepos, framecounter, raw.length, fieldnum, nullptr);
+    d_pendingframes.emplace_back(d_threadpool->submit([this, r = std::move(raw)]() { return decodeFrame(r); }));
+    return true;
+  }
+
+  // frame has attachment data following it
+  DecodedFrame df = decodeFrame(raw);
+  if (df.status != DecodeStatus::OK) [[unlikely]]
+  {
+    queueReady(std::move(df));
+    return false; // can not determine position of next frame
+  }
+
+  indexFrame(filepos, framecounter, raw.length, fieldnum, df.frame.get());
+
+  uint32_t attsize = df.frame->attachmentSize();
+  if (attsize > 0)
+  {
+    if (checkindexentry) [[unlikely]] // the index said no attachment data follows this frame
+      dropFrameIndex();
+
+    if ((!d_mappedfile && file.tellg() < 0 && file.eof()) || (attsize + position(file) > d_filesize)) [[unlikely]]
+    {
+      Logger::error("Unexpectedly hit end of file while reading attachment!");
+      df.status = DecodeStatus::ERROR;
+      queueReady(std::move(df));
+      return false;
+    }
+
+    uintToFourBytes(d_iv, d_counter++);
+
+    reinterpret_cast<FrameWithAttachment *>(df.frame.get())->setReader(new AndroidAttachmentReader(d_iv, d_iv_size,
+                                                                                                   d_mackey, d_mackey_size,
+                                                                                                   d_cipherkey, d_cipherkey_size,
+                                                                                                   d_cryptcontext,
+                                                                                                   attsize, d_filename, position(file),
+                                                                                                   d_mappedfile));
+    if (d_mappedfile)
+      d_mappos += attsize + MACSIZE;
+    else
+      file.seekg(attsize + MACSIZE, std::ios_base::cur);
+  }
+  queueReady(std::move(df));
+  return true;
+}
@@ -0,0 +1,41 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "filedecryptor.ih"
+
+// Map the entire backup file into memory. Frames (and attachments) are then
+// read directly from the mapping, saving a copy and a read() call for every
+// frame. Returns false (and keeps using normal file reads) if mapping fails.
+bool FileDecryptor::useMappedInput()
+{
+  if (!d_ok || d_backupfileversion == 0) // old format backups are always read as a stream
+    return false;
+
+  std::shared_ptr<MappedFile> mappedfile(new MappedFile(d_filename));
+  if (!mappedfile->ok() || mappedfile->size() != d_filesize) [[unlikely]]
+  {
+    Logger::warning("Failed to map backup file into memory, falling back to regular reads");
+    return false;
+  }
+
+  // the first pass through the file is strictly sequential
+  mappedfile->advise(MappedFile::Access::SEQUENTIAL);
+  d_mappedfile = std::move(mappedfile);
+  return true;
+}
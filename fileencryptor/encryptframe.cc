@@ -37,21 +37,41 @@ std::pair<unsigned char *, uint64_t> FileEncryptor::encryptFrame(unsigned char *
     //return {nullptr, 0};
   }
 
-  // update iv:
-  uintToFourBytes(d_iv, d_counter++);
-
-  // encryption context
-  std::unique_ptr<EVP_CIPHER_CTX, decltype(&::EVP_CIPHER_CTX_free)> ctx(EVP_CIPHER_CTX_new(), &::EVP_CIPHER_CTX_free);
-
-  // disable padding
-  EVP_CIPHER_CTX_set_padding(ctx.get(), 0);
+  uint32_t length_data = bepaald::swap_endian<uint32_t>(length + MACSIZE);
+  if (d_verbose) [[unlikely]]
+  {
+    // in newer backup file versions, the length is encrypted
+    if (d_backupfileversion >= 1) [[likely]]
+      Logger::message_start("Encrypting frame. Length: ", length, ", +macsize: ", (length + MACSIZE), ", swap_endian: ", length_data, " -> ");
+    else [[unlikely]] // old backup file format, had RAW frame length
+      Logger::message("Writing raw framelength: ", length, ", +macsize: ", (length + MACSIZE), ", swap_endian: ", length_data);
+  }
 
-  if (EVP_EncryptInit_ex(ctx.get(), EVP_aes_256_ctr(), nullptr, d_cipherkey, d_iv) != 1)
+  std::pair<unsigned char *, uint64_t> encryptedframe = encryptFrame(data, length, nextIv());
+  if (!encryptedframe.first) [[unlikely]]
   {
-    Logger::error("CTX INIT FAILED");
+    Logger::error("Failed to encrypt frame");
     return {nullptr, 0};
   }
 
+  if (d_verbose && d_backupfileversion >= 1) [[unlikely]]
+    Logger::message_end(bepaald::bytesToHexString(encryptedframe.first, sizeof(uint32_t)));
+
+  return encryptedframe;
+}
+
+// encrypts the frame with the given iv (see nextIv()). Does not touch any
+// members, so any number of frames can be encrypted at the same time.
+std::pair<unsigned char *, uint64_t> FileEncryptor::encryptFrame(unsigned char const *data, uint64_t length, std::array<unsigned char, 16> const &iv) const
+{
+  if (!d_ok) [[unlikely]]
+    return {nullptr, 0};
+
+  // encryption context
+  CryptContext::CipherCtx ctx(d_cryptcontext->cipher(iv.data()));
+  if (!ctx) [[unlikely]]
+    return {nullptr, 0};
+
   std::unique_ptr<unsigned char[]> encryptedframe(new unsigned char[sizeof(uint32_t) + length + MACSIZE]);
 
   int encryptedframepos = 0;
@@ -60,46 +80,38 @@ std::pair<unsigned char *, uint64_t> FileEncryptor::encryptFrame(unsigned char *
   {
     int l = static_cast<int>(sizeof(uint32_t) + length);
     uint32_t length_data = bepaald::swap_endian<uint32_t>(length + MACSIZE);
-
-    if (d_verbose) [[unlikely]]
-      Logger::message_start("Encrypting frame. Length: ", length, ", +macsize: ", (length + MACSIZE), ", swap_endian: ", length_data, " -> ");
-
-    if (EVP_EncryptUpdate(ctx.get(), encryptedframe.get(), &l, reinterpret_cast<unsigned char *>(&length_data), sizeof(uint32_t)) != 1)
-    {
-      Logger::error("ENCRYPT FAILED");
+    if (EVP_EncryptUpdate(ctx.get(), encryptedframe.get(), &l, reinterpret_cast<unsigned char *>(&length_data), sizeof(uint32_t)) != 1) [[unlikely]]
       return {nullptr, 0};
-    }
     encryptedframepos = l;
-
-    if (d_verbose) [[unlikely]]
-      Logger::message_end(bepaald::bytesToHexString(encryptedframe.get(), sizeof(uint32_t)));
   }
   else [[unlikely]] // old backup file format, had RAW frame length
   {
     uint32_t rawlength = bepaald::swap_endian<uint32_t>(length + MACSIZE);
-    if (d_verbose) [[unlikely]]
-      Logger::message("Writing raw framelength: ", length, ", +macsize: ", (length + MACSIZE), ", swap_endian: ", rawlength);
     std::memcpy(encryptedframe.get(), reinterpret_cast<unsigned char *>(&rawlength), sizeof(uint32_t));
     encryptedframepos = 4;
   }
 
   int l = static_cast<int>(length);
-  if (EVP_EncryptUpdate(ctx.get(), encryptedframe.get() + encryptedframepos, &l, data, length) != 1)
-  {
-    Logger::error("ENCRYPT FAILED");
+  if (EVP_EncryptUpdate(ctx.get(), encryptedframe.get() + encryptedframepos, &l, data, length) != 1) [[unlikely]]
     return {nullptr, 0};
-  }
 
   // calc mac
-  unsigned int digest_size = SHA256_DIGEST_LENGTH;
   unsigned char hash[SHA256_DIGEST_LENGTH];
-  HMAC(EVP_sha256(), d_mackey, d_mackey_size,
-       encryptedframe.get() + (d_backupfileversion >= 1 ? 0 : sizeof(uint32_t)),
-       length + (d_backupfileversion >= 1 ? sizeof(uint32_t) : 0),
-       hash, &digest_size);
+  CryptContext::HmacCtx hctx(d_cryptcontext->hmac());
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  if (!hctx ||
+      EVP_MAC_update(hctx.get(), encryptedframe.get() + (d_backupfileversion >= 1 ? 0 : sizeof(uint32_t)),
+                     length + (d_backupfileversion >= 1 ? sizeof(uint32_t) : 0)) != 1 ||
+      EVP_MAC_final(hctx.get(), hash, nullptr, SHA256_DIGEST_LENGTH) != 1) [[unlikely]]
+#else
+  unsigned int digest_size = SHA256_DIGEST_LENGTH;
+  if (!hctx ||
+      HMAC_Update(hctx.get(), encryptedframe.get() + (d_backupfileversion >= 1 ? 0 : sizeof(uint32_t)),
+                  length + (d_backupfileversion >= 1 ? sizeof(uint32_t) : 0)) != 1 ||
+      HMAC_Final(hctx.get(), hash, &digest_size) != 1) [[unlikely]]
+#endif
+    return {nullptr, 0};
   std::memcpy(encryptedframe.get() + sizeof(uint32_t) + length, hash, 10);
 
-  //std::cout << "                                   : " << bepaald::bytesToHexString(hash, digest_size) << std::endl;
-
   return {encryptedframe.release(), sizeof(uint32_t) + length + MACSIZE};
 }
@@ -20,6 +20,8 @@
 #ifndef FILEENCRYPTOR_H_
 #define FILEENCRYPTOR_H_
 
+#include <algorithm>
+#include <array>
 #include <memory>
 #include <utility>
 
@@ -43,6 +45,12 @@ class FileEncryptor final : public CryptBase
   inline std::pair<unsigned char *, uint64_t> encryptFrame(std::pair<unsigned char *, uint64_t> const &data);
   std::pair<unsigned char *, uint64_t> encryptFrame(unsigned char *data, uint64_t length);
   std::pair<unsigned char *, uint64_t> encryptAttachment(unsigned char *data, uint64_t length);
+
+  // for encrypting frames in parallel: get the iv for each frame (in order),
+  // and encrypt with that.
+  inline std::array<unsigned char, 16> nextIv();
+  std::pair<unsigned char *, uint64_t> encryptFrame(unsigned char const *data, uint64_t length, std::array<unsigned char, 16> const &iv) const;
+  std::pair<unsigned char *, uint64_t> encryptAttachment(unsigned char const *data, uint64_t length, std::array<unsigned char, 16> const &iv) const;
 };
 
 inline FileEncryptor::FileEncryptor(FileEncryptor const &other)
@@ -99,4 +107,12 @@ inline std::pair<unsigned char *, uint64_t> FileEncryptor::encryptFrame(std::pai
   return encryptFrame(data.first.get(), data.second);
 }
 
+inline std::array<unsigned char, 16> FileEncryptor::nextIv()
+{
+  std::array<unsigned char, 16> iv{};
+  std::memcpy(iv.data(), d_iv, std::min(static_cast<uint64_t>(iv.size()), d_iv_size));
+  uintToFourBytes(iv.data(), d_counter++);
+  return iv;
+}
+
 #endif
@@ -0,0 +1,188 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FORKPOOL_H_
+#define FORKPOOL_H_
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#if !defined(_WIN32) && !defined(__MINGW64__)
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "../logger/logger.h"
+
+// Hands out a number of independent tasks (0...tasks-1) to worker processes.
+// Every worker is a fork() of the calling process, so it has its own copy of
+// all state (including any in-memory database), and nothing it changes is seen
+// by the other processes. The workers take the next task from a counter in
+// shared memory until none are left, and report back only through their exit
+// status (and whatever they write to disk).
+//
+//   ForkPool pool(workers, tasks);
+//   for (unsigned int i = pool.next(); i < tasks; i = pool.next())
+//     ...
+//   if (pool.isWorker())
+//     pool.exitWorker(true);
+//   if (pool.parallel() && !pool.wait())
+//     ...
+//
+// When only one worker is requested, there is only a single task, or on
+// platforms without fork(), no processes are created and next() simply
+// returns all tasks in order to the calling process.
+class ForkPool
+{
+  std::atomic<unsigned int> *d_next;
+#if !defined(_WIN32) && !defined(__MINGW64__)
+  std::vector<pid_t> d_workers;
+#endif
+  unsigned int d_tasks;
+  unsigned int d_serialnext;
+  bool d_isworker;
+
+ public:
+  inline ForkPool(unsigned int workers, unsigned int tasks);
+  ForkPool(ForkPool const &other) = delete;
+  ForkPool &operator=(ForkPool const &other) = delete;
+  inline ~ForkPool();
+  inline bool parallel() const;
+  inline bool isWorker() const;
+  inline unsigned int next();
+  inline bool wait();
+  [[noreturn]] inline void exitWorker(bool success);
+};
+
+inline ForkPool::ForkPool([[maybe_unused]] unsigned int workers, unsigned int tasks)
+  :
+  d_next(nullptr),
+  d_tasks(tasks),
+  d_serialnext(0),
+  d_isworker(false)
+{
+#if !defined(_WIN32) && !defined(__MINGW64__)
+  if (workers <= 1 || tasks <= 1)
+    return;
+
+  void *shared = mmap(nullptr, sizeof(std::atomic<unsigned int>), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (shared == MAP_FAILED) [[unlikely]]
+  {
+    Logger::warning("Failed to set up shared memory for worker processes, continuing single threaded");
+    return;
+  }
+  d_next = new (shared) std::atomic<unsigned int>(0);
+
+  // anything still buffered would otherwise be written once more by every worker
+  Logger::flush();
+
+  for (unsigned int i = 0; i < workers; ++i)
+  {
+    pid_t pid = fork();
+    if (pid == 0) // worker
+    {
+      d_workers.clear();
+      d_isworker = true;
+      return;
+    }
+    if (pid == -1) [[unlikely]]
+    {
+      Logger::warning("Failed to start worker process (", i + 1, "/", workers, ")");
+      break;
+    }
+    d_workers.push_back(pid);
+  }
+
+  if (d_workers.empty()) [[unlikely]] // fall back to doing all tasks ourselves
+  {
+    d_next->~atomic();
+    munmap(d_next, sizeof(std::atomic<unsigned int>));
+    d_next = nullptr;
+  }
+#endif
+}
+
+inline ForkPool::~ForkPool()
+{
+#if !defined(_WIN32) && !defined(__MINGW64__)
+  if (!d_isworker && !d_workers.empty()) [[unlikely]] // wait() was not called, don't leave zombies
+    wait();
+  if (d_next)
+    munmap(d_next, sizeof(std::atomic<unsigned int>));
+#endif
+}
+
+// tasks are being handled by worker processes
+inline bool ForkPool::parallel() const
+{
+  return d_next != nullptr;
+}
+
+inline bool ForkPool::isWorker() const
+{
+  return d_isworker;
+}
+
+// returns the index of the next task for this process to handle, a value
+// >= tasks means there is nothing left to do. In parallel mode, the main
+// process handles no tasks itself.
+inline unsigned int ForkPool::next()
+{
+  if (!d_next)
+    return d_serialnext++;
+  if (!d_isworker)
+    return d_tasks;
+  return d_next->fetch_add(1);
+}
+
+// (main process) waits for all workers to finish, returns true if they all
+// exited successfully
+inline bool ForkPool::wait()
+{
+  bool ok = true;
+#if !defined(_WIN32) && !defined(__MINGW64__)
+  for (pid_t pid : d_workers)
+  {
+    int status = 0;
+    if (waitpid(pid, &status, 0) == -1 ||
+        !WIFEXITED(status) || WEXITSTATUS(status) != 0) [[unlikely]]
+      ok = false;
+  }
+  d_workers.clear();
+#endif
+  return ok;
+}
+
+// ends a worker process, without running any destructors or exit handlers of
+// the (copied) state of the main process.
+inline void ForkPool::exitWorker(bool success)
+{
+  Logger::flush();
+#if !defined(_WIN32) && !defined(__MINGW64__)
+  _exit(success ? 0 : 1);
+#else
+  std::exit(success ? 0 : 1); // not reached, there are no workers
+#endif
+}
+
+#endif
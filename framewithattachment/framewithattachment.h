@@ -52,6 +52,7 @@ class FrameWithAttachment : public BackupFrame
   inline void setReader(BaseAttachmentReader *reader);
   inline BaseAttachmentReader *reader() const;
   inline virtual unsigned char *attachmentData(bool verbose, bool *badmac = nullptr);
+  inline BaseAttachmentReader::ReturnCode readAttachmentData(BaseAttachmentReader::Sink const &sink, bool verbose) const;
   inline void clearData();
 };
 
@@ -202,6 +203,21 @@ inline unsigned char *FrameWithAttachment::attachmentData(bool verbose, bool *ba
   return d_attachmentdata;
 }
 
+// passes the attachment data to sink in chunks. If the data is not already
+// in memory, it is streamed from the reader without storing it in this frame
+inline BaseAttachmentReader::ReturnCode FrameWithAttachment::readAttachmentData(BaseAttachmentReader::Sink const &sink, bool verbose) const
+{
+  if (d_attachmentdata)
+    return BaseAttachmentReader::sinkChunked(d_attachmentdata, d_attachmentdata_size, sink);
+
+  if (!d_attachmentreader) [[unlikely]]
+  {
+    Logger::error("Asked for attachment data, but no reader was set");
+    return BaseAttachmentReader::ReturnCode::ERROR;
+  }
+  return d_attachmentreader->readAttachment(sink, verbose);
+}
+
 inline void FrameWithAttachment::clearData()
 {
   if (d_noclear) [[unlikely]]
@@ -32,6 +32,7 @@
 #include <ctime>
 #include <algorithm>
 #include <set>
+#include <mutex>
 
 #if defined(_WIN32) || defined(__MINGW64__)
 #define WIN32_LEAN_AND_MEAN 1
@@ -84,6 +85,7 @@ class Logger
  private:
   std::set<std::string> d_warningsgiven;
   static std::unique_ptr<Logger> s_instance;
+  static std::recursive_mutex s_mutex; // the logger may be used from worker threads
   std::ofstream *d_file;
   std::ostringstream *d_strstreambackend;
   std::basic_ostream<std::ofstream::char_type, std::ofstream::traits_type> *d_currentoutput;
@@ -97,6 +99,7 @@ class Logger
  public:
   inline static void setFile(std::string const &f);
   inline static void setTimestamp(bool val);
+  inline static void flush();
 
   template <typename First, typename... Rest>
   inline static void message_overwrite(First const &f, Rest const &... r);
@@ -246,6 +249,7 @@ inline void Logger::messagePre() //static
 
 inline void Logger::setFile(std::string const &f) // static
 {
+  std::lock_guard<std::recursive_mutex> lock(s_mutex);
   //ensureLogger();
   if (s_instance->d_file)
     return;
@@ -261,14 +265,24 @@ inline void Logger::setFile(std::string const &f) // static
 
 inline void Logger::setTimestamp(bool val) // static
 {
+  std::lock_guard<std::recursive_mutex> lock(s_mutex);
   //ensureLogger();
   s_instance->d_usetimestamps = val;
   firstUse();
 }
 
+inline void Logger::flush() // static
+{
+  std::lock_guard<std::recursive_mutex> lock(s_mutex);
+  std::cout << std::flush;
+  if (s_instance->d_file)
+    (*s_instance->d_file) << std::flush;
+}
+
 template <typename First, typename... Rest>
 inline void Logger::message_overwrite(First const &f, Rest const &... r) // static
 {
+  std::lock_guard<std::recursive_mutex> lock(s_mutex);
   //ensureLogger();
   firstUse();
 
@@ -286,6 +300,7 @@ inline void Logger::message_overwrite(First const &f, Rest const &... r) // stat
 template <typename First, typename... Rest>
 inline void Logger::message(First const &f, Rest const &... r) // static
 {
+  std::lock_guard<std::recursive_mutex> lock(s_mutex);
   messagePre();
   //outputHead("[MESSAGE] ", "[MESSAGE] ");
   s_instance->outputHead("", false, {"", ": "});
@@ -295,6 +310,7 @@ inline void Logger::message(First const &f, Rest const &... r) // static
 template <typename First, typename... Rest>
 inline void Logger::message_start(First const &f, Rest const &... r) // static
 {
+  std::lock_guard<std::recursive_mutex> lock(s_mutex);
   messagePre();
   s_instance->d_dangling = true;
   //outputHead("[MESSAGE] ", "[MESSAGE] ");
@@ -304,12 +320,14 @@ inline void Logger::message_start(First const &f, Rest const &... r) // static
 
 inline void Logger::message_start() // static
 {
+  std::lock_guard<std::recursive_mutex> lock(s_mutex);
   message_start("");
 }
 
 template <typename First, typename... Rest>
 inline void Logger::message_continue(First const &f, Rest const &... r) // static
 {
+  std::lock_guard<std::recursive_mutex> lock(s_mutex);
   s_instance->outputHead("", false, {"", ": "});
   s_instance->outputMsg(Flags::NONEWLINE, f, r...);
 }
@@ -317,6 +335,7 @@ inline void Logger::message_continue(First const &f, Rest const &... r) // stati
 template <typename First, typename... Rest>
 inline void Logger::message_end(First const &f, Rest const &... r) // static
 {
+  std::lock_guard<std::recursive_mutex> lock(s_mutex);
   s_instance->d_dangling = false;
   s_instance->outputHead("", false, {"", ": "});
   s_instance->outputMsg(Flags::NONE, f, r...);
@@ -324,6 +343,7 @@ inline void Logger::message_end(First const &f, Rest const &... r) // static
 
 inline void Logger::message_end() // static
 {
+  std::lock_guard<std::recursive_mutex> lock(s_mutex);
   s_instance->d_dangling = false;
   message("");
 }
@@ -331,6 +351,7 @@ inline void Logger::message_end() // static
 template <typename First, typename... Rest>
 inline void Logger::warning(First const &f, Rest const &... r) // static
 {
+  std::lock_guard<std::recursive_mutex> lock(s_mutex);
   messagePre();
   //outputHead("[WARNING] ", "[\033[38;5;37mWARNING\033[0m] ");
   s_instance->outputHead("Warning", false, {"[", "]: "}, {"\033[1m", "\033[0m"});
@@ -340,6 +361,7 @@ inline void Logger::warning(First const &f, Rest const &... r) // static
 template <typename First, typename... Rest>
 inline void Logger::warning_start(First const &f, Rest const &... r) // static
 {
+  std::lock_guard<std::recursive_mutex> lock(s_mutex);
   messagePre();
   s_instance->outputHead("Warning", false, {"[", "]: "}, {"\033[1m", "\033[0m"});
   s_instance->outputMsg(Flags::NONEWLINE, f, r...);
@@ -348,6 +370,7 @@ inline void Logger::warning_start(First const &f, Rest const &... r) // static
 template <typename First, typename... Rest>
 inline void Logger::warning_indent(First const &f, Rest const &... r) // static
 {
+  std::lock_guard<std::recursive_mutex> lock(s_mutex);
   messagePre();
   s_instance->outputHead("       ", false, {" ", "   "});
   s_instance->outputMsg(Flags::NONE, f, r...);
@@ -356,6 +379,7 @@ inline void Logger::warning_indent(First const &f, Rest const &... r) // static
 template <typename First, typename... Rest>
 inline void Logger::error(First const &f, Rest const &... r) // static
 {
+  std::lock_guard<std::recursive_mutex> lock(s_mutex);
   messagePre();
   //outputHead("[ ERROR ] ", "[ \033[1;31mERROR\033[0m ] ");
   s_instance->outputHead("Error", false, {"[", "]: "}, {"\033[1m", "\033[0m"});
@@ -365,6 +389,7 @@ inline void Logger::error(First const &f, Rest const &... r) // static
 template <typename First, typename... Rest>
 inline void Logger::error_start(First const &f, Rest const &... r) // static
 {
+  std::lock_guard<std::recursive_mutex> lock(s_mutex);
   messagePre();
   s_instance->outputHead("Error", false, {"[", "]: "}, {"\033[1m", "\033[0m"});
   s_instance->outputMsg(Flags::NONEWLINE, f, r...);
@@ -373,6 +398,7 @@ inline void Logger::error_start(First const &f, Rest const &... r) // static
 template <typename First, typename... Rest>
 inline void Logger::error_indent(First const &f, Rest const &... r) // static
 {
+  std::lock_guard<std::recursive_mutex> lock(s_mutex);
   messagePre();
   s_instance->outputHead("     ", false, {" ", "   "});
   s_instance->outputMsg(Flags::NONE, f, r...);
@@ -381,6 +407,7 @@ inline void Logger::error_indent(First const &f, Rest const &... r) // static
 template <typename First, typename... Rest>
 inline void Logger::output_indent(int indent, First const &f, Rest const &... r) // static
 {
+  std::lock_guard<std::recursive_mutex> lock(s_mutex);
   messagePre();
   s_instance->outputHead(std::string(indent, ' '));
   s_instance->outputMsg(Flags::NONE, f, r...);
@@ -563,6 +590,7 @@ inline void Logger::outputMsg(Flags flags, Control c)
 
 inline void Logger::warnOnce(std::string const &w, bool error, std::string::size_type sub_id)
 {
+  std::lock_guard<std::recursive_mutex> lock(s_mutex);
   //ensureLogger();
   if (s_instance->d_warningsgiven.find(w.substr(0, sub_id)) == s_instance->d_warningsgiven.end())
   {
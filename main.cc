@@ -36,6 +36,8 @@
 #include "jsondatabase/jsondatabase.h"
 #include "dummybackup/dummybackup.h"
 #include "adbbackupdatabase/adbbackupdatabase.h"
+#include "cryptbase/cryptcontext.h"
+#include "scopeguard/scopeguard.h"
 
 #include "autoversion.h"
 
@@ -88,6 +90,17 @@ int main(int argc, char *argv[])
 
   SqliteDB::setConfigOptions();
 
+  // report the query profile on every exit path
+  if (!arg.profilequeries().empty())
+    SqliteDB::setProfiling(true);
+  ScopeGuard report_query_profile([&]()
+  {
+    if (arg.profilequeries().empty())
+      return;
+    SqliteDB::printQueryProfile(20);
+    SqliteDB::writeQueryProfile(arg.profilequeries());
+  });
+
   //**** OPTIONS THAT DO NOT REQUIRE SIGNAL BACKUP INPUT ****//
   std::unique_ptr<DesktopDatabase> ddb;
   std::unique_ptr<SignalPlaintextBackupDatabase> ptdb;
@@ -97,7 +110,8 @@ int main(int argc, char *argv[])
     if (!ddb)
       ddb.reset(new DesktopDatabase(arg.desktopdirs_1(), arg.desktopdirs_2(), arg.rawdesktopdb(), arg.desktopkey(),
                                     arg.verbose(), arg.ignorewal(), arg.desktopdbversion(), arg.truncate(),
-                                    arg.showdesktopkey(), arg.dbusverbose()));
+                                    arg.showdesktopkey(), arg.dbusverbose(),
+                                    static_cast<unsigned int>(std::max(arg.threads(), 0ll)), arg.lazydesktopdb()));
     return ddb->ok();
   };
 #if __cpp_lib_span >= 202002L && (!defined __apple_build_version__ || __apple_build_version__ >= 15000100)
@@ -206,11 +220,11 @@ int main(int argc, char *argv[])
 
     if (!arg.exportdesktophtml().empty())
       if (!dummydb.exportHtml(arg.exportdesktophtml(), {} /*limittothreads*/, arg.limittodates(), arg.split_by(),
-                              (arg.split_bool() ? arg.split() : -1), arg.setorigin(), arg.setselfid(),  arg.includecalllog(), arg.searchpage(),
+                              (arg.split_bool() ? arg.split() : -1), arg.setorigin(), arg.setselfid(),  arg.includecalllog(), arg.searchpage(), arg.shardedsearchindex(),
                               arg.stickerpacks(), arg.migratedb(), arg.overwrite(), arg.append(), arg.light(), arg.themeswitching(),
                               arg.addexportdetails(), arg.includeblockedlist(), arg.includefullcontactlist(), false /*arg.includesettings()*/,
                               arg.includereceipts(), arg.originalfilenames(), arg.linkify(), arg.chatfolders(), arg.compactfilenames(),
-                              arg.htmlpagemenu(), arg.aggressivefilenamesanitizing(), arg.excludeexpiring(), arg.htmlfocusend(),
+                              arg.htmlpagemenu(), arg.aggressivefilenamesanitizing(), arg.excludeexpiring(), arg.htmlfocusend(), arg.deduplicatemedia(),
                               arg.htmlignoremediatypes()))
         return 1;
 
@@ -241,11 +255,11 @@ int main(int argc, char *argv[])
       return 1;
 
     if (!dummydb.exportHtml(arg.exportplaintextbackuphtml().back(), {} /*limittothreads*/, arg.limittodates(), arg.split_by(),
-                            (arg.split_bool() ? arg.split() : -1), arg.setorigin(), arg.setselfid(), arg.includecalllog(), arg.searchpage(),
+                            (arg.split_bool() ? arg.split() : -1), arg.setorigin(), arg.setselfid(), arg.includecalllog(), arg.searchpage(), arg.shardedsearchindex(),
                             arg.stickerpacks(), arg.migratedb(), arg.overwrite(), arg.append(), arg.light(), arg.themeswitching(),
                             arg.addexportdetails(), arg.includeblockedlist(), arg.includefullcontactlist(), false /*arg.includesettings()*/,
                             arg.includereceipts(), arg.originalfilenames(), arg.linkify(), arg.chatfolders(), arg.compactfilenames(),
-                            arg.htmlpagemenu(), arg.aggressivefilenamesanitizing(), arg.excludeexpiring(), arg.htmlfocusend(),
+                            arg.htmlpagemenu(), arg.aggressivefilenamesanitizing(), arg.excludeexpiring(), arg.htmlfocusend(), arg.deduplicatemedia(),
                             arg.htmlignoremediatypes()))
       return 1;
   }
@@ -263,11 +277,11 @@ int main(int argc, char *argv[])
       return 1;
 
     if (!dummydb.exportHtml(arg.exportadbbackuptohtml_2(), {} /*limittothreads*/, arg.limittodates(), arg.split_by(),
-                            (arg.split_bool() ? arg.split() : -1), arg.setorigin(), arg.setselfid(), arg.includecalllog(), arg.searchpage(),
+                            (arg.split_bool() ? arg.split() : -1), arg.setorigin(), arg.setselfid(), arg.includecalllog(), arg.searchpage(), arg.shardedsearchindex(),
                             arg.stickerpacks(), arg.migratedb(), arg.overwrite(), arg.append(), arg.light(), arg.themeswitching(),
                             arg.addexportdetails(), arg.includeblockedlist(), arg.includefullcontactlist(), false /*arg.includesettings()*/,
                             arg.includereceipts(), arg.originalfilenames(), arg.linkify(), arg.chatfolders(), arg.compactfilenames(),
-                            arg.htmlpagemenu(), arg.aggressivefilenamesanitizing(), arg.excludeexpiring(), arg.htmlfocusend(),
+                            arg.htmlpagemenu(), arg.aggressivefilenamesanitizing(), arg.excludeexpiring(), arg.htmlfocusend(), arg.deduplicatemedia(),
                             arg.htmlignoremediatypes()))
       return 1;
   }
@@ -391,7 +405,9 @@ int main(int argc, char *argv[])
                                                     arg.truncate(), arg.showprogress(),
                                                     arg.replaceattachments_bool(), arg.assumebadframesizeonbadmac(),
                                                     arg.editattachmentsize(), arg.allowhugeattachments(),
-                                                    arg.stoponerror(), arg.fulldecode()));
+                                                    arg.stoponerror(), arg.fulldecode(),
+                                                    static_cast<unsigned int>(std::max(arg.threads(), 0ll)), arg.mmap(),
+                                                    arg.frameindex()));
   if (!sb->ok())
   {
     Logger::error("Failed to open backup");
@@ -609,7 +625,8 @@ int main(int argc, char *argv[])
 
   if (!arg.dumpmedia().empty())
     if (!sb->dumpMedia(arg.dumpmedia(), arg.limittodates(), limittothreads, arg.onlylargerthan(), arg.onlysmallerthan(),
-                       arg.excludestickers(), arg.excludequotes(), arg.aggressivefilenamesanitizing(),  arg.overwrite()))
+                       arg.excludestickers(), arg.excludequotes(), arg.aggressivefilenamesanitizing(),  arg.overwrite(),
+                       arg.deduplicatemedia()))
       return 1;
 
   if (!arg.dumpavatars().empty())
@@ -668,11 +685,11 @@ int main(int argc, char *argv[])
 
   if (!arg.exporthtml().empty())
     if (!sb->exportHtml(arg.exporthtml(), limittothreads, arg.limittodates(), arg.split_by(), (arg.split_bool() ? arg.split() : -1),
-                        arg.setorigin(), arg.setselfid(), arg.includecalllog(), arg.searchpage(), arg.stickerpacks(), arg.migratedb(),
+                        arg.setorigin(), arg.setselfid(), arg.includecalllog(), arg.searchpage(), arg.shardedsearchindex(), arg.stickerpacks(), arg.migratedb(),
                         arg.overwrite(), arg.append(), arg.light(), arg.themeswitching(), arg.addexportdetails(), arg.includeblockedlist(),
                         arg.includefullcontactlist(), arg.includesettings(), arg.includereceipts(), arg.originalfilenames(),
                         arg.linkify(), arg.chatfolders(), arg.compactfilenames(), arg.htmlpagemenu(), arg.aggressivefilenamesanitizing(),
-                        arg.excludeexpiring(), arg.htmlfocusend(), arg.htmlignoremediatypes()))
+                        arg.excludeexpiring(), arg.htmlfocusend(), arg.deduplicatemedia(), arg.htmlignoremediatypes()))
       return 1;
 
   if (!arg.exporttxt().empty())
@@ -785,7 +802,8 @@ int main(int argc, char *argv[])
   if (!arg.output().empty())
   {
     sb->checkDbIntegrityInternal(true /* warnonly */);
-    if (!sb->exportBackup(arg.output(), arg.opassphrase(), arg.overwrite(), SignalBackup::DROPATTACHMENTDATA, arg.onlydb()))
+    if (!sb->exportBackup(arg.output(), arg.opassphrase(), arg.overwrite(), SignalBackup::DROPATTACHMENTDATA, arg.onlydb(),
+                          arg.deduplicatemedia()))
     {
       Logger::error("Failed to export backup to '", arg.output(), "'");
       return 1;
@@ -794,6 +812,15 @@ int main(int argc, char *argv[])
 
   MEMINFO("After output");
 
+  if (arg.verbose()) [[unlikely]]
+  {
+    Logger::message("Reused cached crypto contexts ", CryptContext::fetchesAvoided(), " times");
+    SqliteDB::StatementCacheStats const &stmtstats = SqliteDB::statementCacheStats();
+    Logger::message("Prepared statement cache: ", stmtstats.hits.load(), " hits, ", stmtstats.misses.load(), " misses, ",
+                    stmtstats.evictions.load(), " evictions, ", stmtstats.preparetime_us.load() / 1000,
+                    "ms spent preparing statements (not counting --exporthtml worker processes)");
+  }
+
 #if defined(_WIN32) || defined(__MINGW64__)
   SetConsoleOutputCP(oldcodepage);
 #endif
@@ -0,0 +1,113 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAPPEDFILE_H_
+#define MAPPEDFILE_H_
+
+#include <cstdint>
+#include <string>
+
+#if !defined(_WIN32) && !defined(__MINGW64__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// A read-only memory mapping of an entire file. On platforms without mmap(), or
+// when the mapping fails (for example, a file too large for the address space),
+// ok() returns false and callers should fall back to regular file reads.
+class MappedFile
+{
+  unsigned char const *d_data;
+  uint64_t d_size;
+ public:
+  enum class Access
+  {
+    SEQUENTIAL,
+    RANDOM,
+  };
+
+  inline explicit MappedFile(std::string const &filename);
+  MappedFile(MappedFile const &other) = delete;
+  MappedFile &operator=(MappedFile const &other) = delete;
+  inline ~MappedFile();
+  inline bool ok() const;
+  inline unsigned char const *data() const;
+  inline uint64_t size() const;
+  inline void advise(Access access) const;
+};
+
+inline MappedFile::MappedFile([[maybe_unused]] std::string const &filename)
+  :
+  d_data(nullptr),
+  d_size(0)
+{
+#if !defined(_WIN32) && !defined(__MINGW64__)
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd == -1) [[unlikely]]
+    return;
+
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0 &&
+      static_cast<uint64_t>(st.st_size) <= static_cast<uint64_t>(SIZE_MAX))
+  {
+    void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED) [[likely]]
+    {
+      d_data = static_cast<unsigned char const *>(map);
+      d_size = st.st_size;
+    }
+  }
+  close(fd); // the mapping stays valid
+#endif
+}
+
+inline MappedFile::~MappedFile()
+{
+#if !defined(_WIN32) && !defined(__MINGW64__)
+  if (d_data)
+    munmap(const_cast<unsigned char *>(d_data), d_size);
+#endif
+}
+
+inline bool MappedFile::ok() const
+{
+  return d_data != nullptr;
+}
+
+inline unsigned char const *MappedFile::data() const
+{
+  return d_data;
+}
+
+inline uint64_t MappedFile::size() const
+{
+  return d_size;
+}
+
+inline void MappedFile::advise([[maybe_unused]] Access access) const
+{
+#if !defined(_WIN32) && !defined(__MINGW64__)
+  if (d_data)
+    madvise(const_cast<unsigned char *>(d_data), d_size, access == Access::SEQUENTIAL ? MADV_SEQUENTIAL : MADV_RANDOM);
+#endif
+}
+
+#endif
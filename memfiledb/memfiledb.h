@@ -1,5 +1,5 @@
 /*
-  Copyright (C) 2019-2025  Selwin van Dijk
+  Copyright (C) 2019-2026  Selwin van Dijk
 
   This file is part of signalbackup-tools.
 
@@ -28,16 +28,31 @@
 
 class MemFileDB
 {
+ public:
+  // A database that is not (completely) in memory: its data is requested through
+  // read() when sqlite needs it. The header (at least the first 100 bytes of the
+  // file) must be available in memory.
+  struct LazyData
+  {
+    std::pair<unsigned char *, uint64_t> header;
+    uint64_t size;
+    void *context;
+    bool (*read)(void *context, unsigned char *buffer, uint64_t size, uint64_t offset);
+  };
+
+ private:
   struct MemFile
   {
     sqlite3_file base; // Base class. Must be first.
     unsigned char *data;
     uint64_t datasize;
+    LazyData const *lazy;
   };
   static sqlite3_vfs s_memfilevfs;
   static char constexpr s_name[] = {'M', 'e', 'm', 'f', 'i', 'l', 'e', 'V', 'F', 'S', '\0'};
  public:
   static sqlite3_vfs *sqlite3_memfilevfs(std::pair<unsigned char *, uint64_t> *data);
+  static sqlite3_vfs *sqlite3_memfilevfs(LazyData *data);
   static char const *vfsName()
   {
     return s_name;
@@ -55,12 +70,17 @@ class MemFileDB
   static int ioFileControl(sqlite3_file *pFile, int op, void *pArg);
   static int ioSectorSize(sqlite3_file *pFile);
   static int ioDeviceCharacteristics(sqlite3_file *pFile);
+  static int ioFetch(sqlite3_file *pFile, sqlite_int64 iOfst, int iAmt, void **pp);
+  static int ioUnfetch(sqlite3_file *pFile, sqlite_int64 iOfst, void *p);
   static int open(sqlite3_vfs *pVfs, char const *zName, sqlite3_file *pFile, int flags, int *pOutFlags);
+  static int openLazy(sqlite3_vfs *pVfs, char const *zName, sqlite3_file *pFile, int flags, int *pOutFlags);
   static int del(sqlite3_vfs *pVfs, char const *zPath, int dirSync);
   static int access(sqlite3_vfs *pVfs, char const *zPath, int flags, int *pResOut);
+  static int accessLazy(sqlite3_vfs *pVfs, char const *zPath, int flags, int *pResOut);
   static int fullPathname(sqlite3_vfs *pVfs, char const *zPath, int nPathOut, char *zPathOut);
+  static sqlite3_vfs *setupVfs(void *appdata, decltype(sqlite3_vfs::xOpen) xopen, decltype(sqlite3_vfs::xAccess) xaccess);
 
-  static sqlite3_io_methods constexpr s_io = {1,                                     /* iVersion */
+  static sqlite3_io_methods constexpr s_io = {3,                                     /* iVersion */
                                               MemFileDB::ioClose,                    /* xClose */
                                               MemFileDB::ioRead,                     /* xRead */
                                               MemFileDB::ioWrite,                    /* xWrite */
@@ -74,15 +94,15 @@ class MemFileDB
                                               MemFileDB::ioSectorSize,               /* xSectorSize */
                                               MemFileDB::ioDeviceCharacteristics,    /* xDeviceCharacteristics */
 
-                                              /* since we specified iversion == 1 above, the next fields actually
-                                                 should not exist, but just to suppress gcc warnings....  */
+                                              /* the shared memory methods (iVersion 2) are only used in WAL-mode,
+                                                 which is never used for these (read-only) databases */
 
-                                              nullptr,     /* xShmMap */
-                                              nullptr,     /* xShmLock */
-                                              nullptr,     /* xShmBarrier */
-                                              nullptr,     /* xShmUnmap */
-                                              nullptr,     /* xFetch */
-                                              nullptr,     /* xUnfetch */};
+                                              nullptr,                            /* xShmMap */
+                                              nullptr,                            /* xShmLock */
+                                              nullptr,                            /* xShmBarrier */
+                                              nullptr,                            /* xShmUnmap */
+                                              MemFileDB::ioFetch,                 /* xFetch */
+                                              MemFileDB::ioUnfetch,               /* xUnfetch */};
 };
 
 inline int MemFileDB::ioClose(sqlite3_file *pFile [[maybe_unused]])
@@ -95,7 +115,7 @@ inline int MemFileDB::ioRead(sqlite3_file *pFile, void *zBuf, int iAmt, sqlite_i
 {
   //std::cout << "Called: " << __FUNCTION__ << std::endl;
   if (static_cast<uint64_t>(iOfst) >= reinterpret_cast<MemFile *>(pFile)->datasize ||
-      !reinterpret_cast<MemFile *>(pFile)->data)
+      (!reinterpret_cast<MemFile *>(pFile)->data && !reinterpret_cast<MemFile *>(pFile)->lazy))
   {
     //std::cout << " !!! ERROR_READ !!!" << std::endl;
     return SQLITE_IOERR_READ;
@@ -110,7 +130,14 @@ inline int MemFileDB::ioRead(sqlite3_file *pFile, void *zBuf, int iAmt, sqlite_i
     shortread = true;
   }
 
-  std::memcpy(zBuf, reinterpret_cast<MemFile *>(pFile)->data + iOfst, toread);
+  if (reinterpret_cast<MemFile *>(pFile)->lazy)
+  {
+    LazyData const *lazy = reinterpret_cast<MemFile *>(pFile)->lazy;
+    if (!lazy->read(lazy->context, static_cast<unsigned char *>(zBuf), toread, iOfst)) [[unlikely]]
+      return SQLITE_IOERR_READ;
+  }
+  else
+    std::memcpy(zBuf, reinterpret_cast<MemFile *>(pFile)->data + iOfst, toread);
 
   if (shortread)
     return SQLITE_IOERR_SHORT_READ;
@@ -183,6 +210,26 @@ inline int MemFileDB::ioDeviceCharacteristics(sqlite3_file *pFile [[maybe_unused
   return 0;
 }
 
+// memory mapped I/O (see `PRAGMA mmap_size'): hand out a pointer straight into
+// the data instead of copying the page in ioRead(). When the data is read
+// lazily, there is nothing to point to. Setting *pp to nullptr makes sqlite
+// fall back to ioRead().
+inline int MemFileDB::ioFetch(sqlite3_file *pFile, sqlite_int64 iOfst, int iAmt, void **pp)
+{
+  MemFile *p = reinterpret_cast<MemFile *>(pFile);
+  if (p->data && iOfst >= 0 && static_cast<uint64_t>(iOfst) + iAmt <= p->datasize) [[likely]]
+    *pp = p->data + iOfst;
+  else
+    *pp = nullptr;
+  return SQLITE_OK;
+}
+
+inline int MemFileDB::ioUnfetch(sqlite3_file *pFile [[maybe_unused]], sqlite_int64 iOfst [[maybe_unused]], void *p [[maybe_unused]])
+{
+  // the data is not actually mapped, nothing to release
+  return SQLITE_OK;
+}
+
 inline int MemFileDB::fullPathname(sqlite3_vfs *pVfs [[maybe_unused]],   /* VFS */
                                    char const *zPath [[maybe_unused]],   /* Input path (possibly a relative path) */
                                    int nPathOut [[maybe_unused]],        /* Size of output buffer in bytes */
@@ -217,6 +264,21 @@ inline int MemFileDB::open(sqlite3_vfs *pVfs,                        /* VFS */
   return SQLITE_OK;
 }
 
+inline int MemFileDB::openLazy(sqlite3_vfs *pVfs, char const *zName [[maybe_unused]], sqlite3_file *pFile,
+                               int flags [[maybe_unused]], int *pOutFlags)
+{
+  MemFile *p = reinterpret_cast<MemFile *>(pFile);
+  std::memset(p, 0, sizeof(MemFile));
+  if (pOutFlags)
+    *pOutFlags = flags | SQLITE_READONLY | SQLITE_OPEN_MEMORY;
+
+  p->base.pMethods = &s_io;
+  p->lazy = reinterpret_cast<LazyData const *>(pVfs->pAppData);
+  p->datasize = p->lazy->size;
+
+  return SQLITE_OK;
+}
+
 inline int MemFileDB::del(sqlite3_vfs *pVfs [[maybe_unused]], const char *zPath [[maybe_unused]], int dirSync [[maybe_unused]])
 {
   //std::cout << "Called: " << __FUNCTION__ << std::endl;
@@ -238,9 +300,30 @@ inline int MemFileDB::access(sqlite3_vfs *pVfs, char const *zPath [[maybe_unused
   return SQLITE_IOERR_ACCESS;
 }
 
+inline int MemFileDB::accessLazy(sqlite3_vfs *pVfs, char const *zPath [[maybe_unused]], int flags [[maybe_unused]], int *pResOut)
+{
+  if (reinterpret_cast<LazyData const *>(pVfs->pAppData)->read &&
+      reinterpret_cast<LazyData const *>(pVfs->pAppData)->size > 0)
+  {
+    *pResOut = 0;
+    return SQLITE_OK;
+  }
+  return SQLITE_IOERR_ACCESS;
+}
+
 inline sqlite3_vfs *MemFileDB::sqlite3_memfilevfs(std::pair<unsigned char *, uint64_t> *data)
 {
   //std::cout << "Called: " << __FUNCTION__ << std::endl;
+  return setupVfs(data, open, access);
+}
+
+inline sqlite3_vfs *MemFileDB::sqlite3_memfilevfs(LazyData *data)
+{
+  return setupVfs(data, openLazy, accessLazy);
+}
+
+inline sqlite3_vfs *MemFileDB::setupVfs(void *appdata, decltype(sqlite3_vfs::xOpen) xopen, decltype(sqlite3_vfs::xAccess) xaccess)
+{
   std::memset(&s_memfilevfs, 0, sizeof(s_memfilevfs));
 
   s_memfilevfs = {1,                     /* iVersion */
@@ -250,10 +333,10 @@ inline sqlite3_vfs *MemFileDB::sqlite3_memfilevfs(std::pair<unsigned char *, uin
                                                           (and other) suffix added by sqlite*/
                   0,                     /* pNext */
                   vfsName(),             /* zName */
-                  data,                  /* pAppData */
-                  open,                  /* xOpen */
+                  appdata,               /* pAppData */
+                  xopen,                 /* xOpen */
                   del,                   /* xDelete */
-                  access,                /* xAccess */
+                  xaccess,               /* xAccess */
                   fullPathname,          /* xFullPathname */
                   nullptr,               /* xDlOpen */
                   nullptr,               /* xDlError */
@@ -27,6 +27,7 @@ class MemSqliteDB final : public SqliteDB
  public:
   inline MemSqliteDB();
   inline explicit MemSqliteDB(std::pair<unsigned char *, uint64_t> *data);
+  inline explicit MemSqliteDB(MemFileDB::LazyData *data);
   ~MemSqliteDB() = default;
 };
 
@@ -42,7 +43,17 @@ inline MemSqliteDB::MemSqliteDB(std::pair<unsigned char *, uint64_t> *data)
   SqliteDB(data)
 {
   exec("PRAGMA synchronous = OFF");
+
+  // let sqlite read pages straight from the buffer (see MemFileDB::ioFetch()),
+  // the limit is capped by sqlite at SQLITE_MAX_MMAP_SIZE
+  exec("PRAGMA mmap_size = " + std::to_string(data->second));
 }
 
+inline MemSqliteDB::MemSqliteDB(MemFileDB::LazyData *data)
+  :
+  SqliteDB(data)
+{
+  exec("PRAGMA synchronous = OFF");
+}
 
 #endif
@@ -20,6 +20,7 @@
 #ifndef PROTOBUFPARSER_H_
 #define PROTOBUFPARSER_H_
 
+#include <array>
 #include <cstring>
 #include <memory>
 #include <vector>
@@ -36,6 +37,10 @@ class ProtoBufParser : public ProtoBufParserBase
 {
   template <typename... Spec2> friend class ProtoBufParser;
  private:
+  // position of the first occurrence of every field in Spec..., filled in a
+  // single pass on the first field access (see fieldOffset())
+  mutable std::array<unsigned int, sizeof...(Spec)> d_fieldoffsets{};
+
   template <bool viewonly, int idx>
   static inline auto constexpr getDeepType();
   template <bool viewonly, int idx, int idx2, int... rest>
@@ -84,6 +89,8 @@ class ProtoBufParser : public ProtoBufParserBase
   inline bool addFieldInternal(T const &value);
   template <int idx>
   static inline constexpr unsigned int getType();
+  template <int idx>
+  inline unsigned int fieldOffset() const;
 
   // printing this horrorshow...
   template<std::size_t N, typename Indices = std::make_index_sequence<N>>
@@ -129,9 +136,9 @@ template <int idx>
 inline auto ProtoBufParser<Spec...>::getField() const -> typename ProtoBufParserReturn::item_return<typename std::remove_reference<decltype(std::get<idx - 1>(std::tuple<Spec...>()))>::type, is_vector<typename std::remove_reference<decltype(std::get<idx - 1>(std::tuple<Spec...>()))>::type>{}>::type
 {
   if constexpr (!is_vector<typename std::remove_reference<decltype(std::get<idx - 1>(std::tuple<Spec...>()))>::type>{})
-    return getFieldAs<typename std::remove_reference<decltype(std::get<idx - 1>(std::tuple<Spec...>()))>::type, false>(idx);
+    return getFieldAs<typename std::remove_reference<decltype(std::get<idx - 1>(std::tuple<Spec...>()))>::type, false>(idx, fieldOffset<idx>());
   else
-    return getFieldsAs<typename std::remove_reference<decltype(std::get<idx - 1>(std::tuple<Spec...>()))>::type, false>(idx);
+    return getFieldsAs<typename std::remove_reference<decltype(std::get<idx - 1>(std::tuple<Spec...>()))>::type, false>(idx, fieldOffset<idx>());
 }
 
 template <typename... Spec>
@@ -139,9 +146,9 @@ template <int idx>
 inline auto ProtoBufParser<Spec...>::getFieldView() const -> typename ProtoBufParserReturn::item_return_view<typename std::remove_reference<decltype(std::get<idx - 1>(std::tuple<Spec...>()))>::type, is_vector<typename std::remove_reference<decltype(std::get<idx - 1>(std::tuple<Spec...>()))>::type>{}>::type
 {
   if constexpr (!is_vector<typename std::remove_reference<decltype(std::get<idx - 1>(std::tuple<Spec...>()))>::type>{})
-    return getFieldAs<typename std::remove_reference<decltype(std::get<idx - 1>(std::tuple<Spec...>()))>::type, true>(idx);
+    return getFieldAs<typename std::remove_reference<decltype(std::get<idx - 1>(std::tuple<Spec...>()))>::type, true>(idx, fieldOffset<idx>());
   else
-    return getFieldsAs<typename std::remove_reference<decltype(std::get<idx - 1>(std::tuple<Spec...>()))>::type, true>(idx);
+    return getFieldsAs<typename std::remove_reference<decltype(std::get<idx - 1>(std::tuple<Spec...>()))>::type, true>(idx, fieldOffset<idx>());
   //return getFieldsViewAs<typename std::remove_reference<decltype(std::get<idx - 1>(std::tuple<Spec...>()))>::type>(idx);
 }
 
@@ -194,6 +201,20 @@ inline auto constexpr ProtoBufParser<Spec...>::getDeepType() //static
   return decltype(std::declval<typename std::remove_reference<decltype(std::get<idx - 1>(std::tuple<Spec...>()))>::type>().template getDeepType<viewonly, idx2, rest...>()){};
 }
 
+template <typename... Spec>
+template <int idx>
+inline unsigned int ProtoBufParser<Spec...>::fieldOffset() const
+{
+  static_assert(idx > 0 && idx <= static_cast<int>(sizeof...(Spec)), "Field index out of range");
+
+  if (!d_fieldindexvalid)
+  {
+    indexFields(d_fieldoffsets.data(), d_fieldoffsets.size());
+    d_fieldindexvalid = true;
+  }
+  return d_fieldoffsets[idx - 1];
+}
+
 template <typename... Spec>
 template <int idx>
 inline constexpr unsigned int ProtoBufParser<Spec...>::getType() //static
@@ -369,6 +390,7 @@ inline bool ProtoBufParser<Spec...>::addFieldInternal(T const &value)
     delete[] d_data;
   d_data = newdata;
   d_size = d_size + size;
+  d_fieldindexvalid = false;
 
   //std::cout << "OUTPUT: " << bepaald::bytesToHexString(d_data, d_size) << std::endl;
 
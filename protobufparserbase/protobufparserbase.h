@@ -244,6 +244,7 @@ class ProtoBufParserBase
   unsigned char *d_data;
   uint64_t d_size;
   MEMTYPE d_viewonly;
+  mutable bool d_fieldindexvalid; // see ProtoBufParser::fieldOffset(), reset whenever d_data changes
  public:
   inline ProtoBufParserBase();
   inline explicit ProtoBufParserBase(std::string const &base64);
@@ -279,12 +280,13 @@ class ProtoBufParserBase
   inline static int64_t getVarIntFieldLength(int pos, unsigned char const *data, int size);
   inline std::pair<unsigned char *, uint64_t> getFieldData(int num, int32_t *wiretype) const;
   inline std::pair<unsigned char *, uint64_t> getFieldData(int num, int32_t *wiretype, unsigned int *pos) const;
+  inline void indexFields(unsigned int *offsets, unsigned int count) const;
   inline void getPosAndLengthForField(int num, int startpos, int64_t *pos, int64_t *fieldlength) const;
   inline bool fieldExists(int num) const;
   template <typename T, bool asview>
-  inline auto getFieldAs(int num) const;
+  inline auto getFieldAs(int num, unsigned int startpos = 0) const;
   template <typename T, bool asview>
-  inline auto getFieldsAs(int num) const; // T must be std::vector<Something>
+  inline auto getFieldsAs(int num, unsigned int startpos = 0) const; // T must be std::vector<Something>
   // template <typename T>
   // inline typename ProtoBufParserReturn::item_return_view<T, false>::type getFieldViewAs(int num) const;
   // template <typename T>
@@ -295,14 +297,16 @@ inline ProtoBufParserBase::ProtoBufParserBase()
   :
   d_data(nullptr),
   d_size(0),
-  d_viewonly(MEMTYPE::OWNING)
+  d_viewonly(MEMTYPE::OWNING),
+  d_fieldindexvalid(false)
 {}
 
 inline ProtoBufParserBase::ProtoBufParserBase(ProtoBufParserBase const &other)
   :
   d_data(other.d_viewonly == MEMTYPE::VIEWONLY ? other.d_data : nullptr),
   d_size(other.d_size),
-  d_viewonly(other.d_viewonly)
+  d_viewonly(other.d_viewonly),
+  d_fieldindexvalid(false)
 {
   if (d_viewonly == MEMTYPE::OWNING)
   {
@@ -320,6 +324,7 @@ inline ProtoBufParserBase &ProtoBufParserBase::operator=(ProtoBufParserBase cons
 
     d_size = other.d_size;
     d_viewonly = other.d_viewonly;
+    d_fieldindexvalid = false;
     if (d_viewonly == MEMTYPE::VIEWONLY)
     {
       d_data = new unsigned char[d_size];
@@ -336,10 +341,12 @@ inline ProtoBufParserBase::ProtoBufParserBase(ProtoBufParserBase &&other) noexce
   :
   d_data(other.d_data),
   d_size(other.d_size),
-  d_viewonly(other.d_viewonly)
+  d_viewonly(other.d_viewonly),
+  d_fieldindexvalid(false)
 {
   other.d_data = nullptr;
   other.d_size = 0;
+  other.d_fieldindexvalid = false;
 }
 
 inline ProtoBufParserBase &ProtoBufParserBase::operator=(ProtoBufParserBase &&other) noexcept
@@ -351,9 +358,11 @@ inline ProtoBufParserBase &ProtoBufParserBase::operator=(ProtoBufParserBase &&ot
     d_data = other.d_data;
     d_size = other.d_size;
     d_viewonly = other.d_viewonly;
+    d_fieldindexvalid = false;
 
     other.d_data = nullptr;
     other.d_size = 0;
+    other.d_fieldindexvalid = false;
   }
   return *this;
 }
@@ -362,7 +371,8 @@ inline ProtoBufParserBase::ProtoBufParserBase(std::string const &base64)
   :
   d_data(nullptr),
   d_size(0),
-  d_viewonly(MEMTYPE::OWNING)
+  d_viewonly(MEMTYPE::OWNING),
+  d_fieldindexvalid(false)
 {
   std::pair<unsigned char *, size_t> l_data = Base64::base64StringToBytes(base64);
   d_data = l_data.first;
@@ -375,7 +385,8 @@ inline ProtoBufParserBase::ProtoBufParserBase(unsigned char const *data, uint64_
   :
   d_data(nullptr),
   d_size(size),
-  d_viewonly(MEMTYPE::OWNING)
+  d_viewonly(MEMTYPE::OWNING),
+  d_fieldindexvalid(false)
 {
   d_data = new unsigned char[d_size];
   if (d_size)
@@ -386,7 +397,8 @@ inline ProtoBufParserBase::ProtoBufParserBase(unsigned char *data, uint64_t size
   :
   d_data(viewonly == MEMTYPE::VIEWONLY ? data : nullptr),
   d_size(size),
-  d_viewonly(viewonly)
+  d_viewonly(viewonly),
+  d_fieldindexvalid(false)
 {
   if (d_viewonly == MEMTYPE::OWNING) [[unlikely]]
   {
@@ -405,6 +417,7 @@ inline void ProtoBufParserBase::clear()
 {
   if (d_viewonly == MEMTYPE::OWNING)
     bepaald::destroyPtr(&d_data, &d_size);
+  d_fieldindexvalid = false;
 }
 
 inline bool ProtoBufParserBase::operator==(ProtoBufParserBase const &other) const
@@ -446,6 +459,7 @@ inline void ProtoBufParserBase::setData(std::string const &base64)
 
   d_data = l_data.first;
   d_size = l_data.second;
+  d_fieldindexvalid = false;
 }
 
 inline void ProtoBufParserBase::setData(unsigned char const *d, int64_t s)
@@ -458,6 +472,7 @@ inline void ProtoBufParserBase::setData(unsigned char const *d, int64_t s)
   if (d)
     std::memcpy(d_data, d, s);
   d_size = s;
+  d_fieldindexvalid = false;
 }
 
 int32_t ProtoBufParserBase::getFirstFieldNumber() const
@@ -585,6 +600,7 @@ bool ProtoBufParserBase::deleteFirstField(int num, T const *value [[maybe_unused
     delete[] d_data;
     d_data = newdata;
     d_size = d_size - fieldlength;
+    d_fieldindexvalid = false;
 
     //std::cout << "After delete" << std::endl;
     //std::cout << "DATA:  " << bepaald::bytesToHexString(d_data, d_size) << std::endl;
@@ -741,6 +757,58 @@ std::pair<unsigned char *, uint64_t> ProtoBufParserBase::getFieldData(int num, i
   return std::pair<unsigned char *, int64_t>(nullptr, 0);
 }
 
+// one pass over the data, storing the position of the first occurrence of each
+// field 1...count in offsets[field - 1]. Fields that are not present get d_size.
+// getFieldData() started from these positions finds the field right away.
+inline void ProtoBufParserBase::indexFields(unsigned int *offsets, unsigned int count) const
+{
+  for (unsigned int i = 0; i < count; ++i)
+    offsets[i] = d_size;
+
+  unsigned int pos = 0;
+  while (pos < d_size)
+  {
+    unsigned int fieldpos = pos;
+    int32_t field    = (d_data[pos] & 0b0111'1000) >> 3;
+    int32_t wiretype =  d_data[pos] & 0b0000'0111;
+    int fieldshift = 4;
+    while (d_data[pos] & 0b1000'0000 && // skipping the shift
+           pos < d_size - 1)
+    {
+      field |= (d_data[++pos] & 0b0111'1111) << fieldshift;
+      fieldshift += 7;
+    }
+
+    if (field > 0 && static_cast<unsigned int>(field) <= count && offsets[field - 1] == d_size)
+      offsets[field - 1] = fieldpos;
+
+    ++pos;
+    switch (wiretype)
+    {
+      case WIRETYPE::LENGTH_DELIMITED:
+      {
+        uint64_t fieldlength = readVarInt(&pos, d_data, d_size);
+        pos += fieldlength;
+        break;
+      }
+      case WIRETYPE::VARINT:
+      {
+        uint64_t fieldlength = getVarIntFieldLength(pos, d_data, d_size);
+        pos += fieldlength;
+        break;
+      }
+      case WIRETYPE::FIXED64:
+        pos += 8;
+        break;
+      case WIRETYPE::FIXED32:
+        pos += 4;
+        break;
+      default: // (deprecated) groups, skipped as in getFieldData()
+        break;
+    }
+  }
+}
+
 inline void ProtoBufParserBase::getPosAndLengthForField(int num, int startpos, int64_t *pos, int64_t *fieldlength) const
 {
   int64_t localpos = startpos;
@@ -900,7 +968,7 @@ bool ProtoBufParserBase::fieldExists(int num) const
 
 // for optional
 template <typename T, bool asview>
-inline auto ProtoBufParserBase::getFieldAs(int num) const
+inline auto ProtoBufParserBase::getFieldAs(int num, unsigned int startpos) const
 {
 
   typedef typename std::conditional<asview,
@@ -915,7 +983,7 @@ inline auto ProtoBufParserBase::getFieldAs(int num) const
   // printType<ReturnType>();
 
   int32_t wiretype;
-  std::pair<unsigned char *, uint64_t> fielddata(getFieldData(num, &wiretype));
+  std::pair<unsigned char *, uint64_t> fielddata(getFieldData(num, &wiretype, &startpos));
   if (fielddata.first)
   {
 
@@ -997,7 +1065,7 @@ inline auto ProtoBufParserBase::getFieldAs(int num) const
 
 // for repeated
 template <typename T, bool asview>
-inline auto ProtoBufParserBase::getFieldsAs(int num) const
+inline auto ProtoBufParserBase::getFieldsAs(int num, unsigned int startpos) const
 {
   typedef typename ProtoBufParserReturn::item_return<T, true>::type::value_type HeldType_valuetype;
   typedef typename std::conditional<asview,
@@ -1013,7 +1081,7 @@ inline auto ProtoBufParserBase::getFieldsAs(int num) const
   // printType<ReturnType>();
   // printType<ReturnType_held>();
 
-  unsigned int pos = 0;
+  unsigned int pos = startpos;
   ReturnType result;
   while (true)
   {
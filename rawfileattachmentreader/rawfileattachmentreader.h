@@ -37,6 +37,7 @@ class RawFileAttachmentReader final : public AttachmentReader<RawFileAttachmentR
   virtual ~RawFileAttachmentReader() override = default;
 
   inline virtual ReturnCode getAttachment(FrameWithAttachment *frame, bool verbose) override;
+  inline virtual ReturnCode readAttachment(Sink const &sink, bool verbose) override;
 };
 
 inline RawFileAttachmentReader::RawFileAttachmentReader(std::string const &filename)
@@ -85,4 +86,37 @@ inline BaseAttachmentReader::ReturnCode RawFileAttachmentReader::getAttachment(F
   return ReturnCode::OK;
 }
 
+inline BaseAttachmentReader::ReturnCode RawFileAttachmentReader::readAttachment(Sink const &sink, bool verbose) // virtual
+{
+  uint64_t attachmentdata_size = bepaald::fileSize(d_filename);
+  std::ifstream file(d_filename, std::ios_base::binary | std::ios_base::in);
+  if (!file.is_open()) [[unlikely]]
+  {
+    Logger::error("Failed to open file at path: '", d_filename, "'");
+    return ReturnCode::ERROR;
+  }
+
+  if (attachmentdata_size == 0) [[unlikely]]
+    Logger::warning("Asked to read 0-byte attachment");
+
+  if (verbose) [[unlikely]]
+    Logger::message("Reading attachment data, length: ", attachmentdata_size);
+
+  std::unique_ptr<unsigned char[]> buffer(new unsigned char[std::min(attachmentdata_size, s_chunksize)]);
+  for (uint64_t processed = 0; processed < attachmentdata_size;)
+  {
+    uint64_t chunksize = std::min(attachmentdata_size - processed, s_chunksize);
+    if (!file.read(reinterpret_cast<char *>(buffer.get()), chunksize) ||
+        file.gcount() != static_cast<std::streamsize>(chunksize)) [[unlikely]]
+    {
+      Logger::error("Failed to read data from path: '", d_filename, "'");
+      return ReturnCode::ERROR;
+    }
+    if (!sink(buffer.get(), chunksize)) [[unlikely]]
+      return ReturnCode::ERROR;
+    processed += chunksize;
+  }
+  return ReturnCode::OK;
+}
+
 #endif
@@ -0,0 +1,70 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "signalbackup.ih"
+
+#include <queue>
+
+// builds a byte trie of s_emoji_unicode_list, breadth first, so the children
+// of every node end up next to each other (ordered by byte value)
+std::vector<SignalBackup::EmojiTrieNode> SignalBackup::buildEmojiTrie() // static
+{
+  // sorted, all emoji starting with the same bytes form a consecutive range,
+  // and an emoji always comes before the longer ones it is a prefix of
+  std::vector<std::string_view> emoji(std::begin(s_emoji_unicode_list), std::end(s_emoji_unicode_list));
+  std::sort(emoji.begin(), emoji.end());
+
+  struct Pending
+  {
+    unsigned int node;
+    unsigned int begin; // range of emoji passing through this node
+    unsigned int end;
+    unsigned int depth;
+  };
+
+  std::vector<EmojiTrieNode> trie{{0, 0, 0, 0}}; // root
+  std::queue<Pending> pending;
+  pending.push({0, 0, static_cast<unsigned int>(emoji.size()), 0});
+  while (!pending.empty())
+  {
+    auto [node, begin, end, depth] = pending.front();
+    pending.pop();
+
+    if (begin < end && emoji[begin].size() == depth)
+    {
+      trie[node].length = depth;
+      ++begin;
+    }
+
+    trie[node].firstchild = trie.size();
+    while (begin < end)
+    {
+      unsigned char byte = static_cast<unsigned char>(emoji[begin][depth]);
+      unsigned int childend = begin + 1;
+      while (childend < end && static_cast<unsigned char>(emoji[childend][depth]) == byte)
+        ++childend;
+
+      pending.push({static_cast<unsigned int>(trie.size()), begin, childend, depth + 1});
+      trie.push_back({0, 0, byte, 0});
+      ++trie[node].children;
+      begin = childend;
+    }
+  }
+  return trie;
+}
@@ -97,3 +97,33 @@ SqlStatementFrame SignalBackup::buildSqlStatementFrame(std::string const &table,
 
   return newframe;
 }
+
+SqlStatementFrame SignalBackup::buildSqlStatementFrame(std::string const &table, SqliteDB::RowView const &row) const
+{
+  SqlStatementFrame newframe;
+  std::string newstatement("INSERT INTO " + table + " VALUES (");
+  newstatement.reserve(newstatement.size() + 2 * row.columns());
+
+  for (int j = 0; j < row.columns(); ++j)
+  {
+    newstatement.append(j < row.columns() - 1 ? "?," : "?)");
+
+    // the values are copied straight from the statement into the frame
+    if (row.valueHasType<long long int>(j))
+      newframe.addIntParameter(row.getInt(j));
+    else if (row.isNull(j))
+      newframe.addNullParameter();
+    else if (row.valueHasType<std::string>(j))
+      newframe.addStringParameter(row.getText(j));
+    else if (row.valueHasType<std::pair<unsigned char const *, size_t>>(j))
+    {
+      auto [data, size] = row.getBlob(j);
+      newframe.addBlobParameter(data, size);
+    }
+    else if (row.valueHasType<double>(j))
+      newframe.addDoubleParameter(row.getDouble(j));
+  }
+  newframe.setStatementField(newstatement);
+
+  return newframe;
+}
@@ -0,0 +1,57 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "signalbackup.ih"
+
+/*
+  Creates the indexes that were skipped while loading the backup's SQL frames.
+  Because they now end up last in sqlite_master, the original position of every
+  schema object is remembered, so an exported backup writes the schema in the
+  same order as the input file.
+*/
+void SignalBackup::createDeferredIndexes(std::vector<std::pair<std::string, long long int>> const &indexes)
+{
+  if (d_verbose) [[unlikely]]
+    Logger::message("Creating ", indexes.size(), " indexes");
+
+  SqliteDB::QueryResults schema;
+  if (!d_database.exec("SELECT name FROM sqlite_master ORDER BY rowid", &schema)) [[unlikely]]
+    return;
+
+  std::vector<std::string> schemaorder;
+  schemaorder.reserve(schema.rows() + indexes.size());
+  unsigned int next = 0; // next entry from sqlite_master
+  for (auto const &[statement, position] : indexes)
+  {
+    while (next < schema.rows() && next < position)
+      schemaorder.emplace_back(schema.valueAsString(next++, 0));
+
+    if (!d_database.exec(statement)) [[unlikely]]
+    {
+      Logger::warning("Failed to execute statement: ", statement);
+      continue;
+    }
+    schemaorder.emplace_back(d_database.getSingleResultAs<std::string>("SELECT name FROM sqlite_master ORDER BY rowid DESC LIMIT 1", std::string()));
+  }
+  while (next < schema.rows())
+    schemaorder.emplace_back(schema.valueAsString(next++, 0));
+
+  d_schemaorder = std::move(schemaorder);
+  d_schemaorder_version = d_database.getSingleResultAs<long long int>("PRAGMA schema_version", -1);
+}
@@ -22,11 +22,17 @@
 #include "../common_be.h"
 #include "../common_filesystem.h"
 #include "../mimetypes/mimetypes.h"
+#include "../threadpool/threadpool.h"
+#include "../attachmentreadscheduler/attachmentreadscheduler.h"
+#include "mediadedupindex.h"
+
+#include <deque>
+#include <future>
 
 bool SignalBackup::dumpMedia(std::string const &dir, std::vector<std::string> const &daterangelist,
                              std::vector<long long int> const &threads, long long int minsize,
                              long long int maxsize, bool excludestickers, bool excludequotes,
-                             bool aggressive_sanitizing, bool overwrite) const
+                             bool aggressive_sanitizing, bool overwrite, bool deduplicatemedia) const
 {
   Logger::message("Dumping media to dir '", dir, "'");
 
@@ -49,13 +55,15 @@ bool SignalBackup::dumpMedia(std::string const &dir, std::vector<std::string> co
 
   // minimal query, for incomplete database
   bool fullbackup = false;
+  bool hasuniqueid = d_database.tableContainsColumn(d_part_table, "unique_id");
   std::string query = "SELECT " +
+    d_part_table + "._id AS dumpmedia_rowid, " +
+    (hasuniqueid ? d_part_table + ".unique_id" : "-1"s) + " AS dumpmedia_uniqueid, " +
     d_part_table + "." + d_part_mid + ", " +
     d_part_table + "." + d_part_ct + ", " +
     d_part_table + ".file_name, " +
     d_part_table + ".display_order"
-    " FROM " + d_part_table + " WHERE " + d_part_table + "._id == ?" +
-    (d_database.tableContainsColumn(d_part_table, "unique_id") ? " AND unique_id == ?" : "") +
+    " FROM " + d_part_table + " WHERE " + d_part_table + "._id IS NOT NULL" +
     (excludequotes ? " AND quote = 0" : "") +
     ((excludestickers && d_database.tableContainsColumn(d_part_table, "sticker_id")) ? " AND sticker_id = -1" : "");
 
@@ -65,6 +73,8 @@ bool SignalBackup::dumpMedia(std::string const &dir, std::vector<std::string> co
   {
     fullbackup = true;
     query = "SELECT " +
+      d_part_table + "._id AS dumpmedia_rowid, " +
+      (hasuniqueid ? d_part_table + ".unique_id" : "-1"s) + " AS dumpmedia_uniqueid, " +
       d_part_table + "." + d_part_mid + ", " +
       d_part_table + "." + d_part_ct + ", " +
       d_part_table + ".file_name, " +
@@ -85,8 +95,7 @@ bool SignalBackup::dumpMedia(std::string const &dir, std::vector<std::string> co
       "LEFT JOIN recipient ON thread." + d_thread_recipient_id + " == recipient._id "
       "LEFT JOIN groups ON recipient.group_id == groups.group_id " +
       (d_database.containsTable("distribution_list") ? "LEFT JOIN distribution_list ON recipient._id = distribution_list.recipient_id " : "") +
-      "WHERE " + d_part_table + "._id == ?" +
-      (d_database.tableContainsColumn(d_part_table, "unique_id") ? " AND unique_id == ?" : "") +
+      "WHERE " + d_part_table + "._id IS NOT NULL" +
       (excludequotes ? " AND quote = 0" : "") +
       ((excludestickers && d_database.tableContainsColumn(d_part_table, "sticker_id")) ? " AND sticker_id = -1" : "");
   }
@@ -145,64 +154,72 @@ bool SignalBackup::dumpMedia(std::string const &dir, std::vector<std::string> co
   if (d_verbose) [[unlikely]]
     Logger::message("Dump media query: ", query);
 
-#if __cplusplus > 201703L
-  for (int count = 1; auto const &aframe : d_attachments)
-#else
-  int count = 1;
+  // get the info for all attachments at once
+  SqliteDB::QueryResults results;
+  if (!d_database.exec(query, &results))
+    return false;
+
+  // (rowid, uniqueid) -> first row in results, number of rows
+  std::map<std::pair<long long int, long long int>, std::pair<unsigned int, unsigned int>> attachmentrows;
+  for (unsigned int i = 0; i < results.rows(); ++i)
+    if (!results.isNull(i, "dumpmedia_uniqueid")) [[likely]]
+      ++attachmentrows.try_emplace({results.getValueAs<long long int>(i, "dumpmedia_rowid"),
+                                    results.getValueAs<long long int>(i, "dumpmedia_uniqueid")}, i, 0).first->second.second;
+
+  // decide on the (unique) filename of every attachment. As the directory was empty at
+  // the start, the files (and directories) created are tracked here, instead of probing
+  // the filesystem (which would not work anyway, as the files are written later). Like
+  // the filesystem, the tracked names ignore case if the filesystem does.
+  struct MediaFile
+  {
+    AttachmentFrame *attachment;
+    std::string path;
+    long long int datum;
+  };
+  std::vector<MediaFile> mediafiles;
+  ReservedFilenames reserved(FilenameLess{bepaald::caseInsensitiveDir(dir)});
   for (auto const &aframe : d_attachments)
-#endif
   {
-    Logger::message_overwrite("Saving attachments... ", count, "/", d_attachments.size());
-
     AttachmentFrame *a = aframe.second.get();
 
     //std::cout << "Looking for attachment: " << std::endl;
     //std::cout << "rid: " << a->rowId() << std::endl;
     //std::cout << "uid: " << a->attachmentId() << std::endl;
 
-    SqliteDB::QueryResults results;
-
-    uint64_t rowid = a->rowId();
-    int64_t uniqueid = a->attachmentId();
-    if (uniqueid == 0)
+    long long int rowid = a->rowId();
+    long long int uniqueid = a->attachmentId();
+    if (uniqueid == 0 || !hasuniqueid)
       uniqueid = -1;
 
-    if (d_database.tableContainsColumn(d_part_table, "unique_id"))
-    {
-      if (!d_database.exec(query, {rowid, uniqueid},  &results))
-        return false;
-    }
-    else // no "unique_id" in part table
-      if (!d_database.exec(query, rowid,  &results))
-        return false;
-
-    //results.prettyPrint();
+    auto found = attachmentrows.find({rowid, uniqueid});
+    unsigned int rows = (found != attachmentrows.end()) ? found->second.second : 0;
 
-    if (results.rows() == 0 && (!threads.empty() || !daterangelist.empty() || minsize > -1 || maxsize > -1 || excludequotes || excludestickers)) // probably an attachment for a de-selected thread
+    if (rows == 0 && (!threads.empty() || !daterangelist.empty() || minsize > -1 || maxsize > -1 || excludequotes || excludestickers)) // probably an attachment for a de-selected thread
       continue;
 
-    if (results.rows() != 1)
+    if (rows != 1)
     {
-      Logger::error("Unexpected number of results: ", results.rows(), " (rowid: ", a->rowId(), ", uniqueid: ", a->attachmentId(), ")");
+      Logger::error("Unexpected number of results: ", rows, " (rowid: ", a->rowId(), ", uniqueid: ", a->attachmentId(), ")");
       continue;
     }
+    unsigned int row = found->second.first;
 
     std::string filename;
     long long int datum = a->attachmentId(); // only works on older dbs...
 
-    if (fullbackup && !results.isNull(0, "date_received"))
-      datum = results.getValueAs<long long int>(0, "date_received");
-    long long int order = results.getValueAs<long long int>(0, "display_order");
+    if (fullbackup && !results.isNull(row, "date_received"))
+      datum = results.getValueAs<long long int>(row, "date_received");
+    long long int order = results.getValueAs<long long int>(row, "display_order");
 
-    if (!results.isNull(0, "file_name")) // file name IS SET in database
-      filename = sanitizeFilename(results.valueAsString(0, "file_name"), aggressive_filename_sanitizing);
+    if (!results.isNull(row, "file_name")) // file name IS SET in database
+      filename = sanitizeFilename(results.valueAsString(row, "file_name"), aggressive_filename_sanitizing);
 
     if (filename.empty()) // filename was not set in database or was not impossible
     {                     // to sanitize (eg reserved name in windows 'COM1')
       std::string datestr = (datum != -1) ? bepaald::toDateString(datum / 1000, "signal-%Y-%m-%d-%H%M%S") : "signal";
 
       // get file ext
-      std::string mime = results.valueAsString(0, d_part_ct);
+      std::string mime = results.valueAsString(row, d_part_ct);
       std::string ext = std::string(MimeTypes::getExtension(mime));
       if (ext.empty())
       {
@@ -216,11 +233,11 @@ bool SignalBackup::dumpMedia(std::string const &dir, std::vector<std::string> co
 
     // std::cout << "FILENAME: " << filename << std::endl;
     std::string targetdir = dir;
-    if (fullbackup && !results.isNull(0, "thread_id") && !results.isNull(0, "chatpartner")
-        && !results.isNull(0, d_mms_type))
+    if (fullbackup && !results.isNull(row, "thread_id") && !results.isNull(row, "chatpartner")
+        && !results.isNull(row, d_mms_type))
     {
-      long long int tid = results.getValueAs<long long int>(0, "thread_id");
-      std::string chatpartner = sanitizeFilename(results.valueAsString(0, "chatpartner"), aggressive_filename_sanitizing);
+      long long int tid = results.getValueAs<long long int>(row, "thread_id");
+      std::string chatpartner = sanitizeFilename(results.valueAsString(row, "chatpartner"), aggressive_filename_sanitizing);
       if (chatpartner.empty())
         chatpartner = "Contact " + bepaald::toString(tid);
 
@@ -247,6 +264,7 @@ bool SignalBackup::dumpMedia(std::string const &dir, std::vector<std::string> co
       } // else, thread was found, use the name that was used before
 
       // create dir if not exists
+      reserved.insert(bepaald::concat(dir, "/", conversations.second[idx_of_thread]));
       if (!bepaald::isDir(bepaald::concat(dir, "/", conversations.second[idx_of_thread])))
       {
         // std::cout << " Creating subdirectory '" << conversations.second[idx_of_thread] << "' for conversation..." << std::endl;
@@ -258,7 +276,7 @@ bool SignalBackup::dumpMedia(std::string const &dir, std::vector<std::string> co
         }
       }
 
-      long long int msg_box = results.getValueAs<long long int>(0, d_mms_type);
+      long long int msg_box = results.getValueAs<long long int>(row, d_mms_type);
       targetdir = bepaald::concat(dir, "/", conversations.second[idx_of_thread], "/", (Types::isOutgoing(msg_box) ? "sent" : "received"));
 
       // create dir if not exists
@@ -274,34 +292,97 @@ bool SignalBackup::dumpMedia(std::string const &dir, std::vector<std::string> co
     }
 
     // make filename unique
-    if (!makeFilenameUnique(targetdir, &filename))
+    if (!makeFilenameUnique(targetdir, &filename, &reserved))
     {
       Logger::error("getting unique filename for '", targetdir, "/", filename, "'");
       continue;
     }
 
-    std::ofstream attachmentstream(bepaald::concat(targetdir, "/", filename), std::ios_base::binary);
-    if (!attachmentstream.is_open())
+    mediafiles.push_back({a, bepaald::concat(targetdir, "/", filename), datum});
+  }
+
+  // write the files, decrypting the attachment data straight to disk. With
+  // deduplicatemedia, attachments that were already written are linked to the
+  // first copy. When writing concurrently, identical attachments that are being
+  // written at the same time may both be written in full.
+  std::unique_ptr<MediaDedupIndex> mediadedup(deduplicatemedia ? new MediaDedupIndex : nullptr);
+  enum class DumpResult
+  {
+    OK,
+    OPENFAILED,
+    WRITEFAILED,
+    TIMESTAMPFAILED
+  };
+  // the attachment data is prefetched from the backup in file order, ahead of the writers
+  std::vector<FrameWithAttachment *> readorder;
+  readorder.reserve(mediafiles.size());
+  for (auto const &m : mediafiles)
+    readorder.push_back(m.attachment);
+  AttachmentReadScheduler readscheduler(readorder);
+
+  auto dumpmediafile = [this, &mediadedup, &readscheduler](MediaFile const &m)
+  {
+    readscheduler.reading(m.attachment);
+    AttachmentFileResult result = writeAttachmentFile(m.attachment, m.path, mediadedup.get());
+    m.attachment->clearData();
+
+    if (result == AttachmentFileResult::OPENFAILED)
+      return DumpResult::OPENFAILED;
+    if (result == AttachmentFileResult::READFAILED || result == AttachmentFileResult::WRITEFAILED)
+      return DumpResult::WRITEFAILED;
+
+    // a hard link shares its timestamp with the first copy (which is set already)
+    if (result != AttachmentFileResult::HARDLINKED && !setFileTimeStamp(m.path, m.datum)) [[unlikely]]
+      return DumpResult::TIMESTAMPFAILED;
+    return DumpResult::OK;
+  };
+
+  auto report = [](MediaFile const &m, DumpResult result)
+  {
+    switch (result)
     {
-      Logger::error("Failed to open file for writing: '", targetdir, "/", filename, "'");
-      continue;
+      case DumpResult::OK: [[likely]]
+        break;
+      case DumpResult::OPENFAILED:
+        Logger::error("Failed to open file for writing: '", m.path, "'");
+        break;
+      case DumpResult::WRITEFAILED:
+        Logger::error("Failed to write data to file: '", m.path, "'");
+        break;
+      case DumpResult::TIMESTAMPFAILED:
+        Logger::warning("Failed to set timestamp for attachment '", m.path, "'");
+        break;
     }
+  };
 
-    ++count;
-    if (!attachmentstream.write(reinterpret_cast<char *>(a->attachmentData(d_verbose)), a->attachmentSize()))
+  if (d_threads > 1)
+  {
+    // attachments are written concurrently, results are reported in order
+    std::deque<std::future<DumpResult>> pending;
+    ThreadPool pool(d_threads); // declared last: workers are joined before anything else is destroyed
+    unsigned int const maxpending = d_threads * 64;
+    unsigned int submitted = 0;
+    for (unsigned int i = 0; i < mediafiles.size(); ++i)
     {
-      Logger::error("Failed to write data to file: '", targetdir, "/", filename, "'");
-      a->clearData();
-      continue;
+      while (submitted < mediafiles.size() && pending.size() < maxpending)
+      {
+        MediaFile const *m = &mediafiles[submitted++];
+        pending.emplace_back(pool.submit([m, &dumpmediafile]() { return dumpmediafile(*m); }));
+      }
+      Logger::message_overwrite("Saving attachments... ", i + 1, "/", mediafiles.size());
+      report(mediafiles[i], pending.front().get());
+      pending.pop_front();
     }
-
-    attachmentstream.close(); // need to close, or the auto-close will change files mtime again.
-    a->clearData();
-
-    if (!setFileTimeStamp(bepaald::concat(targetdir, "/", filename), datum)) [[unlikely]]
-      Logger::warning("Failed to set timestamp for attachment '", targetdir, "/", filename, "'");
-
   }
+  else
+    for (unsigned int i = 0; i < mediafiles.size(); ++i)
+    {
+      Logger::message_overwrite("Saving attachments... ", i + 1, "/", mediafiles.size());
+      report(mediafiles[i], dumpmediafile(mediafiles[i]));
+    }
+
   Logger::message_overwrite("Saving attachments... done.", Logger::Control::ENDOVERWRITE);
+  if (mediadedup)
+    mediadedup->report();
   return true;
 }
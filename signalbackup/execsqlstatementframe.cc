@@ -0,0 +1,41 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "signalbackup.ih"
+
+#include "../sqlstatementframe/sqlstatementframe.h"
+
+// runs the statement in the frame, binding its parameters directly from the frame data
+bool SignalBackup::execSqlStatementFrame(SqlStatementFrame const &frame) const
+{
+  SqliteDB::Statement stmt(d_database.cachedStatement(frame.bindStatementView()));
+  if (!stmt.ok()) [[unlikely]]
+    return false;
+
+  if (static_cast<int>(frame.parameterCount()) != stmt.parameterCount()) [[unlikely]]
+  {
+    Logger::error("Wrong number of parameters for query (parameters: ", frame.parameterCount(),
+                  ", placeholders: ", stmt.parameterCount(), ")");
+    Logger::error_indent("-> Query: \"", frame.bindStatementView(), "\"");
+    return false;
+  }
+
+  return frame.forEachParameter([&](int idx, auto const &value) { return stmt.bindAt(idx, value); }) &&
+    stmt.execute();
+}
@@ -44,27 +44,30 @@ bool SignalBackup::exportCsv(std::string const &filename, std::string const &tab
     return false;
   }
 
-  SqliteDB::QueryResults results;
-  if (!d_database.exec("SELECT * FROM " + table, &results))
+  // output header (before the first row) and data
+  bool first = true;
+  if (!d_database.forEachRow("SELECT * FROM " + table, [&](SqliteDB::RowView const &row)
   {
-    Logger::error("Gathering data from database");
-    return false;
-  }
-
-  // output header
-  for (unsigned int i = 0; i < results.columns(); ++i)
-    outputfile << results.header(i) << ((i == results.columns() - 1) ? '\n' : ',');
+    if (first)
+    {
+      for (int i = 0; i < row.columns(); ++i)
+        outputfile << row.header(i) << ((i == row.columns() - 1) ? '\n' : ',');
+      first = false;
+    }
 
-  // output data
-  for (unsigned int j = 0; j < results.rows(); ++j)
-    for (unsigned int i = 0; i < results.columns(); ++i)
+    for (int i = 0; i < row.columns(); ++i)
     {
-      std::string vas = results.valueAsString(j, i);
+      std::string vas = row.valueAsString(i);
       duplicateQuotes(&vas);
       bool escape = (vas.find_first_of(",\"\n") != std::string::npos) || // contains newline, quote or comma
         (!vas.empty() && (std::find_if(vas.begin(), vas.end(), [](char c) STATICLAMBDA { return !std::isspace(c); }) == vas.end())); // is all whitespace (and non empty)
-      outputfile << (escape ? "\"" : "") << vas << (escape ? "\"" : "") << ((i == results.columns() - 1) ? '\n' : ',');
+      outputfile << (escape ? "\"" : "") << vas << (escape ? "\"" : "") << ((i == row.columns() - 1) ? '\n' : ',');
     }
+  }))
+  {
+    Logger::error("Gathering data from database");
+    return false;
+  }
 
   return true;
 }
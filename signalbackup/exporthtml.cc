@@ -24,21 +24,26 @@
 */
 
 #include "signalbackup.ih"
+#include "htmlsearchindexshards.h"
+#include "htmlpageprefetch.h"
 
 #include "../common_filesystem.h"
+#include "../forkpool/forkpool.h"
 #include "../scopeguard/scopeguard.h"
 #include "../autoversion.h"
+#include "mediadedupindex.h"
+#include "../attachmentreadscheduler/attachmentreadscheduler.h"
 #include <cerrno>
 #include <chrono>
 
 bool SignalBackup::exportHtml(std::string const &directory, std::vector<long long int> const &limittothreads,
                               std::vector<std::string> const &daterangelist, std::string const &splitby,
                               long long int split, long long int origin, std::string const &selfphone, bool calllog,
-                              bool searchpage, bool stickerpacks, bool migrate, bool overwrite, bool append, bool lighttheme,
+                              bool searchpage, bool shardedsearchindex, bool stickerpacks, bool migrate, bool overwrite, bool append, bool lighttheme,
                               bool themeswitching, bool addexportdetails, bool blocked, bool fullcontacts,
                               bool settings, bool receipts, bool originalfilenames, bool linkify, bool chatfolders,
                               bool compact, bool pagemenu, bool aggressive_sanitizing, bool excludeexpiring,
-                              bool focusend, std::vector<std::string> const &ignoremediatypes)
+                              bool focusend, bool deduplicatemedia, std::vector<std::string> const &ignoremediatypes)
 {
   Logger::message("Starting HTML export to '", directory, "'");
 
@@ -66,10 +71,6 @@ bool SignalBackup::exportHtml(std::string const &directory, std::vector<long lon
   if (!prepareOutputDirectory(directory, overwrite, !originalfilenames /*allowappend only allowed when not using original filenames*/, append))
     return false;
 
-  // set sql statement cache size
-  d_database.setCacheSize(5); // empirically determined
-  ScopeGuard reset_cache_size([&]() { d_database.setCacheSize(); });
-
   // see if we need aggressive filename sanitizing
   d_aggressive_filename_sanitizing = aggressive_sanitizing || !specialCharsSupported(directory);
 
@@ -185,11 +186,11 @@ bool SignalBackup::exportHtml(std::string const &directory, std::vector<long lon
   //   if (skv->key() == "releasechannel.recipient_id")
   //     releasechannel = bepaald::toNumber<int>(skv->value());
 
-  SqliteDB::QueryResults search_idx_results;
   std::ofstream searchidx;
   bool searchidx_write_started = false;
   long long int searchidx_page_idx = 0;
   std::map<std::string, long long int> searchidx_page_idx_map;
+  HTMLSearchIndexShards searchidx_shards{bepaald::concat(directory, "/searchidx"), std::ofstream(), 0, {}};
 
   // start search index page
   if (searchpage)
@@ -200,7 +201,16 @@ bool SignalBackup::exportHtml(std::string const &directory, std::vector<long lon
       Logger::error("Failed to open 'searchidx.js' for writing");
       return false;
     }
-    searchidx << "message_idx = [\n";
+    if (shardedsearchindex)
+    {
+      if (!bepaald::isDir(searchidx_shards.directory) && !bepaald::createDir(searchidx_shards.directory)) [[unlikely]]
+      {
+        Logger::error("Failed to create directory `", searchidx_shards.directory, "'");
+        return false;
+      }
+    }
+    else
+      searchidx << "message_idx = [\n";
   }
 
   std::string exportdetails_html;
@@ -262,6 +272,8 @@ bool SignalBackup::exportHtml(std::string const &directory, std::vector<long lon
       options += "<br>--linkify";
     if (chatfolders)
       options += "<br>--chatfolders";
+    if (deduplicatemedia)
+      options += "<br>--deduplicatemedia";
 
     SqliteDB::QueryResults res;
     d_database.exec("SELECT MIN(" + d_mms_table + ".date_received) AS 'mindate', MAX(" + d_mms_table + ".date_received) AS 'maxdate' FROM " + d_mms_table, &res);
@@ -318,10 +330,37 @@ bool SignalBackup::exportHtml(std::string const &directory, std::vector<long lon
   std::map<int, int> thread_pagecount_map; // maps the number of pages for each thread.
   std::map<std::string, long long int, std::less<>> recipientmap; // save a mapping from uuid -> recipient_id
 
-  for (unsigned int t_idx = 0; t_idx < threads.size(); ++t_idx)
+  // attachments that were written already (when deduplicating). Every worker
+  // process has its own (it only links to files it wrote itself), the number
+  // of links made is passed back through the result files.
+  std::unique_ptr<MediaDedupIndex> mediadedup(deduplicatemedia ? new MediaDedupIndex : nullptr);
+
+  // With more than one thread, whole conversations are rendered by worker processes, each
+  // working on its own copy of the database. The workers do not write to searchidx.js,
+  // everything the main process needs after the loop is passed back through a small
+  // result file per conversation, merged in thread order below.
+  ForkPool htmlworkers(d_threads, threads.size());
+  ScopeGuard end_failed_worker([&]() { if (htmlworkers.isWorker()) htmlworkers.exitWorker(false); });
+  auto workerResultFile = [&](long long int t) { return bepaald::concat(directory, "/.exporthtml_thread_", bepaald::toString(t), ".tmp"); };
+
+  for (unsigned int t_idx = htmlworkers.next(); t_idx < threads.size(); t_idx = htmlworkers.next())
   {
     int t = threads[t_idx];
 
+    std::ofstream workerresult;
+    std::string searchidx_worker_lines;
+    std::string searchidx_worker_page;
+    std::pair<uint64_t, uint64_t> const linked_before(mediadedup ? mediadedup->linked() : std::pair<uint64_t, uint64_t>{0, 0});
+    if (htmlworkers.isWorker())
+    {
+      workerresult.open(WIN_LONGPATH(workerResultFile(t)), std::ios_base::binary);
+      if (!workerresult.is_open()) [[unlikely]]
+      {
+        Logger::error("Failed to open '", workerResultFile(t), "' for writing");
+        return false;
+      }
+    }
+
     // if (t == releasechannel)
     // {
     //   std::cout << "INFO: Skipping releasechannel thread..." << std::endl;
@@ -409,6 +448,8 @@ bool SignalBackup::exportHtml(std::string const &directory, std::vector<long lon
       if (d_verbose) [[unlikely]]
         Logger::message("Thread appears empty. Skipping...");
       excludethreads.push_back(t);
+      if (workerresult.is_open())
+        workerresult << "excluded\n";
       continue;
     }
 
@@ -539,6 +580,37 @@ bool SignalBackup::exportHtml(std::string const &directory, std::vector<long lon
                      is_releasechannel, all_recipients_ids, &rid_recipientinfo_map, &rid_writtenavatarpath_map,
                      &recipientmap, overwrite, append, lighttheme, themeswitching, searchpage, addexportdetails,
                      pagemenu && totalpages > 1);
+
+      // load the attachments, reactions, mentions, edits and polls of all messages on this page
+      unsigned int page_end = messagecount;
+      while (page_end < messages.rows() &&
+             page_end < (max_msg_per_page * (pagenumber + 1)) &&
+             messages(page_end, "periodsplit") == previous_period_split_string)
+        ++page_end;
+      HTMLPagePrefetch prefetch;
+      if (!HTMLprefetchPage(messages, messagecount, page_end, &prefetch)) [[unlikely]]
+        return false;
+
+      // the attachments on this page, in the order they are written, are prefetched
+      // from the backup in file order, ahead of writing them
+      std::vector<FrameWithAttachment *> page_attachments;
+      for (unsigned int i = messagecount; i < page_end; ++i)
+        for (HTMLPagePrefetch::Table const *table : {&prefetch.quote_attachments, &prefetch.attachments})
+        {
+          auto rows = table->rows.find(messages.getValueAs<long long int>(i, "_id"));
+          if (rows == table->rows.end())
+            continue;
+          for (unsigned int r = rows->second.first; r < rows->second.second; ++r)
+          {
+            if (table->results(r, d_part_ct) == "text/x-signal-plain") // long text body, not written as attachment
+              continue;
+            auto attachment = d_attachments.find({table->results.valueAsInt(r, "_id"), table->results.valueAsInt(r, "unique_id")});
+            if (attachment != d_attachments.end())
+              page_attachments.push_back(attachment->second.get());
+          }
+        }
+      AttachmentReadScheduler readscheduler(page_attachments);
+
       while (messagecount < (max_msg_per_page * (pagenumber + 1)) &&
              messages(messagecount, "periodsplit") == previous_period_split_string)
       {
@@ -576,6 +648,8 @@ bool SignalBackup::exportHtml(std::string const &directory, std::vector<long lon
             &poll,
             &poll_options,
             &poll_votes,
+            mediadedup.get(),
+            &readscheduler,
 
             messages.getValueAs<long long int>(messagecount, d_mms_type),           // type
             messages.getValueAs<long long int>(messagecount, "expires_in"),         // expires_in
@@ -614,50 +688,24 @@ bool SignalBackup::exportHtml(std::string const &directory, std::vector<long lon
         // get attachments if any...
         if (messages.valueAsInt(messagecount, "attcount", 0) > 0)
         {
-          d_database.exec(bepaald::concat("SELECT ",
-                                          d_part_table, "._id, ",
-                                          (d_database.tableContainsColumn(d_part_table, "unique_id") ? "unique_id"s : "-1 AS unique_id"), ", ",
-                                          d_part_ct, ", "
-                                          "file_name, ",
-                                          d_part_pending, ", ",
-                                          (d_database.tableContainsColumn(d_part_table, "caption") ? "caption, "s : std::string()),
-                                          "sticker_pack_id, ",
-                                          d_mms_table, ".date_received AS date_received "
-                                          "FROM ", d_part_table, " "
-                                          "LEFT JOIN ", d_mms_table, " ON ", d_mms_table, "._id = ", d_part_table, ".", d_part_mid, " "
-                                          "WHERE ", d_part_mid, " IS ? "
-                                          "AND quote IS ? "
-                                          " ORDER BY display_order ASC, ", d_part_table, "._id ASC"), {msg_info.msg_id, 0}, msg_info.attachment_results);
-
-          d_database.exec(bepaald::concat("SELECT ",
-                                          d_part_table, "._id, ",
-                                          (d_database.tableContainsColumn(d_part_table, "unique_id") ? "unique_id"s : "-1 AS unique_id"), ", ",
-                                          d_part_ct, ", "
-                                          "file_name, ",
-                                          d_part_pending, ", ",
-                                          (d_database.tableContainsColumn(d_part_table, "caption") ? "caption, "s : std::string()),
-                                          "sticker_pack_id, ",
-                                          d_mms_table, ".date_received AS date_received "
-                                          "FROM ", d_part_table, " "
-                                          "LEFT JOIN ", d_mms_table, " ON ", d_mms_table, "._id = ", d_part_table, ".", d_part_mid, " "
-                                          "WHERE ", d_part_mid, " IS ? "
-                                          "AND quote IS ? "
-                                          " ORDER BY display_order ASC, ", d_part_table, "._id ASC"), {msg_info.msg_id, 1}, msg_info.quote_attachment_results);
+          prefetch.attachments.get(msg_info.msg_id, msg_info.attachment_results);
+          prefetch.quote_attachments.get(msg_info.msg_id, msg_info.quote_attachment_results);
         }
         // check attachments for long message body -> replace cropped body & remove from attachment results
-        bool haslongbody = setLongMessageBody(&msg_info.body, &attachment_results);
+        setLongMessageBody(&msg_info.body, &attachment_results);
+
+        // the body is escaped for html further on, the search index needs the original
+        std::string searchidx_body;
+        if (searchpage && !Types::isStatusMessage(msg_info.type))
+          searchidx_body = msg_info.body;
 
         // get reactions if any...
         if (messages.valueAsInt(messagecount, "reactioncount", 0) > 0)
-          d_database.exec("SELECT emoji, author_id, DATETIME(date_sent / 1000, 'unixepoch', 'localtime') AS 'date_sent', "
-                          "DATETIME(date_received / 1000, 'unixepoch', 'localtime') AS 'date_received' "
-                          "FROM reaction WHERE message_id IS ?", msg_info.msg_id, msg_info.reaction_results);
+          prefetch.reactions.get(msg_info.msg_id, msg_info.reaction_results);
 
         // get edits if any...
         if (msg_info.original_message_id != -1 && d_database.tableContainsColumn(d_mms_table, "revision_number"))
-          d_database.exec(bepaald::concat("SELECT _id,body,date_received,", d_mms_date_sent, ",revision_number FROM ", d_mms_table,
-                                          " WHERE _id = ?1 OR original_message_id = ?1 ORDER BY ", d_mms_date_sent, " ASC"), // skip actual current message
-                          msg_info.original_message_id, msg_info.edit_revisions);
+          prefetch.revisions.get(msg_info.original_message_id, msg_info.edit_revisions);
 
         // set status message + icon
         if (Types::isStatusMessage(msg_info.type))
@@ -694,7 +742,7 @@ bool SignalBackup::exportHtml(std::string const &directory, std::vector<long lon
         std::vector<std::tuple<long long int, long long int, long long int>> mentions;
         if (messages.valueAsInt(messagecount, "mentioncount", 0) > 0)
         {
-          d_database.exec("SELECT recipient_id, range_start, range_length FROM mention WHERE message_id IS ?", msg_info.msg_id, &mention_results);
+          prefetch.mentions.get(msg_info.msg_id, &mention_results);
           for (unsigned int mi = 0; mi < mention_results.rows(); ++mi)
             mentions.emplace_back(mention_results.getValueAs<long long int>(mi, "recipient_id"),
                                   mention_results.getValueAs<long long int>(mi, "range_start"),
@@ -709,18 +757,9 @@ bool SignalBackup::exportHtml(std::string const &directory, std::vector<long lon
         // get polls if any...
         if (messages.valueAsInt(messagecount, "poll_id", -1) > -1)
         {
-          // poll: _id, author_id, message_id, question, allow_multiple_votes, end_message_id
-          // poll_option: _id, poll_id, option_text, option_order
-          // poll_vote: _id, poll_id, poll_option_id, voter_id, vote_count, date_received, vote_state
-          d_database.exec("SELECT question, allow_multiple_votes, end_message_id FROM poll WHERE message_id = ?", msg_info.msg_id, msg_info.poll);
-          d_database.exec("SELECT _id, option_text FROM poll_option WHERE poll_id = ? ORDER BY option_order ASC",
-                          messages.valueAsInt(messagecount, "poll_id", -1), msg_info.poll_options);
-
-          // poll_state: NONE = 0, PENDING_REMOVE = 1, PENDING_ADD = 2, REMOVED = 3, ADDED = 4,
-          // not sure what to do with 0, 1, and 2 (but not sure if they can appear in a backup at all).
-          d_database.exec("SELECT poll_option_id, voter_id, vote_count, date_received FROM poll_vote "
-                          "WHERE poll_id = ? AND vote_state = 4",
-                          messages.valueAsInt(messagecount, "poll_id", -1), msg_info.poll_votes);
+          prefetch.polls.get(msg_info.msg_id, msg_info.poll);
+          prefetch.poll_options.get(messages.valueAsInt(messagecount, "poll_id", -1), msg_info.poll_options);
+          prefetch.poll_votes.get(messages.valueAsInt(messagecount, "poll_id", -1), msg_info.poll_votes);
         }
 
         // prep body: scan emoji, linkify, and handle mentions and message ranges...
@@ -770,65 +809,37 @@ bool SignalBackup::exportHtml(std::string const &directory, std::vector<long lon
             searchidx_page_idx = it->second;
           else
             searchidx_page_idx_map.emplace(bepaald::concat(msg_info.threaddir, "/", sanitized_base_filename), ++searchidx_page_idx);
-
-          // because the body is already escaped for html at this point, we get it fresh from database (and have sqlite do the json formatting)
-          if (!d_database.exec(bepaald::concat("SELECT json_object("
-                                               "'i', ?1, "
-                                               "'b', ", d_mms_table, ".body, "
-                                               "'f', ?2, "
-                                               "'t', ?3, "
-                                               "'o', ?4, "
-                                               "'d', ?5, "
-                                               "'p', ?6, "
-                                               "'n', ?7) AS line,",
-                                               (haslongbody ?
-                                                d_part_table + "._id AS rowid, " +
-                                                (d_database.tableContainsColumn(d_part_table, "unique_id") ?
-                                                 d_part_table + ".unique_id AS uniqueid" : "-1 AS uniqueid") :
-                                                " -1 AS rowid, -1 AS uniqueid"),
-                                               " FROM ", d_mms_table, " "
-                                               "LEFT JOIN thread ON thread._id IS ?8 ",
-                                               (haslongbody ?
-                                                bepaald::concat("LEFT JOIN ", d_part_table, " ON ", d_part_table, ".", d_part_mid, " IS ?1 AND ", d_part_table, ".", d_part_ct, " = 'text/x-signal-plain' AND ", d_part_table, ".quote = 0 ") : ""),
-                                               "WHERE ", d_mms_table, "._id = ?1"),
-                               {msg_info.msg_id, msg_info.msg_recipient_id, thread_recipient_id, msg_info.incoming ? 0 : 1,
-                                date_received / 1000 - 1404165600, // lose the last three digits (miliseconds, they are never displayed anyway).
-                                                                   // subtract "2014-07-01". Signals initial release was 2014-07-29, negative
-                                                                   // numbers should work otherwise anyway.
-                                searchidx_page_idx, pagenumber, t},
-                               &search_idx_results) ||
-              search_idx_results.rows() < 1) [[unlikely]]
+          if (htmlworkers.isWorker() && searchidx_worker_page.empty())
+            searchidx_worker_page = bepaald::concat(msg_info.threaddir, "/", sanitized_base_filename);
+
+          std::string line(bepaald::concat("{\"i\":", bepaald::toString(msg_info.msg_id), ",\"b\":"));
+          bepaald::appendJsonString(&line, searchidx_body);
+          line += bepaald::concat(",\"f\":", bepaald::toString(msg_info.msg_recipient_id),
+                                  ",\"t\":", bepaald::toString(thread_recipient_id),
+                                  ",\"o\":", msg_info.incoming ? "0" : "1",
+                                  ",\"d\":", bepaald::toString(date_received / 1000 - 1404165600), // lose the last three digits (miliseconds, they are never displayed anyway).
+                                                                                                     // subtract "2014-07-01". Signals initial release was 2014-07-29, negative
+                                                                                                     // numbers should work otherwise anyway.
+                                  ",\"p\":", bepaald::toString(searchidx_page_idx),
+                                  ",\"n\":", bepaald::toString(pagenumber), "}");
+
+          if (htmlworkers.isWorker()) // page index is set when merging
           {
-            Logger::warning("Search_idx query failed or no results");
+            searchidx_worker_lines += line;
+            searchidx_worker_lines += '\n';
+          }
+          else if (shardedsearchindex)
+          {
+            if (!HTMLsearchIndexAdd(&searchidx_shards, line)) [[unlikely]]
+              return false;
           }
           else
           {
-            if (search_idx_results.rows() > 1) [[unlikely]]
-              Logger::warning("Unexpected number of results from search_idx query (", search_idx_results.rows(), " results, using first)");
-
-            std::string line = search_idx_results("line");
-            if (!line.empty()) [[likely]]
-            {
-              if (haslongbody && search_idx_results.valueAsInt(0, "rowid") != -1
-                  /* && search_idx_results.valueAsInt(0, "uniqueid") != -1*/)
-              {
-                long long int rowid = search_idx_results.valueAsInt(0, "rowid");
-                long long int uniqueid = search_idx_results.valueAsInt(0, "uniqueid");
-                AttachmentFrame *a = d_attachments.at({rowid, uniqueid}).get();
-                std::string longbody = std::string(reinterpret_cast<char *>(a->attachmentData(d_verbose)), a->attachmentSize());
-                a->clearData();
-
-                longbody = d_database.getSingleResultAs<std::string>("SELECT json_set(?, '$.b', ?)", {line, longbody}, std::string());
-                if (!longbody.empty()) [[likely]]
-                  line = std::move(longbody);
-              }
-
-              if (searchidx_write_started) [[likely]]
-                searchidx << ",\n";
-
-              searchidx << "  " << line;
-              searchidx_write_started = true;
-            }
+            if (searchidx_write_started) [[likely]]
+              searchidx << ",\n";
+
+            searchidx << "  " << line;
+            searchidx_write_started = true;
           }
         }
 
@@ -1025,20 +1036,137 @@ bool SignalBackup::exportHtml(std::string const &directory, std::vector<long lon
       if (messagecount >= messages.rows())
         break;
     }
+
+    if (workerresult.is_open())
+    {
+      // done <totalpages> <attachments deduplicated> <bytes not written>
+      // <number of recipients> <recipient_id>... (all recipients this worker has looked up)
+      // <size of search page name> <search page name>
+      // <search index lines>...
+      std::pair<uint64_t, uint64_t> linked(mediadedup ? mediadedup->linked() : std::pair<uint64_t, uint64_t>{0, 0});
+      workerresult << "done " << totalpages << ' ' << linked.first - linked_before.first << ' ' << linked.second - linked_before.second
+                   << '\n' << rid_recipientinfo_map.size();
+      for (auto const &ri : rid_recipientinfo_map)
+        workerresult << ' ' << ri.first;
+      workerresult << '\n' << searchidx_worker_page.size() << ' ' << searchidx_worker_page << '\n'
+                   << searchidx_worker_lines;
+      workerresult.close();
+      if (!workerresult) [[unlikely]]
+      {
+        Logger::error("Failed to write '", workerResultFile(t), "'");
+        return false;
+      }
+    }
   }
 
+  if (htmlworkers.isWorker())
+    htmlworkers.exitWorker(true);
+
+  if (htmlworkers.parallel())
+  {
+    bool workers_ok = htmlworkers.wait();
+
+    // merge the results, in the order the threads would have been exported in serially
+    std::set<long long int> worker_recipients;
+    for (long long int t : threads)
+    {
+      std::string resultfile(workerResultFile(t));
+      std::ifstream workerresult(WIN_LONGPATH(resultfile), std::ios_base::binary);
+      std::string status;
+      workerresult >> status;
+      if (status == "excluded")
+        excludethreads.push_back(t);
+      else if (status == "done")
+      {
+        int totalpages = 0;
+        uint64_t linkedfiles = 0;
+        uint64_t linkedbytes = 0;
+        workerresult >> totalpages >> linkedfiles >> linkedbytes;
+        if (mediadedup)
+          mediadedup->addLinked(linkedfiles, linkedbytes);
+        if (focusend)
+          thread_pagecount_map.emplace_hint(thread_pagecount_map.end(), t, totalpages);
+
+        unsigned int recipientcount = 0;
+        workerresult >> recipientcount;
+        for (unsigned int i = 0; i < recipientcount; ++i)
+        {
+          long long int rid = -1;
+          if (workerresult >> rid)
+            worker_recipients.insert(rid);
+        }
+
+        std::string::size_type pagenamesize = 0;
+        workerresult >> pagenamesize;
+        workerresult.get(); // skip ' '
+        std::string pagename(pagenamesize, '\0');
+        workerresult.read(pagename.data(), pagenamesize);
+
+        if (!pagename.empty())
+          searchidx_page_idx_map.emplace(pagename, ++searchidx_page_idx);
+
+        std::string line;
+        std::getline(workerresult, line); // rest of the page name line
+        while (std::getline(workerresult, line))
+        {
+          if (line.empty()) [[unlikely]]
+            continue;
+          // set the page index, the 'p' field is the last but one, after the body
+          if (std::string::size_type ppos = line.rfind(",\"p\":"); ppos != std::string::npos) [[likely]]
+          {
+            ppos += STRLEN(",\"p\":");
+            line.replace(ppos, line.find(',', ppos) - ppos, bepaald::toString(searchidx_page_idx));
+          }
+
+          if (shardedsearchindex)
+          {
+            if (!HTMLsearchIndexAdd(&searchidx_shards, line)) [[unlikely]]
+              workers_ok = false;
+            continue;
+          }
+
+          if (searchidx_write_started) [[likely]]
+            searchidx << ",\n";
+
+          searchidx << "  " << line;
+          searchidx_write_started = true;
+        }
+      }
+      workerresult.close();
+
+      std::error_code ec;
+      std::filesystem::remove(WIN_LONGPATH(resultfile), ec);
+    }
+
+    if (!workers_ok) [[unlikely]]
+    {
+      Logger::error("Failed to export one or more threads");
+      return false;
+    }
+
+    setRecipientInfo(worker_recipients, &rid_recipientinfo_map, &recipientmap);
+  }
+
+  if (mediadedup)
+    mediadedup->report();
+
   if (searchpage)
   {
-    if (searchidx_write_started) [[likely]]
+    if (shardedsearchindex)
+    {
+      if (!HTMLwriteSearchIndexShards(&searchidx_shards, searchidx)) [[unlikely]]
+        return false;
+    }
+    else if (searchidx_write_started) [[likely]]
       searchidx << "\n];\n";
 
     // write recipient info, maps recipient_ids to display name.
     searchidx << "recipient_idx = [\n";
     for (auto r = rid_recipientinfo_map.begin(); r != rid_recipientinfo_map.end(); ++r)
     {
-      std::string line = d_database.getSingleResultAs<std::string>("SELECT json_object('i', ?, 'dn', ?)", {r->first, r->second.display_name}, std::string());
-      if (line.empty()) [[unlikely]]
-        continue;
+      std::string line(bepaald::concat("{\"i\":", bepaald::toString(r->first), ",\"dn\":"));
+      bepaald::appendJsonString(&line, r->second.display_name);
+      line += '}';
       searchidx << "  " << line;
       if (std::next(r) != rid_recipientinfo_map.end()) [[likely]]
         searchidx << ",\n";
@@ -1050,9 +1178,9 @@ bool SignalBackup::exportHtml(std::string const &directory, std::vector<long lon
     searchidx << "page_idx = [\n";
     for (auto pi = searchidx_page_idx_map.begin() ; pi != searchidx_page_idx_map.end(); ++pi)
     {
-      std::string line = d_database.getSingleResultAs<std::string>("SELECT json_object('i', ?, 'f', ?)", {pi->second, pi->first}, std::string());
-      if (line.empty()) [[unlikely]]
-        continue;
+      std::string line(bepaald::concat("{\"i\":", bepaald::toString(pi->second), ",\"f\":"));
+      bepaald::appendJsonString(&line, pi->first);
+      line += '}';
       searchidx << "  " << line;
       if (std::next(pi) != searchidx_page_idx_map.end()) [[likely]]
         searchidx << ",\n";
@@ -1173,7 +1301,7 @@ bool SignalBackup::exportHtml(std::string const &directory, std::vector<long lon
                      overwrite, append, lighttheme, themeswitching, exportdetails_html, compact);
 
   if (searchpage)
-    HTMLwriteSearchpage(directory, lighttheme, themeswitching, compact);
+    HTMLwriteSearchpage(directory, lighttheme, themeswitching, compact, shardedsearchindex);
 
   if (stickerpacks)
     HTMLwriteStickerpacks(directory, overwrite, append, lighttheme, themeswitching, exportdetails_html);
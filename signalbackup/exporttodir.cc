@@ -19,7 +19,10 @@
 
 #include "signalbackup.ih"
 
-bool SignalBackup::exportBackupToDir(std::string const &directory, bool overwrite, bool keepattachmentdatainmemory, bool onlydb)
+#include "mediadedupindex.h"
+
+bool SignalBackup::exportBackupToDir(std::string const &directory, bool overwrite, bool keepattachmentdatainmemory, bool onlydb,
+                                     bool deduplicatemedia)
 {
   Logger::message("\nExporting backup into '", directory, "/'");
 
@@ -48,6 +51,7 @@ bool SignalBackup::exportBackupToDir(std::string const &directory, bool overwrit
 
     // export attachments
     Logger::message("Writing Attachments...");
+    std::unique_ptr<MediaDedupIndex> mediadedup(deduplicatemedia ? new MediaDedupIndex : nullptr);
     for (auto const &aframe : d_attachments)
     {
       AttachmentFrame *a = aframe.second.get();
@@ -65,38 +69,43 @@ bool SignalBackup::exportBackupToDir(std::string const &directory, bool overwrit
         continue;
       }
 
-      // write actual attachment:
-      std::ofstream attachmentstream(attachment_basefilename + ".bin", std::ios_base::binary);
-      if (!attachmentstream.is_open()) [[unlikely]]
+      // write actual attachment (or link it to an identical one written before):
+      if (keepattachmentdatainmemory && !a->attachmentData(d_verbose)) [[unlikely]]
+      {
+        Logger::error("Failed to retrieve attachment data for attachment (rowid: ", rowid, " uniqueid: ", uniqueid, ")");
+        exportok = false;
+        continue;
+      }
+
+      AttachmentFileResult result = writeAttachmentFile(a, attachment_basefilename + ".bin", mediadedup.get());
+      if (result == AttachmentFileResult::OPENFAILED) [[unlikely]]
       {
         Logger::error("Failed to open file for writing: ", directory, attachment_basefilename, ".bin");
         exportok = false;
         continue;
       }
-      else
+      else if (result == AttachmentFileResult::READFAILED) [[unlikely]]
       {
-        unsigned char const *data = a->attachmentData(d_verbose);
-        if (!data) [[unlikely]]
-        {
-          Logger::error("Failed to retrieve attachment data for attachment (rowid: ", rowid, " uniqueid: ", uniqueid, ")");
-          exportok = false;
-          continue;
-        }
-        if (!attachmentstream.write(reinterpret_cast<char const *>(data), a->attachmentSize())) [[unlikely]]
-        {
-          Logger::error("Failed write attachmentdata");
-          exportok = false;
-          continue;
-        }
+        Logger::error("Failed to retrieve attachment data for attachment (rowid: ", rowid, " uniqueid: ", uniqueid, ")");
+        exportok = false;
+        continue;
+      }
+      else if (result == AttachmentFileResult::WRITEFAILED) [[unlikely]]
+      {
+        Logger::error("Failed write attachmentdata");
+        exportok = false;
+        continue;
       }
 
-      if (!keepattachmentdatainmemory && a)
+      if (!keepattachmentdatainmemory) // don't keep the (streamed) data in memory
       {
         MEMINFO("BEFORE DROPPING ATTACHMENT DATA");
         a->clearData();
         MEMINFO("AFTER DROPPING ATTACHMENT DATA");
       }
     }
+    if (mediadedup)
+      mediadedup->report();
 
     // export avatars
     Logger::message("Writing Avatars...");
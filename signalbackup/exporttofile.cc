@@ -18,10 +18,13 @@
 */
 
 #include "signalbackup.ih"
+#include "frameencryptionqueue.h"
 
 #include "../common_filesystem.h"
 #include "../sqlstatementframe/sqlstatementframe.h"
 
+#include <numeric>
+
 bool SignalBackup::exportBackupToFile(std::string const &filename, std::string const &passphrase, bool overwrite, bool keepattachmentdatainmemory)
 {
   Logger::message("\nExporting backup to '", filename, "'");
@@ -52,6 +55,25 @@ bool SignalBackup::exportBackupToFile(std::string const &filename, std::string c
 
   std::ofstream outputfile(filename, std::ios_base::binary);
 
+  // with multiple threads, the frames are encrypted in parallel (and written in order)
+  std::unique_ptr<FrameEncryptionQueue> encryptionqueue;
+  if (d_threads > 1)
+  {
+    encryptionqueue.reset(new FrameEncryptionQueue(d_threads));
+    if (d_verbose) [[unlikely]]
+      Logger::message("Encrypting frames using ", d_threads, " threads");
+  }
+  auto writeframe = [&](BackupFrame *frame, bool cleardata = false)
+  {
+    if (encryptionqueue)
+      return queueEncryptedFrame(outputfile, frame, encryptionqueue.get(), cleardata);
+    if (!writeEncryptedFrame(outputfile, frame))
+      return false;
+    if (cleardata)
+      reinterpret_cast<FrameWithAttachment *>(frame)->clearData();
+    return true;
+  };
+
   // HEADER // Note: HeaderFrame is not encrypted.
   Logger::message("Writing HeaderFrame...");
   if (!d_headerframe)
@@ -77,7 +99,7 @@ bool SignalBackup::exportBackupToFile(std::string const &filename, std::string c
     Logger::error("DataBaseVersionFrame not found");
     return false;
   }
-  if (!writeEncryptedFrame(outputfile, d_databaseversionframe.get()))
+  if (!writeframe(d_databaseversionframe.get()))
     return false;
 
   // SQL DATABASE + ATTACHMENTS
@@ -86,8 +108,27 @@ bool SignalBackup::exportBackupToFile(std::string const &filename, std::string c
   // get and write schema
   SqliteDB::QueryResults results;
   d_database.exec("SELECT sql, name, type FROM sqlite_master WHERE sql NOT NULL", &results);
+
+  // if indexes were created out of order while reading the input file (see initFromFile()), and
+  // the schema has not been changed since, write the schema in the order of the input file.
+  std::vector<unsigned int> schemaorder(results.rows());
+  std::iota(schemaorder.begin(), schemaorder.end(), 0);
+  if (!d_schemaorder.empty() &&
+      d_database.getSingleResultAs<long long int>("PRAGMA schema_version", -1) == d_schemaorder_version)
+  {
+    std::map<std::string, unsigned int, std::less<>> originalpos;
+    for (unsigned int i = 0; i < d_schemaorder.size(); ++i)
+      originalpos.emplace(d_schemaorder[i], i);
+    auto posOf = [&](unsigned int row)
+    {
+      auto it = originalpos.find(results.valueAsString(row, 1));
+      return it != originalpos.end() ? it->second : d_schemaorder.size();
+    };
+    std::stable_sort(schemaorder.begin(), schemaorder.end(), [&](unsigned int lhs, unsigned int rhs) { return posOf(lhs) < posOf(rhs); });
+  }
+
   std::vector<std::string> tables;
-  for (unsigned int i = 0; i < results.rows(); ++i)
+  for (unsigned int i : schemaorder)
   {
     if (results.valueHasType<std::string>(i, 1) &&
         (results.getValueAs<std::string>(i, 1) != "sms_fts" &&
@@ -123,7 +164,7 @@ bool SignalBackup::exportBackupToFile(std::string const &filename, std::string c
     newframe.setStatementField(results.getValueAs<std::string>(i, 0));
 
     //std::cout << "Writing SqlStatementFrame..." << std::endl;
-    if (!writeEncryptedFrame(outputfile, &newframe))
+    if (!writeframe(&newframe))
       return false;
   }
 
@@ -148,41 +189,46 @@ bool SignalBackup::exportBackupToFile(std::string const &filename, std::string c
         STRING_STARTS_WITH(table, "sqlite_"))
       continue;
 
-    d_database.exec("SELECT * FROM " + table, &results);
+    // rows are streamed from the database one at a time, the count is only needed for the progress message
+    long long int rowcount = d_showprogress ? d_database.getSingleResultAs<long long int>("SELECT COUNT(*) FROM " + table, 0) : 0;
 
     if (!d_showprogress)
       Logger::message_start("  Dealing with table '", table, "'... ");
 
-    for (unsigned int i = 0; i < results.rows(); ++i)
+    bool needuniqqueid = (table == d_part_table) && d_database.tableContainsColumn(d_part_table, "unique_id");
+    bool tableok = true;
+    long long int i = 0;
+    bool queryok = d_database.forEachRow("SELECT * FROM " + table, [&](SqliteDB::RowView const &row)
     {
       if (d_showprogress)
-        Logger::message_overwrite("  Dealing with table '", table, "'... ", i + 1, "/", results.rows(), " entries...");
+        Logger::message_overwrite("  Dealing with table '", table, "'... ", i + 1, "/", rowcount, " entries...");
 
-      SqlStatementFrame newframe = buildSqlStatementFrame(table, results.row(i));
+      SqlStatementFrame newframe = buildSqlStatementFrame(table, row);
 
       //std::cout << "Writing SqlStatementFrame..." << std::endl;
-      if (!writeEncryptedFrame(outputfile, &newframe))
+      if (!writeframe(&newframe))
+      {
+        tableok = false;
         return false;
+      }
 
       if (table == d_part_table) // find corresponding attachment
       {
-        bool needuniqqueid = d_database.tableContainsColumn(d_part_table, "unique_id");
         long long int rowid = 0;
         long long int uniqueid = needuniqqueid ? 0 : -1;
-        for (unsigned int j = 0; j < results.columns(); ++j)
+        for (int j = 0; j < row.columns(); ++j)
         {
-          if (results.header(j) == "_id" && results.valueHasType<long long int>(i, j))
+          if (row.header(j) == "_id" && row.valueHasType<long long int>(j))
           {
-            rowid = results.getValueAs<long long int>(i, j);
+            rowid = row.getInt(j);
             if (rowid && (uniqueid || !needuniqqueid))
               break;
           }
           else if (needuniqqueid &&
-                   results.header(j) == "unique_id" &&
-                   results.valueHasType<long long int>(i, j))
+                   row.header(j) == "unique_id" &&
+                   row.valueHasType<long long int>(j))
           {
-            //std::cout << "UNIQUEID: " << std::any_cast<long long int>(results[i][j].second) << std::endl;
-            uniqueid = results.getValueAs<long long int>(i, j);
+            uniqueid = row.getInt(j);
             if (rowid && uniqueid)
               break;
           }
@@ -190,13 +236,10 @@ bool SignalBackup::exportBackupToFile(std::string const &filename, std::string c
         auto attachment = d_attachments.find({rowid, uniqueid});
         if (attachment != d_attachments.end()) [[likely]]
         {
-          if (!writeEncryptedFrame(outputfile, attachment->second.get()))
-            return false;
-          if (!keepattachmentdatainmemory)
+          if (!writeframe(attachment->second.get(), !keepattachmentdatainmemory))
           {
-            MEMINFO("BEFORE DROPPING ATTACHMENT DATA");
-            attachment->second.get()->clearData();
-            MEMINFO("AFTER DROPPING ATTACHMENT DATA");
+            tableok = false;
+            return false;
           }
         }
         else [[unlikely]]
@@ -205,37 +248,43 @@ bool SignalBackup::exportBackupToFile(std::string const &filename, std::string c
           {
             Logger::warning("Attachment data not found (rowid: ", rowid, ", uniqueid: ", uniqueid, ")");
             if (d_showprogress)
-              Logger::message_overwrite("  Dealing with table '", table, "'... ", i + 1, "/", results.rows(), " entries...");
+              Logger::message_overwrite("  Dealing with table '", table, "'... ", i + 1, "/", rowcount, " entries...");
           }
         }
       }
       else if (table == "sticker") // find corresponding sticker
       {
         uint64_t rowid = 0;
-        for (unsigned int j = 0; j < results.columns(); ++j)
-          if (results.header(j) == "_id" && results.valueHasType<long long int>(i, j))
+        for (int j = 0; j < row.columns(); ++j)
+          if (row.header(j) == "_id" && row.valueHasType<long long int>(j))
           {
-            rowid = results.getValueAs<long long int>(i, j);
+            rowid = row.getInt(j);
             break;
           }
         auto sticker = d_stickers.find(rowid);
         if (sticker != d_stickers.end())
         {
-          if (!writeEncryptedFrame(outputfile, sticker->second.get()))
+          if (!writeframe(sticker->second.get(), !keepattachmentdatainmemory))
+          {
+            tableok = false;
             return false;
-          if (!keepattachmentdatainmemory)
-            sticker->second.get()->clearData();
+          }
         }
         else
         {
           Logger::warning("Sticker data not found (rowid: ", rowid, ")");
           if (d_showprogress)
-            Logger::message_overwrite("  Dealing with table '", table, "'... ", i + 1, "/", results.rows(), " entries...");
+            Logger::message_overwrite("  Dealing with table '", table, "'... ", i + 1, "/", rowcount, " entries...");
         }
       }
-    }
+      ++i;
+      return true;
+    });
+    if (!queryok || !tableok) [[unlikely]]
+      return false;
+
     if (d_showprogress)
-      Logger::message_overwrite("  Dealing with table '", table, "'... ", results.rows(), "/", results.rows(), " entries...done", Logger::Control::ENDOVERWRITE);
+      Logger::message_overwrite("  Dealing with table '", table, "'... ", i, "/", rowcount, " entries...done", Logger::Control::ENDOVERWRITE);
     else
       Logger::message_end("done");
   }
@@ -243,13 +292,13 @@ bool SignalBackup::exportBackupToFile(std::string const &filename, std::string c
   Logger::message("Writing SharedPrefFrame(s)...");
   // SHAREDPREFS
   for (unsigned int i = 0; i < d_sharedpreferenceframes.size(); ++i)
-    if (!writeEncryptedFrame(outputfile, d_sharedpreferenceframes[i].get()))
+    if (!writeframe(d_sharedpreferenceframes[i].get()))
       return false;
 
   Logger::message("Writing KeyValueFrame(s)...");
   // KEYVALUES
   for (unsigned int i = 0; i < d_keyvalueframes.size(); ++i)
-    if (!writeEncryptedFrame(outputfile, d_keyvalueframes[i].get()))
+    if (!writeframe(d_keyvalueframes[i].get()))
       return false;
 
   // AVATAR
@@ -264,7 +313,7 @@ bool SignalBackup::exportBackupToFile(std::string const &filename, std::string c
       Logger::error_indent("THE PROGRAM WILL LIKELY CRASH NOW...");
     }
 
-    if (!writeEncryptedFrame(outputfile, a.second.get()))
+    if (!writeframe(a.second.get()))
       return false;
   }
 
@@ -275,9 +324,14 @@ bool SignalBackup::exportBackupToFile(std::string const &filename, std::string c
     Logger::error("EndFrame not found.");
     return false;
   }
-  if (!writeEncryptedFrame(outputfile, d_endframe.get()))
+  if (!writeframe(d_endframe.get()))
     return false;
 
+  // write whatever is still in the queue
+  while (encryptionqueue && !encryptionqueue->pending.empty())
+    if (!writeQueuedFrame(outputfile, encryptionqueue.get()))
+      return false;
+
   outputfile.flush();
 
   Logger::message("Done! Wrote ", outputfile.tellp(), " bytes.");
@@ -0,0 +1,53 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "signalbackup.h"
+#include "../threadpool/threadpool.h"
+
+#include <deque>
+#include <future>
+
+// Frames waiting to be written by exportBackupToFile, when it uses multiple
+// threads. The iv (counter) of each frame is assigned when it is queued, the
+// encryption (and mac) is done by the pool, and the frames are written to file
+// in the order they were queued.
+struct FrameEncryptionQueue
+{
+  struct Pending
+  {
+    std::future<std::pair<std::unique_ptr<unsigned char[]>, uint64_t>> frame;
+    std::future<std::pair<std::unique_ptr<unsigned char[]>, uint64_t>> attachment; // only valid() if frame has attachment data
+    FrameWithAttachment *clearafterwrite;                                           // drop its attachment data once written
+    uint64_t size;
+  };
+
+  // keep the workers busy, but limit the number of frames (and bytes) in memory
+  static uint64_t constexpr s_maxpendingbytes = 256 * 1024 * 1024;
+  unsigned int const maxpending;
+  uint64_t pendingbytes;
+  std::deque<Pending> pending;
+  ThreadPool pool; // declared last: workers are joined before anything else is destroyed
+
+  inline explicit FrameEncryptionQueue(unsigned int threads)
+    :
+    maxpending(threads * 64),
+    pendingbytes(0),
+    pool(threads)
+  {}
+};
@@ -32,16 +32,27 @@ long long int SignalBackup::getFreeDateForMessage(long long int targetdate, long
   //                                                                      "NOT EXISTS (SELECT * FROM message AS t2 WHERE t2." + d_mms_date_sent + " = t1." + d_mms_date_sent + " + 1 AND thread_id = ? AND from_recipient_id = ?) UNION "
   //                                                                      "SELECT ? FROM " + d_mms_table + " WHERE NOT EXISTS (SELECT * FROM " + d_mms_table + " WHERE " + d_mms_date_sent + " = ?))",
   //                                                                      {thread_id, from_recipient_id, targetdate, thread_id, from_recipient_id, targetdate, targetdate}, -1);
+  SqliteDB::Statement stmt(d_database.cachedStatement("SELECT " + d_mms_date_sent + " FROM " + d_mms_table + " WHERE thread_id = ? AND from_recipient_id = ? AND " + d_mms_date_sent + " = ?"));
+  if (!stmt.ok()) [[unlikely]] // as before, a failing query leaves the target date 'free'
+    return targetdate;
+
+  // the cached statement is re-bound for every candidate date. As with the
+  // getSingleResultAs() this replaces, a date only counts as taken when
+  // exactly one message has it
+  auto taken = [&](long long int date)
+  {
+    return stmt.bind(thread_id, from_recipient_id, date) && stmt.step() && !stmt.step();
+  };
+
   int incr = 0;
-  long long int freedate = -1;
-  while ((freedate = d_database.getSingleResultAs<long long int>("SELECT " + d_mms_date_sent + " FROM " + d_mms_table + " WHERE thread_id = ? AND from_recipient_id = ? AND " + d_mms_date_sent + " = ?",
-                                                                 {thread_id, from_recipient_id, targetdate + incr}, -1)) != -1 && incr < 1000)
+  bool datetaken = false;
+  while ((datetaken = taken(targetdate + incr)) && incr < 1000)
   {
-    //std::cout << "date: " << freedate << " was taken" << std::endl;
+    //std::cout << "date: " << targetdate + incr << " was taken" << std::endl;
     ++incr;
   }
 
-  if (freedate != -1)
+  if (datetaken)
     return -1;
 
   return targetdate + incr;
@@ -19,6 +19,47 @@
 
 #include "signalbackup.ih"
 
+std::vector<std::pair<unsigned int, unsigned int>> SignalBackup::HTMLgetEmojiPos(std::string_view str) const
+{
+  std::vector<std::pair<unsigned int, unsigned int>> results;
+
+  for (unsigned int c = 0; c < str.size(); ++c)
+  {
+    // check first byte, emoji begin with one of a few possible bytes,
+    // that are otherwise fairly rare in messages, find the first
+    // possible starting position.
+    if (static_cast<unsigned char>(str[c]) > 193U ||
+        (static_cast<unsigned char>(str[c]) < 58U && static_cast<unsigned char>(str[c]) > 47U) ||
+        static_cast<unsigned char>(str[c]) == 42U ||
+        static_cast<unsigned char>(str[c]) == 35U)
+    {
+      // now follow the trie as far as the string allows, the last emoji
+      // passed on the way is the longest one starting here
+      unsigned int node = 0;
+      unsigned int emoji_length = 0;
+      for (unsigned int i = c; i < str.size(); ++i)
+      {
+        EmojiTrieNode const *first = s_emoji_trie.data() + s_emoji_trie[node].firstchild;
+        EmojiTrieNode const *last = first + s_emoji_trie[node].children;
+        EmojiTrieNode const *child = std::lower_bound(first, last, static_cast<unsigned char>(str[i]),
+                                                      [](EmojiTrieNode const &n, unsigned char b) { return n.byte < b; });
+        if (child == last || child->byte != static_cast<unsigned char>(str[i]))
+          break;
+        node = child - s_emoji_trie.data();
+        if (child->length)
+          emoji_length = child->length;
+      }
+      if (emoji_length)
+      {
+        results.emplace_back(c, emoji_length);
+        c += emoji_length - 1;
+      }
+    }
+  }
+  return results;
+}
+
+/*
 std::vector<std::pair<unsigned int, unsigned int>> SignalBackup::HTMLgetEmojiPos(std::string_view str) const
 {
   std::vector<std::pair<unsigned int, unsigned int>> results;
@@ -60,6 +101,7 @@ std::vector<std::pair<unsigned int, unsigned int>> SignalBackup::HTMLgetEmojiPos
   }
   return results;
 }
+*/
 
 /*
 std::vector<std::pair<unsigned int, unsigned int>> SignalBackup::HTMLgetEmojiPos(std::string_view str) const
@@ -19,11 +19,9 @@
 
 #include "signalbackup.ih"
 
-#include "linkify_pattern.h"
+#include "linkifyscanner.h"
 #include "msgrange.h"
 
-#include "../common_regex.h"
-
 // this function does a best effort linkify of an input string
 // it does not currently recognize IPv6 addresses as possible
 // urls (http://[1fff:0:a88:85a3::ac1f]:8001/index.html).
@@ -37,54 +35,43 @@ void SignalBackup::HTMLLinkifyToken(std::string_view token, int tokenoffset, std
   if (d_verbose) [[unlikely]]
     Logger::message("Searching for possible URL in message body");
 
-  unsigned long long pos = 0; // to save position from start of string (only the suffix is passed to the search each iteration)
-  REGEX_SVMATCH_RESULTS url_match_result;
-  std::string_view::const_iterator start = token.begin();
-  while (start != token.end() && REGEX_SEARCH(start, token.end(), url_match_result, HTMLLinkify::pattern))
+  // the utf16 offsets of the matches are counted incrementally, the matches are
+  // found in order, so every character is only counted once
+  unsigned int utf8pos = 0;
+  long long int utf16pos = 0;
+  auto advance = [&](unsigned int to)
+  {
+    while (utf8pos < to)
+    {
+      utf16pos += utf16CharSize(token, utf8pos);
+      utf8pos += bytesToUtf8CharSize(token, utf8pos);
+    }
+    return utf16pos;
+  };
+
+  unsigned int pos = 0;
+  LinkifyScanner::Match match;
+  while (pos != token.size() && LinkifyScanner::search(token, pos, &match))
   {
-    // std::cout << "MATCH : " << url_match_result[0] << " (" << url_match_result.size() << " matches total)"
-    //           << " : " << pos + url_match_result.position(0) << " " << url_match_result.length(0) << std::endl;
-    // for (const auto &res : url_match_result)
-    //   std::cout << " : " << res.str() << std::endl;
-    // std::cout << std::endl;
-
-    // url_match_result.length(1) > 0 -> EMAIL
-    // url_match_result.length(2) > 0 -> URL_WITH_PROTOCOL
-    // url_match_result.length(3) > 0 -> URL_NO_PROTOCOL
-    unsigned int match_index = 0;
-    if (url_match_result.length(URL_WITH_PROTOCOL_MATCH) > 0)
-      match_index = URL_WITH_PROTOCOL_MATCH;
-    else if (url_match_result.length(URL_WITHOUT_PROTOCOL_MATCH) > 0)
-      match_index = URL_WITHOUT_PROTOCOL_MATCH;
-    else if (url_match_result.length(EMAIL_MATCH) > 0)
-      match_index = EMAIL_MATCH;
-    else [[unlikely]]
+    // std::cout << "MATCH : " << token.substr(match.position, match.length)
+    //           << " : " << match.position << " " << match.length << std::endl;
+
+    if (match.grouplength == 0) [[unlikely]]
     {
       Logger::warning("Unexpected match result while linkifying message body. Skipping.");
       return;
     }
+    int match_index = match.group;
 
     // get offset+length if string was utf16
-    long long int match_start = 0;
-    for (unsigned int i = 0; i < pos + url_match_result.position(match_index); )
-    {
-      int utf8size = bytesToUtf8CharSize(token, i);
-      match_start += utf16CharSize(token, i);
-      i += utf8size;
-    }
+    long long int match_start = advance(match.groupposition);
     //std::cout << "startpos : " << match_start << std::endl;
 
-    long long int match_length = 0;
-    for (unsigned int i = pos + url_match_result.position(match_index); i < pos + url_match_result.position(match_index) + url_match_result.length(match_index); )
-    {
-      int utf8size = bytesToUtf8CharSize(token, i);
-      match_length += utf16CharSize(token, i);
-      i += utf8size;
-    }
+    long long int match_length = advance(match.groupposition + match.grouplength) - match_start;
     //std::cout << "match length : " << match_length << std::endl;
 
 
-    std::string match_link(url_match_result.str(match_index));
+    std::string match_link(token.substr(match.groupposition, match.grouplength));
     /*
       This really shouldn't happen I think, but I have a link with multiple # signs
       in my backup. This is not valid, and causes the HTML to not be valid, so
@@ -179,8 +166,7 @@ void SignalBackup::HTMLLinkifyToken(std::string_view token, int tokenoffset, std
                            true);
 
 
-    pos   += url_match_result.position() + url_match_result.length(0);
-    start += url_match_result.position() + url_match_result.length(0);
+    pos = match.position + match.length;
   }
 }
 
@@ -189,9 +175,6 @@ void SignalBackup::HTMLLinkify(std::string const &body, std::vector<Range> *rang
   if (!HTMLpossibleLink(body)) [[likely]]
     return;
 
-#ifdef USE_BOOST_REGEX // the boost regex is (nanoseconds) slower when tokenizing
-  HTMLLinkifyToken(body, 0, ranges);
-#else
   // we tokenize on spaces. Spaces cannot be part of link, linkifying tokens is about twice as fast as whole lines...
   std::string_view body_view(body);
   std::string_view::size_type spos = 0, epos;
@@ -218,7 +201,6 @@ void SignalBackup::HTMLLinkify(std::string const &body, std::vector<Range> *rang
 
     spos = epos + 1;
   }
-#endif
 }
 
 /*
@@ -41,6 +41,8 @@ struct HTMLMessageInfo
   SqliteDB::QueryResults *poll;
   SqliteDB::QueryResults *poll_options;
   SqliteDB::QueryResults *poll_votes;
+  MediaDedupIndex *mediadedup; // nullptr if not deduplicating
+  AttachmentReadScheduler *readscheduler;
 
   long long int type;
   long long int expires_in;
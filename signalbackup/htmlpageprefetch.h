@@ -0,0 +1,54 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "signalbackup.h"
+
+#include <unordered_map>
+
+// The attachments, reactions, mentions, edits and polls of all messages on one
+// page of the html export, each loaded with a single query (instead of one
+// query per message). The results of every query have the message (or poll) id
+// they belong to in their first column, and are ordered by it.
+struct HTMLPagePrefetch
+{
+  struct Table
+  {
+    SqliteDB::QueryResults results;
+    std::unordered_map<long long int, std::pair<unsigned int, unsigned int>> rows; // id -> [first, last) row in results
+
+    // copies the rows belonging to 'id' (without the id column) to 'target'
+    inline void get(long long int id, SqliteDB::QueryResults *target) const
+    {
+      auto it = rows.find(id);
+      if (it == rows.end())
+        target->clear();
+      else
+        *target = results.getRows(it->second.first, it->second.second, 1);
+    }
+  };
+
+  Table attachments;
+  Table quote_attachments;
+  Table reactions;
+  Table mentions;
+  Table revisions;    // by original_message_id
+  Table polls;
+  Table poll_options; // by poll_id
+  Table poll_votes;   // by poll_id
+};
@@ -0,0 +1,145 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "signalbackup.ih"
+#include "htmlpageprefetch.h"
+
+// loads the attachments, reactions, mentions, edits and polls of messages
+// [first, last) of 'messages' (the message query of exportHtml). Only for
+// messages that have them (the same checks exportHtml does per message).
+bool SignalBackup::HTMLprefetchPage(SqliteDB::QueryResults const &messages, unsigned int first, unsigned int last,
+                                    HTMLPagePrefetch *prefetch) const
+{
+  bool has_revisions = d_database.tableContainsColumn(d_mms_table, "original_message_id") &&
+    d_database.tableContainsColumn(d_mms_table, "revision_number");
+
+  std::string attachment_ids;
+  std::string reaction_ids;
+  std::string mention_ids;
+  std::string original_ids;
+  std::string poll_message_ids;
+  std::string poll_ids;
+  auto addid = [](std::string *list, long long int id)
+  {
+    if (!list->empty())
+      list->push_back(',');
+    list->append(bepaald::toString(id));
+  };
+
+  for (unsigned int i = first; i < last; ++i)
+  {
+    long long int msg_id = messages.getValueAs<long long int>(i, "_id");
+    if (messages.valueAsInt(i, "attcount", 0) > 0)
+      addid(&attachment_ids, msg_id);
+    if (messages.valueAsInt(i, "reactioncount", 0) > 0)
+      addid(&reaction_ids, msg_id);
+    if (messages.valueAsInt(i, "mentioncount", 0) > 0)
+      addid(&mention_ids, msg_id);
+    if (has_revisions && messages.valueAsInt(i, "original_message_id") != -1)
+      addid(&original_ids, messages.valueAsInt(i, "original_message_id"));
+    if (messages.valueAsInt(i, "poll_id", -1) > -1)
+    {
+      addid(&poll_message_ids, msg_id);
+      addid(&poll_ids, messages.valueAsInt(i, "poll_id", -1));
+    }
+  }
+
+  // runs the query, and finds the rows belonging to each id
+  auto load = [&](std::string const &ids, std::string const &query, HTMLPagePrefetch::Table *table)
+  {
+    table->results.clear();
+    table->rows.clear();
+    if (ids.empty())
+      return true;
+
+    if (!d_database.exec(query, &table->results)) [[unlikely]]
+    {
+      Logger::error("Failed to load message data for html export");
+      return false;
+    }
+
+    for (unsigned int i = 0; i < table->results.rows(); ++i)
+    {
+      auto [it, inserted] = table->rows.try_emplace(table->results.getValueAs<long long int>(i, 0), i, i + 1);
+      if (!inserted)
+        it->second.second = i + 1;
+    }
+    return true;
+  };
+
+  auto attachmentquery = [&](int quote)
+  {
+    return bepaald::concat("SELECT ",
+                           d_part_table, ".", d_part_mid, " AS prefetch_id, ",
+                           d_part_table, "._id, ",
+                           (d_database.tableContainsColumn(d_part_table, "unique_id") ? "unique_id"s : "-1 AS unique_id"), ", ",
+                           d_part_ct, ", "
+                           "file_name, ",
+                           d_part_pending, ", ",
+                           (d_database.tableContainsColumn(d_part_table, "caption") ? "caption, "s : std::string()),
+                           "sticker_pack_id, ",
+                           d_mms_table, ".date_received AS date_received "
+                           "FROM ", d_part_table, " "
+                           "LEFT JOIN ", d_mms_table, " ON ", d_mms_table, "._id = ", d_part_table, ".", d_part_mid, " "
+                           "WHERE ", d_part_table, ".", d_part_mid, " IN (", attachment_ids, ") "
+                           "AND quote IS ", bepaald::toString(quote),
+                           " ORDER BY prefetch_id ASC, display_order ASC, ", d_part_table, "._id ASC");
+  };
+
+  return
+    load(attachment_ids, attachmentquery(0), &prefetch->attachments) &&
+    load(attachment_ids, attachmentquery(1), &prefetch->quote_attachments) &&
+    load(reaction_ids,
+         bepaald::concat("SELECT message_id AS prefetch_id, emoji, author_id, "
+                         "DATETIME(date_sent / 1000, 'unixepoch', 'localtime') AS 'date_sent', "
+                         "DATETIME(date_received / 1000, 'unixepoch', 'localtime') AS 'date_received' "
+                         "FROM reaction WHERE message_id IN (", reaction_ids, ") ORDER BY message_id ASC, _id ASC"),
+         &prefetch->reactions) &&
+    load(mention_ids,
+         bepaald::concat("SELECT message_id AS prefetch_id, recipient_id, range_start, range_length "
+                         "FROM mention WHERE message_id IN (", mention_ids, ") ORDER BY message_id ASC, _id ASC"),
+         &prefetch->mentions) &&
+    // a revision belongs to the original message itself, and all messages
+    // that have it as their original
+    load(original_ids,
+         bepaald::concat("SELECT _id AS prefetch_id, _id, body, date_received, ", d_mms_date_sent, ", revision_number FROM ", d_mms_table,
+                         " WHERE _id IN (", original_ids, ") "
+                         "UNION ALL "
+                         "SELECT original_message_id AS prefetch_id, _id, body, date_received, ", d_mms_date_sent, ", revision_number FROM ", d_mms_table,
+                         " WHERE original_message_id IN (", original_ids, ") "
+                         "ORDER BY prefetch_id ASC, ", d_mms_date_sent, " ASC, _id ASC"),
+         &prefetch->revisions) &&
+    // poll: _id, author_id, message_id, question, allow_multiple_votes, end_message_id
+    // poll_option: _id, poll_id, option_text, option_order
+    // poll_vote: _id, poll_id, poll_option_id, voter_id, vote_count, date_received, vote_state
+    load(poll_message_ids,
+         bepaald::concat("SELECT message_id AS prefetch_id, question, allow_multiple_votes, end_message_id "
+                         "FROM poll WHERE message_id IN (", poll_message_ids, ") ORDER BY message_id ASC, _id ASC"),
+         &prefetch->polls) &&
+    load(poll_ids,
+         bepaald::concat("SELECT poll_id AS prefetch_id, _id, option_text "
+                         "FROM poll_option WHERE poll_id IN (", poll_ids, ") ORDER BY poll_id ASC, option_order ASC, _id ASC"),
+         &prefetch->poll_options) &&
+    // poll_state: NONE = 0, PENDING_REMOVE = 1, PENDING_ADD = 2, REMOVED = 3, ADDED = 4,
+    // not sure what to do with 0, 1, and 2 (but not sure if they can appear in a backup at all).
+    load(poll_ids,
+         bepaald::concat("SELECT poll_id AS prefetch_id, poll_option_id, voter_id, vote_count, date_received "
+                         "FROM poll_vote WHERE poll_id IN (", poll_ids, ") AND vote_state = 4 ORDER BY poll_id ASC, _id ASC"),
+         &prefetch->poll_votes);
+}
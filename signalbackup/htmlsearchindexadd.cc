@@ -0,0 +1,109 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "signalbackup.ih"
+#include "htmlsearchindexshards.h"
+
+#include "../common_filesystem.h"
+
+// adds one line of the search index (a json object, with the message body in
+// its 'b' field) to the sharded index.
+bool SignalBackup::HTMLsearchIndexAdd(HTMLSearchIndexShards *shards, std::string const &line) const
+{
+  // write the line itself to the current messages-file
+  if (shards->messages % HTMLSearchIndexShards::s_chunksize == 0)
+  {
+    if (shards->chunk.is_open())
+    {
+      shards->chunk << "\n]);\n";
+      shards->chunk.close();
+    }
+
+    unsigned int chunknum = shards->messages / HTMLSearchIndexShards::s_chunksize;
+    std::string filename(bepaald::concat(shards->directory, "/messages_", bepaald::toString(chunknum), ".js"));
+    shards->chunk.open(WIN_LONGPATH(filename), std::ios_base::binary);
+    if (!shards->chunk.is_open()) [[unlikely]]
+    {
+      Logger::error("Failed to open '", filename, "' for writing");
+      return false;
+    }
+    shards->chunk << "searchidx_add_messages(" << chunknum << ", [\n";
+  }
+  else
+    shards->chunk << ",\n";
+  shards->chunk << "  " << line;
+
+  // split the body into words. A word is a run of ascii letters and digits, and
+  // any non-ascii characters. Ascii is lowercased, everything else is kept as is
+  // (searchpage.html does the same to the search terms).
+  // The body is still json-escaped here, but that is no problem: escaped
+  // characters ('"', '\' and control characters) all separate words anyway.
+  std::string::size_type pos = line.find(",\"b\":\"");
+  if (pos != std::string::npos) [[likely]]
+  {
+    auto addword = [&](std::string *word)
+    {
+      if (word->empty())
+        return;
+      std::string shard; // hex of the first two bytes
+      for (unsigned int i = 0; i < word->size() && i < 2; ++i)
+      {
+        shard.push_back("0123456789abcdef"[static_cast<unsigned char>((*word)[i]) >> 4]);
+        shard.push_back("0123456789abcdef"[static_cast<unsigned char>((*word)[i]) & 0xf]);
+      }
+      auto addposting = [&](std::string const &s)
+      {
+        std::vector<unsigned int> &postings = shards->tokens[s][*word];
+        if (postings.empty() || postings.back() != shards->messages) // only once per message
+          postings.push_back(shards->messages);
+      };
+      addposting(shard);
+
+      // words with characters that uppercase to (something containing) an ascii
+      // letter are also put in a separate shard. A case insensitive search compares
+      // uppercased strings, so these can match words in a different shard.
+      if (std::any_of(std::begin(HTMLSearchIndexShards::s_uppercase_to_ascii), std::end(HTMLSearchIndexShards::s_uppercase_to_ascii),
+                      [&](std::string_view c) { return word->find(c) != std::string::npos; })) [[unlikely]]
+        addposting("special");
+      word->clear();
+    };
+
+    std::string word;
+    for (pos += STRLEN(",\"b\":\""); pos < line.size() && line[pos] != '"'; ++pos)
+    {
+      unsigned char c = static_cast<unsigned char>(line[pos]);
+      if (c == '\\') [[unlikely]]
+      {
+        addword(&word);
+        if (++pos < line.size() && line[pos] == 'u')
+          pos += 4;
+      }
+      else if (c >= 0x80 || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z'))
+        word.push_back(c);
+      else if (c >= 'A' && c <= 'Z')
+        word.push_back(c + ('a' - 'A'));
+      else
+        addword(&word);
+    }
+    addword(&word);
+  }
+
+  ++shards->messages;
+  return true;
+}
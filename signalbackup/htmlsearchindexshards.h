@@ -0,0 +1,51 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "signalbackup.h"
+
+#include <fstream>
+#include <map>
+#include <string_view>
+#include <vector>
+
+// The search index of the html export, split over many small files in
+// '<exportdir>/searchidx/':
+//  - messages_N.js, the message entries (the same as in the normal
+//    'message_idx'), s_chunksize per file. Message n is in file n / s_chunksize.
+//  - tokens_XXXX.js, an inverted index: for every word, the numbers of the
+//    messages containing it. Words are split over the files by their first two
+//    (utf-8) bytes (XXXX, in hex). Words containing any of s_uppercase_to_ascii are
+//    also in tokens_special.js.
+// The files are loaded by searchpage.html through <script>-tags, so no server is
+// needed to view the export.
+struct HTMLSearchIndexShards
+{
+  static unsigned int constexpr s_chunksize = 2000;
+  // the characters that, uppercased, contain an ascii letter (from Unicode's SpecialCasing.txt,
+  // plus the dotless i and long s): "\u00df" -> "SS", "\ufb01" -> "FI", ...
+  static std::string_view constexpr s_uppercase_to_ascii[] = {"\xc3\x9f", "\xc4\xb1", "\xc5\x89", "\xc5\xbf", "\xc7\xb0",
+                                                             "\xe1\xba\x96", "\xe1\xba\x97", "\xe1\xba\x98", "\xe1\xba\x99", "\xe1\xba\x9a",
+                                                             "\xef\xac\x80", "\xef\xac\x81", "\xef\xac\x82", "\xef\xac\x83", "\xef\xac\x84",
+                                                             "\xef\xac\x85", "\xef\xac\x86"};
+
+  std::string directory;
+  std::ofstream chunk;
+  unsigned int messages;
+  std::map<std::string, std::map<std::string, std::vector<unsigned int>>> tokens; // [shard][word] -> message numbers
+};
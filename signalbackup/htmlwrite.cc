@@ -2443,7 +2443,8 @@ file << R"(
 void SignalBackup::HTMLwriteAttachmentDiv(std::ofstream &htmloutput, SqliteDB::QueryResults const &attachment_results, int indent,
                                           std::string const &directory, std::string const &threaddir, bool use_original_filenames,
                                           bool is_image_preview, bool isquote, bool overwrite, bool append,
-                                          std::vector<std::string> const &ignoremediatypes) const
+                                          std::vector<std::string> const &ignoremediatypes, MediaDedupIndex *mediadedup,
+                                          AttachmentReadScheduler *readscheduler) const
 {
   for (unsigned int a = 0; a < attachment_results.rows(); ++a)
   {
@@ -2512,7 +2513,8 @@ void SignalBackup::HTMLwriteAttachmentDiv(std::ofstream &htmloutput, SqliteDB::Q
     }
 
     // write the attachment data
-    if (!HTMLwriteAttachment(directory, threaddir, rowid, uniqueid, attachment_filename_on_disk, attachment_results.valueAsInt(a, "date_received", -1), overwrite, append))
+    if (!HTMLwriteAttachment(directory, threaddir, rowid, uniqueid, attachment_filename_on_disk, attachment_results.valueAsInt(a, "date_received", -1), overwrite, append,
+                             mediadedup, readscheduler))
       continue;
 
     if (use_original_filenames)
@@ -2588,7 +2590,8 @@ void SignalBackup::HTMLwriteAttachmentDiv(std::ofstream &htmloutput, SqliteDB::Q
 }
 
 void SignalBackup::HTMLwriteSharedContactDiv(std::ofstream &htmloutput, std::string const &shared_contact, int indent,
-                                             std::string const &directory, std::string const &threaddir, bool overwrite, bool append) const
+                                             std::string const &directory, std::string const &threaddir, bool overwrite, bool append,
+                                             MediaDedupIndex *mediadedup, AttachmentReadScheduler *readscheduler) const
 {
   if (d_database.getSingleResultAs<long long int>("SELECT json_array_length(?, '$')", shared_contact, 0) > 0)
   {
@@ -2612,7 +2615,7 @@ void SignalBackup::HTMLwriteSharedContactDiv(std::ofstream &htmloutput, std::str
     if (rowid >= 0 && uniqueid >= 0)
     {
       // write the attachment data
-      HTMLwriteAttachment(directory, threaddir, rowid, uniqueid, extension, -1, overwrite, append);
+      HTMLwriteAttachment(directory, threaddir, rowid, uniqueid, extension, -1, overwrite, append, mediadedup, readscheduler);
     }
 
     // prefer phone number
@@ -2819,7 +2822,7 @@ void SignalBackup::HTMLwriteMessage(std::ofstream &htmloutput, HTMLMessageInfo c
       HTMLwriteAttachmentDiv(htmloutput, *msg_info.quote_attachment_results, 16 + extraindent,
                              msg_info.directory, msg_info.threaddir, msg_info.orig_filename,
                              false /* is image_preview */, true /*isquote*/,msg_info.overwrite,
-                             msg_info.append, ignoremediatypes);
+                             msg_info.append, ignoremediatypes, msg_info.mediadedup, msg_info.readscheduler);
       htmloutput << "                </div>\n";
     }
 
@@ -2829,7 +2832,8 @@ void SignalBackup::HTMLwriteMessage(std::ofstream &htmloutput, HTMLMessageInfo c
   // insert attachment?
   if (!msg_info.shared_contacts.empty()) [[likely]] // if we have an attachment with a shared contact, it's an avatar
     HTMLwriteSharedContactDiv(htmloutput, msg_info.shared_contacts, 12 + extraindent,
-                              msg_info.directory, msg_info.threaddir, msg_info.overwrite, msg_info.append);
+                              msg_info.directory, msg_info.threaddir, msg_info.overwrite, msg_info.append, msg_info.mediadedup,
+                              msg_info.readscheduler);
   else if (STRING_STARTS_WITH(msg_info.link_preview_url, "https://signal.link/call/#key=")) [[unlikely]]
     HTMLwriteCallLinkDiv(htmloutput, 12 + extraindent, msg_info.link_preview_url, msg_info.link_preview_title,
                          msg_info.link_preview_description/*, msg_info.directory, msg_info.threaddir, msg_info.overwrite,
@@ -2838,7 +2842,8 @@ void SignalBackup::HTMLwriteMessage(std::ofstream &htmloutput, HTMLMessageInfo c
     HTMLwriteAttachmentDiv(htmloutput, *msg_info.attachment_results, 12 + extraindent,
                            msg_info.directory, msg_info.threaddir, msg_info.orig_filename,
                            (!msg_info.link_preview_title.empty() || !msg_info.link_preview_description.empty()), // is linkpreview
-                           false /*isquote*/, msg_info.overwrite, msg_info.append, ignoremediatypes);
+                           false /*isquote*/, msg_info.overwrite, msg_info.append, ignoremediatypes, msg_info.mediadedup,
+                           msg_info.readscheduler);
 
   if (msg_info.poll_options->rows()) [[unlikely]]
     HTMLwritePollDiv(htmloutput, 12 + extraindent, recipient_info, *msg_info.poll, *msg_info.poll_options, *msg_info.poll_votes);
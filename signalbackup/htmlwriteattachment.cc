@@ -22,11 +22,14 @@
 #include <cerrno>
 
 #include "../common_filesystem.h"
+#include "mediadedupindex.h"
+#include "../attachmentreadscheduler/attachmentreadscheduler.h"
 
 bool SignalBackup::HTMLwriteAttachment(std::string const &directory, std::string const &threaddir,
                                        long long int rowid, long long int uniqueid, //std::string const &ext,
                                        std::string const &attachment_filename, long long int timestamp,
-                                       bool overwrite, bool append) const
+                                       bool overwrite, bool append, MediaDedupIndex *mediadedup,
+                                       AttachmentReadScheduler *readscheduler) const
 {
 
   auto attachmentfound = d_attachments.find({rowid, uniqueid});
@@ -70,9 +73,11 @@ bool SignalBackup::HTMLwriteAttachment(std::string const &directory, std::string
 
   AttachmentFrame *a = attachmentfound->second.get();
 
-  // write actual attachment:
-  std::ofstream attachmentstream(WIN_LONGPATH(attachment_filename_full), std::ios_base::binary);
-  if (!attachmentstream.is_open())
+  // write actual attachment (or link it to an identical one written before):
+  if (readscheduler)
+    readscheduler->reading(a);
+  AttachmentFileResult result = writeAttachmentFile(a, attachment_filename_full, mediadedup);
+  if (result == AttachmentFileResult::OPENFAILED)
   {
     Logger::error("Failed to open file for writing: '", attachment_filename_full, "'",
                   " (errno: ", std::strerror(errno), ")"); // note: errno is not required to be set by std
@@ -88,18 +93,15 @@ bool SignalBackup::HTMLwriteAttachment(std::string const &directory, std::string
     }
     return false;
   }
-  else
-  {
-    if (!attachmentstream.write(reinterpret_cast<char *>(a->attachmentData(d_verbose)), a->attachmentSize()))
-      return false;
-    // write was succesfull. drop attachment data
-    a->clearData();
+  else if (result == AttachmentFileResult::READFAILED || result == AttachmentFileResult::WRITEFAILED)
+    return false;
 
-    attachmentstream.close(); // need to close, or the auto-close will change files mtime again.
+  // write was succesfull. drop attachment data (if it was in memory)
+  a->clearData();
 
-    if (timestamp >= 0)
-      if (!setFileTimeStamp(attachment_filename_full, timestamp)) [[unlikely]]
-        Logger::warning("Failed to set timestamp for attachment '", attachment_filename_full, "'");
-  }
+  // a hard link shares its timestamp with the first copy
+  if (timestamp >= 0 && result != AttachmentFileResult::HARDLINKED)
+    if (!setFileTimeStamp(attachment_filename_full, timestamp)) [[unlikely]]
+      Logger::warning("Failed to set timestamp for attachment '", attachment_filename_full, "'");
   return true;
 }
@@ -182,6 +182,8 @@ void SignalBackup::HTMLwriteRevision(long long int msg_id, std::ofstream &filt,
                             &poll,
                             &poll_options,
                             &poll_votes,
+                            parent_info.mediadedup,
+                            parent_info.readscheduler,
 
                             type,
                             expires_in,
@@ -0,0 +1,75 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "signalbackup.ih"
+#include "htmlsearchindexshards.h"
+
+#include "../common_filesystem.h"
+
+// finishes the last messages-file, writes all tokens-files, and the
+// information needed to find them to 'searchidx' (searchidx.js)
+bool SignalBackup::HTMLwriteSearchIndexShards(HTMLSearchIndexShards *shards, std::ofstream &searchidx) const
+{
+  if (shards->chunk.is_open())
+  {
+    shards->chunk << "\n]);\n";
+    shards->chunk.close();
+  }
+
+  searchidx << "message_idx = null;\n"
+            << "message_idx_chunks = " << (shards->messages + HTMLSearchIndexShards::s_chunksize - 1) / HTMLSearchIndexShards::s_chunksize << ";\n"
+            << "message_idx_chunksize = " << HTMLSearchIndexShards::s_chunksize << ";\n"
+            << "token_shards = [";
+
+  bool ok = true;
+  for (auto s = shards->tokens.begin(); s != shards->tokens.end(); ++s)
+  {
+    std::string filename(bepaald::concat(shards->directory, "/tokens_", s->first, ".js"));
+    std::ofstream shardfile(WIN_LONGPATH(filename), std::ios_base::binary);
+    if (!shardfile.is_open()) [[unlikely]]
+    {
+      Logger::error("Failed to open '", filename, "' for writing");
+      ok = false;
+      continue;
+    }
+
+    shardfile << "searchidx_add_tokens(\"" << s->first << "\", {\n";
+    for (auto w = s->second.begin(); w != s->second.end(); ++w)
+    {
+      std::string line("  ");
+      bepaald::appendJsonString(&line, w->first);
+      line += ":[";
+      for (unsigned int i = 0; i < w->second.size(); ++i)
+      {
+        if (i > 0) [[likely]]
+          line += ',';
+        line += bepaald::toString(w->second[i]);
+      }
+      line += ']';
+      shardfile << line << (std::next(w) != s->second.end() ? ",\n" : "\n");
+    }
+    shardfile << "});\n";
+
+    searchidx << (s != shards->tokens.begin() ? "," : "") << "\"" << s->first << "\"";
+  }
+  searchidx << "];\n";
+
+  shards->tokens.clear();
+  return ok;
+}
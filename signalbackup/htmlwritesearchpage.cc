@@ -21,7 +21,7 @@
 
 #include "../common_filesystem.h"
 
-void SignalBackup::HTMLwriteSearchpage(std::string const &dir, bool light, bool themeswitching, bool compact) const
+void SignalBackup::HTMLwriteSearchpage(std::string const &dir, bool light, bool themeswitching, bool compact, bool shardedindex) const
 {
 
   Logger::message("Writing searchpage.html...");
@@ -552,7 +552,126 @@ body {
       var nextbutton = document.getElementById("searchnext");
       var firstbutton = document.getElementById("searchfirst");
       var lastbutton = document.getElementById("searchlast");
+)";
+
+  if (shardedindex)
+  {
+    // the index is split into many small files (see HTMLSearchIndexShards), only the
+    // ones needed for a search are loaded (as scripts, so this works from file://)
+    outputfile <<
+      R"(
+      var loaded_scripts = {};
+      var message_chunks = [];
+      var token_shard_data = {};
+
+      function searchidx_add_messages(n, messages)
+      {
+        message_chunks[n] = messages;
+      }
+
+      function searchidx_add_tokens(shard, tokens)
+      {
+        token_shard_data[shard] = tokens;
+      }
+
+      function loadScript(src)
+      {
+        if (!loaded_scripts[src])
+          loaded_scripts[src] = new Promise(function(resolve)
+          {
+            var script = document.createElement('script');
+            script.src = src;
+            script.onload = resolve;
+            script.onerror = resolve;
+            document.head.append(script);
+          });
+        return loaded_scripts[src];
+      }
+
+      function loadMessages(numbers)
+      {
+        var chunks = new Set(numbers.map(n => Math.floor(n / message_idx_chunksize)));
+        return Promise.all(Array.from(chunks, c => loadScript('searchidx/messages_' + c + '.js'))).then(
+          () => numbers.map(n => message_chunks[Math.floor(n / message_idx_chunksize)][n % message_idx_chunksize]));
+      }
+
+      /* the words of the search term, split like the index was (runs of ascii letters and
+         digits and non-ascii characters, with ascii lowercased). The first word of the term
+         may start anywhere in a word of the message, and the last one may end anywhere */
+      function searchWords(term)
+      {
+        var words = [];
+        for (const m of term.matchAll(/[0-9A-Za-z\u0080-\uffff]+/g))
+          words.push({word: m[0].replace(/[A-Z]/g, c => c.toLowerCase()),
+                      openstart: m.index === 0,
+                      openend: m.index + m[0].length === term.length});
+        return words;
+      }
+
+      function shardKey(word)
+      {
+        return Array.from(new TextEncoder().encode(word).slice(0, 2), b => b.toString(16).padStart(2, '0')).join('');
+      }
 
+      /* does a word of a message (token) match a word of the search term (w), the
+         same way search() compares them */
+      function tokenMatches(token, w, case_sensitive)
+      {
+        var t = case_sensitive ? token : token.toUpperCase();
+        var s = case_sensitive ? w.word : w.word.toUpperCase();
+        if (w.openstart && w.openend)
+          return t.includes(s);
+        if (w.openstart)
+          return t.endsWith(s);
+        if (w.openend)
+          return t.startsWith(s);
+        return t === s;
+      }
+
+      /* returns (a promise of) the messages that might match term: those containing a
+         matching word for every word of the search term. The actual search is done on these */
+      function getCandidates(term, regex, case_sensitive)
+      {
+        var words = [];
+        if (!regex)
+          /* the index only ignores case of ascii letters */
+          words = searchWords(term).filter(w => case_sensitive || !/[^\u0000-\u007f]/.test(w.word) || w.word.toLowerCase() === w.word.toUpperCase());
+
+        /* the first word can be anywhere inside a word of the message, so it is found in
+           any shard. Only use it if there is nothing else: a term that is a single word
+           loads all token shards (but still only the message chunks with candidates) */
+        if (words.some(w => !w.openstart))
+          words = words.filter(w => !w.openstart);
+
+        if (words.length === 0) /* the index can not help, load everything */
+          return loadMessages(Array.from({length: message_idx_chunks * message_idx_chunksize}, (_, n) => n)).then(m => m.filter(msg => msg !== undefined));
+
+        /* words with characters that become ascii letters when uppercased (the German sharp
+           s becomes "SS") are in the 'special' shard as well */
+        var shards = words.map(w => w.openstart ? token_shards :
+                               token_shards.filter(s => s.startsWith(shardKey(w.word)) || (!case_sensitive && s === 'special')));
+        return Promise.all(Array.from(new Set(shards.flat()), s => loadScript('searchidx/tokens_' + s + '.js'))).then(function()
+        {
+          var candidates = null;
+          for (let w = 0; w < words.length; ++w)
+          {
+            var matches = new Set();
+            for (const s of shards[w])
+              for (const [token, postings] of Object.entries(token_shard_data[s] || {}))
+                if (tokenMatches(token, words[w], case_sensitive))
+                  for (const p of postings)
+                    if (candidates === null || candidates.has(p))
+                      matches.add(p);
+            candidates = matches;
+          }
+          return loadMessages(Array.from(candidates).sort((a, b) => a - b));
+        });
+      }
+)";
+  }
+
+  outputfile <<
+    R"(
       /* fill recipient selection list */
       recipient_idx.sort((a, b) => (a.dn > b.dn));
       for (i = 0; i < recipient_idx.length; ++i)
@@ -668,7 +787,25 @@ body {
     {
       searchstr = document.getElementById('search_field').value;
       if (!searchstr || searchstr.length === 0)
-        return;
+        return;)code";
+
+  if (shardedindex)
+    outputfile <<
+      R"code(
+      var regex = document.getElementById('enable_regex').checked;
+      var case_sensitive = document.getElementById('enable_case_sensitive').checked;
+      getCandidates(searchstr, regex, case_sensitive).then(function(candidates)
+      {
+        global_results = search(candidates, searchstr, regex, case_sensitive);
+        global_searchstring = searchstr;
+        global_page = 0;
+        showResults(case_sensitive);
+      });
+    }
+)code";
+  else
+    outputfile <<
+      R"code(
       /*start = performance.now();*/
       global_results = search(message_idx, searchstr, document.getElementById('enable_regex').checked, document.getElementById('enable_case_sensitive').checked);
       /*end = performance.now();*/
@@ -677,7 +814,10 @@ body {
       global_page = 0;
       showResults(document.getElementById('enable_case_sensitive').checked);
     }
+)code";
 
+  outputfile <<
+    R"code(
     function search(obj, term, regex, case_sensitive)
     {
       var mindate = 0;
@@ -31,9 +31,6 @@ bool SignalBackup::importFromAdbBackup(std::unique_ptr<AdbBackupDatabase> const
     return false;
   }
 
-  adbdb->d_db.setCacheSize(15);
-  d_database.setCacheSize(15);
-
   // get all conversations
   SqliteDB::QueryResults thread_results;
   if (!adbdb->d_db.exec("SELECT _id, recipient_ids FROM thread", &thread_results))
@@ -24,7 +24,6 @@
 
 #include "../messagerangeproto_typedef/messagerangeproto_typedef.h"
 #include "../protobufparser/protobufparser.h"
-#include "../scopeguard/scopeguard.h"
 
 //#include <chrono>
 
@@ -37,12 +36,6 @@ bool SignalBackup::importFromDesktop(std::unique_ptr<DesktopDatabase> const &dtd
 
   //auto t1 = std::chrono::high_resolution_clock::now();
 
-  dtdb->d_database.setCacheSize(55); // seems to shave a few ms off. not exhaustively tested
-  ScopeGuard reset_cache_size_dt([&]() { dtdb->d_database.setCacheSize(); });
-
-  d_database.setCacheSize(40); // same
-  ScopeGuard reset_cache_size_android([&]() { d_database.setCacheSize(); });
-
   if (d_verbose) [[unlikely]]
     Logger::message("Starting importFromDesktop()");
 
@@ -1195,7 +1195,7 @@ table|sender_keys|sender_keys|71|CREATE TABLE sender_keys (_id INTEGER PRIMARY K
       // }
 
       SqlStatementFrame newframe = buildSqlStatementFrame(table, results.headers(), results.row(i));
-      d_database.exec(newframe.bindStatementView(), newframe.parametersView());
+      execSqlStatementFrame(newframe);
       //newframe.printInfo();
     }
     Logger::message_end(" ...done");
@@ -50,6 +50,10 @@ void SignalBackup::initFromFile()
 
   std::unique_ptr<BackupFrame> frame;
 
+  // (non-unique) indexes are only created after all data is inserted, building them in one go is much faster than
+  // updating them for every row. Stored with the number of schema entries that were present when they were encountered.
+  std::vector<std::pair<std::string, long long int>> deferredindexes;
+
   d_database.exec("BEGIN TRANSACTION");
 
   // get frames and handle them until file is fully read or error is encountered
@@ -68,11 +72,11 @@ void SignalBackup::initFromFile()
       if (d_verbose) [[unlikely]]
         Logger::message_overwrite("FRAME ", frame->frameNumber(), ": ",
                                   std::fixed, std::setprecision(2), std::setw(5), std::setfill('0'),
-                                  (static_cast<float>(backupfile.tellg() * 100) / totalsize), std::defaultfloat, "%...");
+                                  (static_cast<float>(d_fd->position(backupfile) * 100) / totalsize), std::defaultfloat, "%...");
       else
         Logger::message_overwrite("Reading backup file: ",
                                   std::fixed, std::setprecision(2), std::setw(5), std::setfill('0'),
-                                  (static_cast<float>(backupfile.tellg() * 100) / totalsize), std::defaultfloat, "%...");
+                                  (static_cast<float>(d_fd->position(backupfile) * 100) / totalsize), std::defaultfloat, "%...");
       old_time = new_time;
     }
 
@@ -91,7 +95,9 @@ void SignalBackup::initFromFile()
         // we lazily do not check for them here, since we are dealing with official exported files which do not contain
         // these tables as they are excluded on the export-side as well. Additionally, the official import should be able
         // to properly deal with them anyway (that is: ignore them)
-        if (!d_database.exec(s->bindStatementView(), s->parametersView())) [[unlikely]]
+        if (STRING_STARTS_WITH(s->bindStatementView(), "CREATE INDEX ") && s->parameterCount() == 0)
+          deferredindexes.emplace_back(s->bindStatementView(), d_database.getSingleResultAs<long long int>("SELECT COUNT(*) FROM sqlite_master", 0));
+        else if (!execSqlStatementFrame(*s)) [[unlikely]]
           Logger::warning("Failed to execute statement: ", s->statement());
       }
 #ifdef BUILT_FOR_TESTING
@@ -177,6 +183,9 @@ void SignalBackup::initFromFile()
     }
   }
 
+  if (!deferredindexes.empty())
+    createDeferredIndexes(deferredindexes);
+
   d_database.exec("COMMIT");
 
   if (!d_badattachments.empty()) [[unlikely]]
@@ -198,7 +207,7 @@ void SignalBackup::initFromFile()
     addEndFrame();
   }
 
-  if (backupfile.tellg() == totalsize && d_showprogress) [[likely]]
+  if (d_fd->position(backupfile) == static_cast<uint64_t>(totalsize) && d_showprogress) [[likely]]
     Logger::message_overwrite("Reading backup file:", " 100.0%... done!", Logger::Control::ENDOVERWRITE);
 
   d_ok = setColumnNames();
@@ -20,7 +20,7 @@
 // Modified (slightly) from The Android Open Source Project
 // (https://android.googlesource.com/platform/frameworks/base/+/refs/heads/main/core/java/android/util/Patterns.java)
 
-#include "../common_regex.h"
+#include <string_view>
 
 #define IANA_TOP_LEVEL_DOMAINS "(?:"                                    \
     "(?:aaa|aarp|abb|abbott|abogado|academy|accenture|accountant|accountants|aco|active" \
@@ -229,7 +229,10 @@
 
 namespace HTMLLinkify
 {
-  static REGEX const pattern("(?:" EMAIL_PATTERN "|" WEB_URL_WITH_PROTOCOL "|" WEB_URL_WITHOUT_PROTOCOL ")", REGEX_FLAGS);
+  // the full pattern, "(?:" EMAIL_PATTERN "|" WEB_URL_WITH_PROTOCOL "|" WEB_URL_WITHOUT_PROTOCOL ")"
+  // (case insensitive), is no longer compiled into a regex. It is matched by
+  // LinkifyScanner (linkifyscanner.h), which only needs the list of top level domains.
+  inline constexpr std::string_view top_level_domains{IANA_TOP_LEVEL_DOMAINS};
 }
 
 static int constexpr EMAIL_MATCH{1};
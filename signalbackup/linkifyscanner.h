@@ -0,0 +1,585 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef LINKIFYSCANNER_H_
+#define LINKIFYSCANNER_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "linkify_pattern.h"
+
+// A hand written matcher for the linkify pattern (see linkify_pattern.h):
+//
+//   (?:EMAIL_PATTERN|WEB_URL_WITH_PROTOCOL|WEB_URL_WITHOUT_PROTOCOL) (case insensitive)
+//
+// search() returns exactly what std::regex_search() would for that pattern:
+// every part of the pattern is matched by a function taking a continuation
+// (the rest of the pattern), alternatives are tried in order and repetitions
+// greedily, backtracking when the continuation fails, just like an ECMAScript
+// regex does. It is a lot faster because it only tries the alternatives that can
+// possibly match at a position, and does not have to run a generic (and in
+// the case of std::regex, notoriously slow) regex engine over a huge pattern.
+class LinkifyScanner
+{
+ public:
+  struct Match
+  {
+    unsigned int position; // the full match (including the word boundary characters)
+    unsigned int length;
+    int group;             // EMAIL_MATCH, URL_WITH_PROTOCOL_MATCH or URL_WITHOUT_PROTOCOL_MATCH
+    unsigned int groupposition;
+    unsigned int grouplength;
+  };
+
+ private:
+  // one of the alternatives of IANA_TOP_LEVEL_DOMAINS, a sequence of
+  // (lowercase) characters, where the last one may be a set ("a[cdefg]")
+  struct TopLevelDomain
+  {
+    std::string_view literal;
+    std::string_view lastset;
+  };
+
+  std::string_view d_str;
+  unsigned int d_searchstart; // '^' matches here
+  unsigned int d_groupstart;
+  unsigned int d_groupend;
+  unsigned int d_matchend;
+
+ public:
+  inline static bool search(std::string_view str, unsigned int from, Match *match);
+
+ private:
+  inline LinkifyScanner(std::string_view str, unsigned int from);
+
+  inline static std::vector<std::vector<TopLevelDomain>> const &topLevelDomains();
+
+  inline static bool isLabelChar(unsigned char c);
+  inline static bool isEmailChar(unsigned char c);
+  inline static bool isAlnum(unsigned char c);
+  inline static bool isDigit(unsigned char c);
+  inline static bool isHex(unsigned char c);
+  inline static bool isWordChar(unsigned char c);
+  inline static bool isSpace(unsigned char c);
+  inline static bool isUserInfoChar(unsigned char c);
+  inline static bool isPathChar(unsigned char c);
+  inline static unsigned char lower(unsigned char c);
+  inline bool at(unsigned int pos, char c) const;
+  inline bool atNoCase(unsigned int pos, std::string_view lowercase) const;
+
+  template <typename Pred, typename K>
+  inline bool repeat(unsigned int pos, unsigned int min, unsigned int max, Pred pred, K const &k) const;
+  template <typename Unit, typename K>
+  inline bool repeatUnits(unsigned int pos, unsigned int min, unsigned int max, Unit unit, K const &k) const;
+
+  template <typename K>
+  inline bool wordBoundary(unsigned int pos, K const &k) const;
+  template <typename K>
+  inline bool email(unsigned int pos, K const &k) const;
+  template <typename K>
+  inline bool label(unsigned int pos, K const &k) const;
+  template <typename K>
+  inline bool relaxedLabels(unsigned int pos, K const &k) const;
+  template <typename K>
+  inline bool strictLabels(unsigned int pos, K const &k) const;
+  template <typename K>
+  inline bool topLevelDomain(unsigned int pos, K const &k) const;
+  template <typename K>
+  inline bool octet(unsigned int pos, int which, K const &k) const;
+  template <typename K>
+  inline bool ipAddress(unsigned int pos, K const &k) const;
+  template <typename K>
+  inline bool protocol(unsigned int pos, K const &k) const;
+  template <typename K>
+  inline bool userInfo(unsigned int pos, K const &k) const;
+  template <typename K>
+  inline bool port(unsigned int pos, K const &k) const;
+  template <typename K>
+  inline bool path(unsigned int pos, K const &k) const;
+  template <typename K>
+  inline bool optional(unsigned int pos, K const &k, bool (LinkifyScanner::*part)(unsigned int, K const &) const) const;
+
+  inline bool urlWithProtocol(unsigned int pos);
+  inline bool urlWithoutProtocol(unsigned int pos);
+};
+
+inline LinkifyScanner::LinkifyScanner(std::string_view str, unsigned int from)
+  :
+  d_str(str),
+  d_searchstart(from),
+  d_groupstart(0),
+  d_groupend(0),
+  d_matchend(0)
+{}
+
+// finds the first match in str[from, end), positions are relative to the start of str
+inline bool LinkifyScanner::search(std::string_view str, unsigned int from, Match *match) // static
+{
+  LinkifyScanner scanner(str, from);
+
+  // quick checks (memchr), nothing can match without a '.' or "://", and
+  // none of the alternatives can match without the one of these they require
+  bool maybe_protocol = str.find("://", from) != std::string_view::npos;
+  bool maybe_domain = str.find('.', from) != std::string_view::npos;
+  if (!maybe_protocol && !maybe_domain) [[likely]]
+    return false;
+  bool maybe_email = maybe_domain && str.find('@', from) != std::string_view::npos;
+
+  unsigned int emailrun_end = from; // end of the current run of EMAIL-characters
+  for (unsigned int pos = from; pos <= str.size(); ++pos)
+  {
+    // EMAIL: [...]{1,256}\@..., the '@' must directly follow the run of
+    // characters starting here, which must not be longer than 256.
+    if (maybe_email)
+    {
+      if (emailrun_end < pos)
+        emailrun_end = pos;
+      while (emailrun_end < str.size() && isEmailChar(str[emailrun_end]))
+        ++emailrun_end;
+      if (emailrun_end > pos && emailrun_end - pos <= 256 && scanner.at(emailrun_end, '@') &&
+          scanner.email(pos, [&](unsigned int end) { scanner.d_groupstart = pos; scanner.d_groupend = end; scanner.d_matchend = end; return true; }))
+      {
+        *match = {pos, scanner.d_matchend - pos, EMAIL_MATCH, scanner.d_groupstart, scanner.d_groupend - scanner.d_groupstart};
+        return true;
+      }
+    }
+
+    // both url alternatives start with a word boundary: a non-label character,
+    // or the start or end of the searched string.
+    if (pos < str.size() && isLabelChar(str[pos]) && pos != from) [[likely]]
+      continue;
+
+    if (maybe_protocol && scanner.urlWithProtocol(pos))
+    {
+      *match = {pos, scanner.d_matchend - pos, URL_WITH_PROTOCOL_MATCH, scanner.d_groupstart, scanner.d_groupend - scanner.d_groupstart};
+      return true;
+    }
+
+    if (maybe_domain && scanner.urlWithoutProtocol(pos))
+    {
+      *match = {pos, scanner.d_matchend - pos, URL_WITHOUT_PROTOCOL_MATCH, scanner.d_groupstart, scanner.d_groupend - scanner.d_groupstart};
+      return true;
+    }
+  }
+  return false;
+}
+
+// the alternatives of IANA_TOP_LEVEL_DOMAINS, in order, grouped by first letter.
+inline std::vector<std::vector<LinkifyScanner::TopLevelDomain>> const &LinkifyScanner::topLevelDomains() // static
+{
+  static std::vector<std::vector<TopLevelDomain>> const tlds = []()
+  {
+    // the pattern is only a list of nested non-capturing groups of alternatives,
+    // the nesting does not change the order in which they are tried.
+    static std::string const pattern = []()
+    {
+      std::string p;
+      std::string_view src(HTMLLinkify::top_level_domains);
+      for (unsigned int i = 0; i < src.size(); ++i)
+      {
+        if (src.substr(i, 3) == "(?:")
+          i += 2;
+        else if (src[i] == ')')
+          continue;
+        else if (src[i] == '\\') // escaped '-'
+          p += src[++i];
+        else
+          p += lower(src[i]);
+      }
+      return p;
+    }();
+
+    std::vector<std::vector<TopLevelDomain>> result(256);
+    std::string_view all(pattern);
+    while (!all.empty())
+    {
+      std::string_view::size_type bar = all.find('|');
+      std::string_view alt = all.substr(0, bar);
+      all.remove_prefix(bar == std::string_view::npos ? all.size() : bar + 1);
+
+      TopLevelDomain tld{alt, {}};
+      if (std::string_view::size_type bracket = alt.find('['); bracket != std::string_view::npos)
+      {
+        tld.literal = alt.substr(0, bracket);
+        tld.lastset = alt.substr(bracket + 1, alt.size() - bracket - 2);
+      }
+      result[static_cast<unsigned char>(alt[0])].push_back(tld);
+    }
+    return result;
+  }();
+  return tlds;
+}
+
+inline bool LinkifyScanner::isLabelChar(unsigned char c) // static
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c >= 0x80;
+}
+
+inline bool LinkifyScanner::isEmailChar(unsigned char c) // static
+{
+  return isAlnum(c) || c == '+' || c == '.' || c == '_' || c == '%' || c == '-';
+}
+
+inline bool LinkifyScanner::isAlnum(unsigned char c) // static
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+inline bool LinkifyScanner::isDigit(unsigned char c) // static
+{
+  return c >= '0' && c <= '9';
+}
+
+inline bool LinkifyScanner::isHex(unsigned char c) // static
+{
+  return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+inline bool LinkifyScanner::isWordChar(unsigned char c) // static
+{
+  return isAlnum(c) || c == '_';
+}
+
+inline bool LinkifyScanner::isSpace(unsigned char c) // static
+{
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+inline bool LinkifyScanner::isUserInfoChar(unsigned char c) // static
+{
+  switch (c)
+  {
+    case '$': case '-': case '_': case '.': case '+': case '!': case '*': case '\'':
+    case '(': case ')': case ',': case ';': case '?': case '&': case '=':
+      return true;
+    default:
+      return isAlnum(c);
+  }
+}
+
+inline bool LinkifyScanner::isPathChar(unsigned char c) // static
+{
+  switch (c)
+  {
+    case ';': case '/': case '?': case ':': case '@': case '&': case '=': case '#': case '~':
+    case '-': case '.': case '+': case '!': case '*': case '\'': case '(': case ')': case ',': case '_':
+      return true;
+    default:
+      return isLabelChar(c);
+  }
+}
+
+inline unsigned char LinkifyScanner::lower(unsigned char c) // static
+{
+  return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+inline bool LinkifyScanner::at(unsigned int pos, char c) const
+{
+  return pos < d_str.size() && d_str[pos] == c;
+}
+
+inline bool LinkifyScanner::atNoCase(unsigned int pos, std::string_view lowercase) const
+{
+  if (pos + lowercase.size() > d_str.size())
+    return false;
+  for (unsigned int i = 0; i < lowercase.size(); ++i)
+    if (lower(d_str[pos + i]) != static_cast<unsigned char>(lowercase[i]))
+      return false;
+  return true;
+}
+
+// [pred]{min,max}, greedy
+template <typename Pred, typename K>
+inline bool LinkifyScanner::repeat(unsigned int pos, unsigned int min, unsigned int max, Pred pred, K const &k) const
+{
+  unsigned int count = 0;
+  while (count < max && pos + count < d_str.size() && pred(d_str[pos + count]))
+    ++count;
+  for (++count; count-- > min; )
+    if (k(pos + count))
+      return true;
+  return false;
+}
+
+// (?:...){min,max}, greedy, for groups that can match in only one way at any
+// position ('unit' returns the length of that match, or 0)
+template <typename Unit, typename K>
+inline bool LinkifyScanner::repeatUnits(unsigned int pos, unsigned int min, unsigned int max, Unit unit, K const &k) const
+{
+  std::vector<unsigned int> ends{pos};
+  unsigned int len = 0;
+  while (ends.size() - 1 < max && (len = unit(ends.back())) > 0)
+    ends.push_back(ends.back() + len);
+  for (unsigned int count = ends.size(); count-- > min; )
+    if (k(ends[count]))
+      return true;
+  return false;
+}
+
+// (?:[^LABEL_CHAR]|$|^)
+template <typename K>
+inline bool LinkifyScanner::wordBoundary(unsigned int pos, K const &k) const
+{
+  if (pos < d_str.size() && !isLabelChar(d_str[pos]) && k(pos + 1))
+    return true;
+  if (pos == d_str.size() && k(pos))
+    return true;
+  return pos == d_searchstart && k(pos);
+}
+
+// [a-zA-Z0-9\+\._\%\-\+]{1,256}\@[a-zA-Z0-9][a-zA-Z0-9\-]{0,64}(?:\.[a-zA-Z0-9][a-zA-Z0-9\-]{0,25})+
+template <typename K>
+inline bool LinkifyScanner::email(unsigned int pos, K const &k) const
+{
+  auto alnumdash = [](unsigned char c) { return isAlnum(c) || c == '-'; };
+  auto subdomain = [&](unsigned int p) -> unsigned int
+  {
+    if (!at(p, '.') || p + 1 >= d_str.size() || !isAlnum(d_str[p + 1]))
+      return 0;
+    unsigned int count = 0;
+    while (count < 25 && p + 2 + count < d_str.size() && alnumdash(d_str[p + 2 + count]))
+      ++count;
+    return 2 + count;
+  };
+  // note subdomain() always takes the longest match. Backtracking into it can not lead
+  // to another '.' (for the next subdomain), and nothing follows it in the pattern
+  // that could match anything but the empty string (k is only the end of the match).
+
+  return repeat(pos, 1, 256, isEmailChar, [&](unsigned int p)
+  {
+    if (!at(p, '@') || p + 1 >= d_str.size() || !isAlnum(d_str[p + 1]))
+      return false;
+    return repeat(p + 2, 0, 64, alnumdash, [&](unsigned int q)
+    {
+      return repeatUnits(q, 1, -1, subdomain, k);
+    });
+  });
+}
+
+// IRI_LABEL: [LABEL_CHAR](?:[LABEL_CHAR_\-]{0,61}[LABEL_CHAR]){0,1}
+template <typename K>
+inline bool LinkifyScanner::label(unsigned int pos, K const &k) const
+{
+  if (pos >= d_str.size() || !isLabelChar(d_str[pos]))
+    return false;
+
+  if (repeat(pos + 1, 0, 61, [](unsigned char c) { return isLabelChar(c) || c == '_' || c == '-'; },
+             [&](unsigned int p) { return p < d_str.size() && isLabelChar(d_str[p]) && k(p + 1); }))
+    return true;
+  return k(pos + 1);
+}
+
+// (?:IRI_LABEL(?:\.(?=\S))?)+
+template <typename K>
+inline bool LinkifyScanner::relaxedLabels(unsigned int pos, K const &k) const
+{
+  return label(pos, [&](unsigned int p)
+  {
+    auto more = [&](unsigned int q) { return relaxedLabels(q, k) || k(q); };
+    if (at(p, '.') && p + 1 < d_str.size() && !isSpace(d_str[p + 1]) && more(p + 1))
+      return true;
+    return more(p);
+  });
+}
+
+// (?:IRI_LABEL\.)+
+template <typename K>
+inline bool LinkifyScanner::strictLabels(unsigned int pos, K const &k) const
+{
+  return label(pos, [&](unsigned int p)
+  {
+    return at(p, '.') && (strictLabels(p + 1, k) || k(p + 1));
+  });
+}
+
+// (?:IANA_TOP_LEVEL_DOMAINS|xn\-\-[\w\-]{0,58}\w)
+template <typename K>
+inline bool LinkifyScanner::topLevelDomain(unsigned int pos, K const &k) const
+{
+  if (pos >= d_str.size())
+    return false;
+
+  for (TopLevelDomain const &tld : topLevelDomains()[lower(d_str[pos])])
+  {
+    if (!atNoCase(pos, tld.literal))
+      continue;
+    unsigned int end = pos + tld.literal.size();
+    if (!tld.lastset.empty())
+    {
+      if (end >= d_str.size() || tld.lastset.find(static_cast<char>(lower(d_str[end]))) == std::string_view::npos)
+        continue;
+      ++end;
+    }
+    if (k(end))
+      return true;
+  }
+
+  // punycode
+  return atNoCase(pos, "xn--") &&
+    repeat(pos + 4, 0, 58, [](unsigned char c) { return isWordChar(c) || c == '-'; },
+           [&](unsigned int p) { return p < d_str.size() && isWordChar(d_str[p]) && k(p + 1); });
+}
+
+// the alternatives for the parts of an IP_ADDRESS
+//  which == 0 : 25[0-5]|2[0-4][0-9]|[0-1][0-9]{2}|[1-9][0-9]|[1-9]
+//  which == 1 : 25[0-5]|2[0-4][0-9]|[0-1][0-9]{2}|[1-9][0-9]|[1-9]|0
+//  which == 2 : 25[0-5]|2[0-4][0-9]|[0-1][0-9]{2}|[1-9][0-9]|[0-9]
+template <typename K>
+inline bool LinkifyScanner::octet(unsigned int pos, int which, K const &k) const
+{
+  auto digit = [&](unsigned int p, char min, char max) { return p < d_str.size() && d_str[p] >= min && d_str[p] <= max; };
+
+  if (at(pos, '2') && at(pos + 1, '5') && digit(pos + 2, '0', '5') && k(pos + 3))
+    return true;
+  if (at(pos, '2') && digit(pos + 1, '0', '4') && digit(pos + 2, '0', '9') && k(pos + 3))
+    return true;
+  if (digit(pos, '0', '1') && digit(pos + 1, '0', '9') && digit(pos + 2, '0', '9') && k(pos + 3))
+    return true;
+  if (digit(pos, '1', '9') && digit(pos + 1, '0', '9') && k(pos + 2))
+    return true;
+  if (which == 2)
+    return digit(pos, '0', '9') && k(pos + 1);
+  if (digit(pos, '1', '9') && k(pos + 1))
+    return true;
+  return which == 1 && at(pos, '0') && k(pos + 1);
+}
+
+// IP_ADDRESS
+template <typename K>
+inline bool LinkifyScanner::ipAddress(unsigned int pos, K const &k) const
+{
+  return octet(pos, 0, [&](unsigned int p1)
+  {
+    return at(p1, '.') && octet(p1 + 1, 1, [&](unsigned int p2)
+    {
+      return at(p2, '.') && octet(p2 + 1, 1, [&](unsigned int p3)
+      {
+        return at(p3, '.') && octet(p3 + 1, 2, k);
+      });
+    });
+  });
+}
+
+// (?:http|https|rtsp|ftp):\/\/
+template <typename K>
+inline bool LinkifyScanner::protocol(unsigned int pos, K const &k) const
+{
+  for (std::string_view p : {"http", "https", "rtsp", "ftp"})
+    if (atNoCase(pos, p) && atNoCase(pos + p.size(), "://") && k(pos + p.size() + 3))
+      return true;
+  return false;
+}
+
+// USER_INFO: (?:[...]|(?:\%[a-fA-F0-9]{2})){1,64}(?:\:(?:[...]|(?:\%[a-fA-F0-9]{2})){1,25})?\@
+template <typename K>
+inline bool LinkifyScanner::userInfo(unsigned int pos, K const &k) const
+{
+  // '%' is not in the set, so only one of the two alternatives can match
+  auto unit = [&](unsigned int p) -> unsigned int
+  {
+    if (p < d_str.size() && isUserInfoChar(d_str[p]))
+      return 1;
+    if (at(p, '%') && p + 2 < d_str.size() && isHex(d_str[p + 1]) && isHex(d_str[p + 2]))
+      return 3;
+    return 0;
+  };
+
+  return repeatUnits(pos, 1, 64, unit, [&](unsigned int p)
+  {
+    if (at(p, ':') && repeatUnits(p + 1, 1, 25, unit, [&](unsigned int q) { return at(q, '@') && k(q + 1); }))
+      return true;
+    return at(p, '@') && k(p + 1);
+  });
+}
+
+// PORT_NUMBER: \:\d{1,5}
+template <typename K>
+inline bool LinkifyScanner::port(unsigned int pos, K const &k) const
+{
+  return at(pos, ':') && repeat(pos + 1, 1, 5, isDigit, k);
+}
+
+// PATH_AND_QUERY: \/(?:(?:[...])|(?:\%[a-fA-F0-9]{2}))*
+template <typename K>
+inline bool LinkifyScanner::path(unsigned int pos, K const &k) const
+{
+  // '%' is not in the set, so only one of the two alternatives can match
+  auto unit = [&](unsigned int p) -> unsigned int
+  {
+    if (p < d_str.size() && isPathChar(d_str[p]))
+      return 1;
+    if (at(p, '%') && p + 2 < d_str.size() && isHex(d_str[p + 1]) && isHex(d_str[p + 2]))
+      return 3;
+    return 0;
+  };
+  return at(pos, '/') && repeatUnits(pos + 1, 0, -1, unit, k);
+}
+
+// (?:part)?
+template <typename K>
+inline bool LinkifyScanner::optional(unsigned int pos, K const &k, bool (LinkifyScanner::*part)(unsigned int, K const &) const) const
+{
+  return (this->*part)(pos, k) || k(pos);
+}
+
+// (?:WORD_BOUNDARY((?:(?:PROTOCOL(?:USER_INFO)?)(?:RELAXED_DOMAIN_NAME)?(?:PORT_NUMBER)?)(?:PATH_AND_QUERY)?)WORD_BOUNDARY)
+inline bool LinkifyScanner::urlWithProtocol(unsigned int pos)
+{
+  return wordBoundary(pos, [&](unsigned int start)
+  {
+    auto end = [&](unsigned int p)
+    {
+      return wordBoundary(p, [&](unsigned int e) { d_groupstart = start; d_groupend = p; d_matchend = e; return true; });
+    };
+    auto afterport = [&](unsigned int p) { return path(p, end) || end(p); };
+    auto afterdomain = [&](unsigned int p) { return port(p, afterport) || afterport(p); };
+    auto afteruserinfo = [&](unsigned int p)
+    {
+      // RELAXED_DOMAIN_NAME: (?:(?:IRI_LABEL(?:\.(?=\S))?)+|IP_ADDRESS)
+      return relaxedLabels(p, afterdomain) || ipAddress(p, afterdomain) || afterdomain(p);
+    };
+    return protocol(start, [&](unsigned int p) { return userInfo(p, afteruserinfo) || afteruserinfo(p); });
+  });
+}
+
+// (?:WORD_BOUNDARY(?!:\/\/)((?:(?:STRICT_DOMAIN_NAME)(?:PORT_NUMBER)?)(?:PATH_AND_QUERY)?)WORD_BOUNDARY)
+inline bool LinkifyScanner::urlWithoutProtocol(unsigned int pos)
+{
+  return wordBoundary(pos, [&](unsigned int start)
+  {
+    if (atNoCase(start, "://"))
+      return false;
+
+    auto end = [&](unsigned int p)
+    {
+      return wordBoundary(p, [&](unsigned int e) { d_groupstart = start; d_groupend = p; d_matchend = e; return true; });
+    };
+    auto afterport = [&](unsigned int p) { return path(p, end) || end(p); };
+    auto afterdomain = [&](unsigned int p) { return port(p, afterport) || afterport(p); };
+
+    // STRICT_DOMAIN_NAME: (?:(?:IRI_LABEL\.)+STRICT_TLD|IP_ADDRESS)
+    return strictLabels(start, [&](unsigned int p) { return topLevelDomain(p, afterdomain); }) ||
+      ipAddress(start, afterdomain);
+  });
+}
+
+#endif
@@ -23,9 +23,19 @@
 
 #include "../common_filesystem.h"
 
-bool SignalBackup::makeFilenameUnique(std::string const &path, std::string *file_or_dir) const
+// if 'reserved' is set, it holds the files (and dirs) that are going to be
+// created, and is checked instead of the filesystem. The new name is added to
+// it. On case-insensitive filesystems, the set should ignore case as well.
+bool SignalBackup::makeFilenameUnique(std::string const &path, std::string *file_or_dir, ReservedFilenames *reserved) const
 {
-  while (bepaald::fileOrDirExists(bepaald::concat(path, "/", *file_or_dir)))
+  auto exists = [&]()
+  {
+    if (reserved)
+      return reserved->find(bepaald::concat(path, "/", *file_or_dir)) != reserved->end();
+    return bepaald::fileOrDirExists(bepaald::concat(path, "/", *file_or_dir));
+  };
+
+  while (exists())
   {
     //std::cout << std::endl << "File exists: " << path << "/" << file_or_dir << " -> ";
 
@@ -47,6 +57,8 @@ bool SignalBackup::makeFilenameUnique(std::string const &path, std::string *file
     //std::cout << file_or_dir << std::endl;
   }
 
+  if (reserved)
+    reserved->insert(bepaald::concat(path, "/", *file_or_dir));
   return true;
 
 }
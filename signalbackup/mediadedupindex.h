@@ -0,0 +1,209 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEDIADEDUPINDEX_H_
+#define MEDIADEDUPINDEX_H_
+
+#include "../common_filesystem.h"
+
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+// The attachments written by an export (--deduplicatemedia), by size and
+// sha256 of their (decrypted) data. An attachment whose data was written
+// before is linked to that first copy, instead of being written again. Linking
+// tries a reflink (copy-on-write clone, an independent file sharing the data on
+// disk) first, and falls back to a hard link. Safe to use from multiple threads.
+struct MediaDedupIndex
+{
+  using Hash = std::array<unsigned char, SHA256_DIGEST_LENGTH>;
+
+  // hashes attachment data while it is passed to a sink
+  class Hasher
+  {
+    std::unique_ptr<EVP_MD_CTX, decltype(&::EVP_MD_CTX_free)> d_ctx;
+    bool d_ok;
+   public:
+    inline Hasher();
+    inline bool update(unsigned char const *data, uint64_t size);
+    inline bool final(Hash *hash);
+  };
+
+  enum class Link
+  {
+    CLONED,
+    HARDLINKED,
+    FAILED
+  };
+
+ private:
+  std::map<uint64_t, std::vector<std::pair<Hash, std::string>>> d_files; // size -> (hash, path of first copy)
+  std::mutex d_mutex;
+  uint64_t d_linkedfiles;
+  uint64_t d_linkedbytes;
+
+ public:
+  inline MediaDedupIndex();
+  inline bool hasSize(uint64_t size);
+  inline std::string find(uint64_t size, Hash const &hash);
+  inline void add(uint64_t size, Hash const &hash, std::string const &path);
+  inline Link link(std::string const &original, std::string const &path, uint64_t size);
+  inline std::pair<uint64_t, uint64_t> linked();
+  inline void addLinked(uint64_t files, uint64_t bytes);
+  inline void report();
+
+ private:
+  inline static bool cloneFile(std::string const &source, std::string const &target);
+};
+
+inline MediaDedupIndex::Hasher::Hasher()
+  :
+  d_ctx(EVP_MD_CTX_new(), &::EVP_MD_CTX_free),
+  d_ok(d_ctx && EVP_DigestInit_ex(d_ctx.get(), EVP_sha256(), nullptr) == 1)
+{}
+
+inline bool MediaDedupIndex::Hasher::update(unsigned char const *data, uint64_t size)
+{
+  return (d_ok = d_ok && EVP_DigestUpdate(d_ctx.get(), data, size) == 1);
+}
+
+inline bool MediaDedupIndex::Hasher::final(Hash *hash)
+{
+  return d_ok && EVP_DigestFinal_ex(d_ctx.get(), hash->data(), nullptr) == 1;
+}
+
+inline MediaDedupIndex::MediaDedupIndex()
+  :
+  d_linkedfiles(0),
+  d_linkedbytes(0)
+{}
+
+// if no earlier attachment has this size, there is no need to hash before writing
+inline bool MediaDedupIndex::hasSize(uint64_t size)
+{
+  std::lock_guard<std::mutex> lock(d_mutex);
+  return d_files.find(size) != d_files.end();
+}
+
+// returns the path of the first copy of this data, or an empty string
+inline std::string MediaDedupIndex::find(uint64_t size, Hash const &hash)
+{
+  std::lock_guard<std::mutex> lock(d_mutex);
+  auto it = d_files.find(size);
+  if (it != d_files.end())
+    for (auto const &f : it->second)
+      if (f.first == hash)
+        return f.second;
+  return std::string();
+}
+
+// only add files that were completely written
+inline void MediaDedupIndex::add(uint64_t size, Hash const &hash, std::string const &path)
+{
+  std::lock_guard<std::mutex> lock(d_mutex);
+  d_files[size].emplace_back(hash, path);
+}
+
+// creates 'path' as a link to 'original'. Anything existing at 'path' is
+// removed first (writing into an existing hard link would change the other
+// names of that file as well)
+inline MediaDedupIndex::Link MediaDedupIndex::link(std::string const &original, std::string const &path, uint64_t size)
+{
+  std::error_code ec;
+  std::filesystem::remove(WIN_LONGPATH(path), ec);
+
+  Link result = Link::CLONED;
+  if (!cloneFile(original, path))
+  {
+    std::filesystem::create_hard_link(WIN_LONGPATH(original), WIN_LONGPATH(path), ec);
+    if (ec)
+      return Link::FAILED;
+    result = Link::HARDLINKED;
+  }
+
+  std::lock_guard<std::mutex> lock(d_mutex);
+  ++d_linkedfiles;
+  d_linkedbytes += size;
+  return result;
+}
+
+// the number of attachments linked so far, and their total size
+inline std::pair<uint64_t, uint64_t> MediaDedupIndex::linked()
+{
+  std::lock_guard<std::mutex> lock(d_mutex);
+  return {d_linkedfiles, d_linkedbytes};
+}
+
+// adds the links made by another process (an HTML export worker), for report()
+inline void MediaDedupIndex::addLinked(uint64_t files, uint64_t bytes)
+{
+  std::lock_guard<std::mutex> lock(d_mutex);
+  d_linkedfiles += files;
+  d_linkedbytes += bytes;
+}
+
+inline void MediaDedupIndex::report()
+{
+  std::lock_guard<std::mutex> lock(d_mutex);
+  if (d_linkedfiles)
+    Logger::message("Deduplicated ", d_linkedfiles, " attachment", (d_linkedfiles == 1 ? "" : "s"), " (",
+                    d_linkedbytes / (1024 * 1024), " MiB not written)");
+}
+
+// FICLONE is supported by (at least) btrfs, xfs and bcachefs. On other
+// filesystems and platforms this fails, and a hard link is made instead
+inline bool MediaDedupIndex::cloneFile([[maybe_unused]] std::string const &source, [[maybe_unused]] std::string const &target) // static
+{
+#if defined(__linux__) && defined(FICLONE)
+  int sourcefd = ::open(source.c_str(), O_RDONLY | O_CLOEXEC);
+  if (sourcefd == -1)
+    return false;
+  int targetfd = ::open(target.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+  if (targetfd == -1)
+  {
+    ::close(sourcefd);
+    return false;
+  }
+  bool ok = (::ioctl(targetfd, FICLONE, sourcefd) == 0);
+  ::close(sourcefd);
+  if (::close(targetfd) != 0)
+    ok = false;
+  if (!ok)
+    ::unlink(target.c_str());
+  return ok;
+#else
+  return false;
+#endif
+}
+
+#endif
@@ -0,0 +1,87 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "signalbackup.ih"
+#include "frameencryptionqueue.h"
+
+// Same as writeEncryptedFrame(), but the frame is only assigned its iv here, it
+// is encrypted by the worker threads of 'queue'. Frames are written when they are
+// done (in order). If 'cleardata' is set, the attachment data of the frame is
+// dropped after it is written.
+bool SignalBackup::queueEncryptedFrame(std::ofstream &outputfile, BackupFrame *frame, FrameEncryptionQueue *queue, bool cleardata)
+{
+  std::pair<std::shared_ptr<unsigned char[]>, uint64_t> framedata(nullptr, 0);
+  {
+    std::pair<unsigned char *, uint64_t> framedataraw = frame->getData();
+    framedata.first.reset(framedataraw.first);
+    framedata.second = framedataraw.second;
+  }
+
+  if (!framedata.first) [[unlikely]]
+  {
+    Logger::error("Failed to get framedata from frame");
+    return false;
+  }
+
+  // get the attachment data first: if it is corrupt, the frame is skipped
+  // entirely, and does not use up any ivs
+  unsigned char *attachmentdata = nullptr;
+  uint32_t attachmentsize = frame->attachmentSize();
+  if (attachmentsize > 0)
+  {
+    bool badmac = false;
+    attachmentdata = reinterpret_cast<FrameWithAttachment *>(frame)->attachmentData(d_verbose, &badmac);
+    if (!attachmentdata)
+    {
+      if (badmac)
+      {
+        Logger::warning("Corrupted data encountered. Skipping frame.");
+        return true;
+      }
+      Logger::error("Failed to get attachment data for frame.");
+      return false;
+    }
+  }
+
+  FileEncryptor const *fe = &d_fe;
+  FrameEncryptionQueue::Pending pending{{}, {}, nullptr, framedata.second + attachmentsize};
+  pending.frame = queue->pool.submit([fe, framedata, iv = d_fe.nextIv()]()
+  {
+    std::pair<unsigned char *, uint64_t> encrypted = fe->encryptFrame(framedata.first.get(), framedata.second, iv);
+    return std::make_pair(std::unique_ptr<unsigned char[]>(encrypted.first), encrypted.second);
+  });
+  if (attachmentdata)
+  {
+    pending.attachment = queue->pool.submit([fe, attachmentdata, attachmentsize, iv = d_fe.nextIv()]()
+    {
+      std::pair<unsigned char *, uint64_t> encrypted = fe->encryptAttachment(attachmentdata, attachmentsize, iv);
+      return std::make_pair(std::unique_ptr<unsigned char[]>(encrypted.first), encrypted.second);
+    });
+    if (cleardata)
+      pending.clearafterwrite = reinterpret_cast<FrameWithAttachment *>(frame);
+  }
+  queue->pendingbytes += pending.size;
+  queue->pending.emplace_back(std::move(pending));
+
+  while (queue->pending.size() > queue->maxpending ||
+         queue->pendingbytes > FrameEncryptionQueue::s_maxpendingbytes)
+    if (!writeQueuedFrame(outputfile, queue)) [[unlikely]]
+      return false;
+  return true;
+}
@@ -24,13 +24,14 @@
 SignalBackup::SignalBackup(std::string const &filename, std::string const &passphrase, bool verbose,
                            bool truncate, bool showprogress, bool replaceattachments, bool assumebadframesizeonbadmac,
                            std::vector<long long int> const &editattachments, bool inserthugeattachments,
-                           bool stoponerror, bool fulldecode)
+                           bool stoponerror, bool fulldecode, unsigned int threads, bool mmapinput, bool frameindex)
   :
   d_filename(filename),
   d_passphrase(passphrase),
   d_selfid(-1),
   d_databaseversion(-1),
   d_backupfileversion(-1),
+  d_threads(threads ? threads : ThreadPool::hardwareThreads()),
   d_aggressive_filename_sanitizing(false),
   d_showprogress(showprogress),
   d_stoponerror(stoponerror),
@@ -38,6 +39,7 @@ SignalBackup::SignalBackup(std::string const &filename, std::string const &passp
   d_truncate(truncate),
   d_fulldecode(fulldecode),
   d_ok(false),
+  d_schemaorder_version(-1),
   d_found_sqlite_sequence_in_backup(false)
 {
   if (bepaald::isDir(filename))
@@ -47,7 +49,26 @@ SignalBackup::SignalBackup(std::string const &filename, std::string const &passp
     d_fd.reset(new FileDecryptor(d_filename, d_passphrase, d_verbose, d_stoponerror, assumebadframesizeonbadmac, editattachments));
     if (!d_fd->ok())
       return;
+    d_fd->setThreads(d_threads);
+    if (mmapinput && d_fd->useMappedInput() && d_verbose) [[unlikely]]
+      Logger::message("Reading backup file from memory map");
+
+    // use an existing frame index, or create one while reading. The index is
+    // only used by the threaded reader, a single threaded read does not need it
+    if (frameindex && d_threads <= 1)
+    {
+      Logger::warning("Ignoring `--frameindex': the frame index is only used when reading with `--threads' (N > 1)");
+      frameindex = false;
+    }
+    std::string const indexfile(d_filename + ".sbtindex");
+    bool recordindex = frameindex && !d_fd->loadFrameIndex(indexfile);
+    d_fd->recordFrameIndex(recordindex);
+
     initFromFile();
+
+    if (recordindex && d_ok)
+      d_fd->saveFrameIndex(indexfile);
+    d_fd->recordFrameIndex(false);
   }
 
   if (!d_ok)
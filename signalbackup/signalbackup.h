@@ -78,6 +78,11 @@
 struct HTMLMessageInfo;
 struct Range;
 struct GroupInfo;
+struct HTMLSearchIndexShards;
+struct HTMLPagePrefetch;
+struct FrameEncryptionQueue;
+struct MediaDedupIndex;
+class AttachmentReadScheduler;
 enum class IconType : std::uint8_t;
 class JsonDatabase;
 class DesktopDatabase;
@@ -152,6 +157,7 @@ class SignalBackup
   long long int d_selfid;
   unsigned int d_databaseversion;
   unsigned int d_backupfileversion;
+  unsigned int d_threads;
   bool d_aggressive_filename_sanitizing;
   bool d_showprogress;
   bool d_stoponerror;
@@ -159,6 +165,8 @@ class SignalBackup
   bool d_truncate;
   bool d_fulldecode;
   bool d_ok;
+  std::vector<std::string> d_schemaorder; // schema objects in the order of the input file, if it differs from sqlite_master
+  long long int d_schemaorder_version;    // schema_version the order above is valid for
 
   // only used in testing
   bool d_found_sqlite_sequence_in_backup;
@@ -177,6 +185,25 @@ class SignalBackup
     //ANOTHER_FLAG = (1 << 2),
   };
 
+  enum class AttachmentFileResult : std::uint8_t
+  {
+    WRITTEN,
+    CLONED,
+    HARDLINKED, // shares its timestamp with the first copy, don't set it
+    OPENFAILED,
+    READFAILED,
+    WRITEFAILED
+  };
+
+  // orders (full) file names, ignoring (ASCII) case if the filesystem they
+  // are on does: there, names that only differ in case are the same file
+  struct FilenameLess
+  {
+    bool casefold;
+    inline bool operator()(std::string const &lhs, std::string const &rhs) const;
+  };
+  using ReservedFilenames = std::set<std::string, FilenameLess>;
+
   struct RecipientIdentification
   {
     std::string uuid;
@@ -226,10 +253,19 @@ class SignalBackup
     bool verified;
   };
 
+  struct EmojiTrieNode
+  {
+    unsigned int firstchild;  // index of first child, children are consecutive and sorted by byte
+    unsigned short children;
+    unsigned char byte;
+    unsigned char length;     // length of emoji ending at this node (0 : none)
+  };
+
   static std::vector<DatabaseLink> const s_databaselinks;
   static std::map<std::string, std::vector<std::vector<std::string>>> const s_columnaliases;
   static std::string_view const s_emoji_unicode_list[3944];
   static std::string_view const s_emoji_first_bytes;
+  static std::vector<EmojiTrieNode> const s_emoji_trie;
   static std::map<std::string_view, std::string_view, std::less<>> const s_html_colormap;
   static std::array<std::pair<std::string_view, std::string_view>, 12> const s_html_random_colors;
   static std::array<std::pair<std::string_view, std::string_view>, 36> const s_html_random_groupmember_colors;
@@ -243,13 +279,14 @@ class SignalBackup
   SignalBackup(std::string const &filename, std::string const &passphrase, bool verbose,
                bool truncate, bool showprogress, bool replaceattachment, bool assumebadframesizeonbadmac,
                std::vector<long long int> const &editattachments, bool inserthugeattachments,
-               bool stoponerror, bool fulldecode);
+               bool stoponerror, bool fulldecode, unsigned int threads, bool mmapinput, bool frameindex);
   inline SignalBackup(SignalBackup const &other) = default;
   inline SignalBackup &operator=(SignalBackup const &other) = default;
   inline SignalBackup(SignalBackup &&other) = default;
   inline SignalBackup &operator=(SignalBackup &&other) = default;
   [[nodiscard]] bool exportBackup(std::string const &filename, std::string const &passphrase,
-                                  bool overwrite, bool keepattachmentdatainmemory, bool onlydb = false);
+                                  bool overwrite, bool keepattachmentdatainmemory, bool onlydb = false,
+                                  bool deduplicatemedia = false);
   bool exportXml(std::string const &filename, bool overwrite, std::string self, bool includemms = false, bool keepattachmentdatainmemory = true);
   bool exportCsv(std::string const &filename, std::string const &table, bool overwrite) const;
   void listThreads() const;
@@ -278,7 +315,7 @@ class SignalBackup
   bool reorderMmsSmsIds() const;
   bool dumpMedia(std::string const &dir, std::vector<std::string> const &dateranges, std::vector<long long int> const &threads,
                  long long int minsize, long long int maxsize, bool excludestickers, bool excludequotes, bool aggressive_sanitizing,
-                 bool overwrite) const;
+                 bool overwrite, bool deduplicatemedia) const;
   bool dumpAvatars(std::string const &dir, std::vector<std::string> const &contacts, bool aggressive_sanitizing, bool overwrite) const;
   bool deleteAttachments(std::vector<long long int> const &threadids, std::string const &before,
                          std::string const &after, long long int filesize,
@@ -309,11 +346,11 @@ class SignalBackup
   bool exportHtml(std::string const &directory, std::vector<long long int> const &threads,
                   std::vector<std::string> const &dateranges, std::string const &splitby,
                   long long int split, long long int origin, std::string const &selfid, bool calllog,
-                  bool searchpage, bool stickerpacks, bool migrate, bool overwrite, bool append,
+                  bool searchpage, bool shardedsearchindex, bool stickerpacks, bool migrate, bool overwrite, bool append,
                   bool theme, bool themeswitching, bool addexportdetails, bool blocked, bool fullcontacts,
                   bool settings, bool receipts, bool use_original_filenames, bool linkify,
                   bool chatfolders, bool compact, bool pagemenu, bool aggressive_sanitizing,
-                  bool excludeexpiring, bool focusend, std::vector<std::string> const &ignoremediatypes);
+                  bool excludeexpiring, bool focusend, bool deduplicatemedia, std::vector<std::string> const &ignoremediatypes);
   bool exportTxt(std::string const &directory, std::vector<long long int> const &threads,
                  std::vector<std::string> const &dateranges, std::string const &selfid, bool migrate,
                  bool aggressive_sanitizing, bool overwrite);
@@ -349,7 +386,8 @@ class SignalBackup
  protected:
   [[nodiscard]] bool exportBackupToFile(std::string const &filename, std::string const &passphrase,
                                         bool overwrite, bool keepattachmentdatainmemory);
-  [[nodiscard]] bool exportBackupToDir(std::string const &directory, bool overwrite, bool keepattachmentdatainmemory, bool onlydb);
+  [[nodiscard]] bool exportBackupToDir(std::string const &directory, bool overwrite, bool keepattachmentdatainmemory, bool onlydb,
+                                       bool deduplicatemedia);
   void initFromFile();
   void initFromDir(std::string const &inputdir, bool replaceattachments, bool inserthugeattachments);
   void updateThreadsEntries(long long int thread = -1);
@@ -363,9 +401,14 @@ class SignalBackup
   [[nodiscard]] bool writeEncryptedFrame(std::ofstream &outputfile, BackupFrame *frame);
   [[nodiscard]] bool writeEncryptedFrameWithoutAttachment(std::ofstream &outputfile,
                                                           std::pair<std::shared_ptr<unsigned char[]>, uint64_t> const &framedata);
+  [[nodiscard]] bool queueEncryptedFrame(std::ofstream &outputfile, BackupFrame *frame, FrameEncryptionQueue *queue, bool cleardata);
+  [[nodiscard]] bool writeQueuedFrame(std::ofstream &outputfile, FrameEncryptionQueue *queue) const;
   SqlStatementFrame buildSqlStatementFrame(std::string const &table, std::vector<std::string> const &headers,
                                            std::vector<std::any> const &result) const;
   SqlStatementFrame buildSqlStatementFrame(std::string const &table, std::vector<std::any> const &result) const;
+  SqlStatementFrame buildSqlStatementFrame(std::string const &table, SqliteDB::RowView const &row) const;
+  bool execSqlStatementFrame(SqlStatementFrame const &frame) const;
+  void createDeferredIndexes(std::vector<std::pair<std::string, long long int>> const &indexes);
   template <typename T>
   inline bool setFrameFromFile(DeepCopyingUniquePtr<T> *frame, std::string const &file, bool quiet = false) const;
   template <typename T>
@@ -492,19 +535,22 @@ class SignalBackup
   void HTMLwriteAttachmentDiv(std::ofstream &htmloutput, SqliteDB::QueryResults const &attachment_results, int indent,
                               std::string const &directory, std::string const &threaddir, bool use_original_filenames,
                               bool is_image_preview, bool isquote, bool overwrite, bool append,
-                              std::vector<std::string> const &ignoremediatypes) const;
+                              std::vector<std::string> const &ignoremediatypes, MediaDedupIndex *mediadedup,
+                              AttachmentReadScheduler *readscheduler) const;
   void HTMLwriteCallLinkDiv(std::ofstream &htmloutput, int indent, std::string const &url, std::string const &title,
                             std::string const &description/*, std::string const &directory, std::string const &threaddir,
                                                               bool overwrite, bool append*/) const;
   void HTMLwriteSharedContactDiv(std::ofstream &htmloutput, std::string const &shared_contact, int indent,
                                  std::string const &directory, std::string const &threaddir,
-                                 bool overwrite, bool append) const;
+                                 bool overwrite, bool append, MediaDedupIndex *mediadedup,
+                                 AttachmentReadScheduler *readscheduler) const;
   bool HTMLwritePollDiv(std::ofstream &htmloutput, int indent, std::map<long long int, RecipientInfo> *recipients_info,
                         SqliteDB::QueryResults const &poll, SqliteDB::QueryResults const &poll_options,
                         SqliteDB::QueryResults const &poll_votes) const;
   bool HTMLwriteAttachment(std::string const &directory, std::string const &threaddir, long long int rowid,
                            long long int uniqueid, std::string const &attachment_filename, long long int timestamp,
-                           bool overwrite, bool append) const;
+                           bool overwrite, bool append, MediaDedupIndex *mediadedup,
+                           AttachmentReadScheduler *readscheduler) const;
   bool HTMLprepMsgBody(std::string *body, std::vector<std::tuple<long long int, long long int, long long int>> const &mentions,
                        std::map<long long int, RecipientInfo> *recipients_info,
                        std::map<std::string, long long int, std::less<>> *recipientmap, bool incoming,
@@ -551,7 +597,11 @@ class SignalBackup
                           std::vector<std::tuple<long long int, std::string, std::string>> const &chatfolders, bool excludeexpiring,
                           std::map<int, int> const &tid_pagecount_map, bool compact) const;
 
-  void HTMLwriteSearchpage(std::string const &dir, bool light, bool themeswitching, bool compact) const;
+  void HTMLwriteSearchpage(std::string const &dir, bool light, bool themeswitching, bool compact, bool shardedindex) const;
+  bool HTMLprefetchPage(SqliteDB::QueryResults const &messages, unsigned int first, unsigned int last,
+                        HTMLPagePrefetch *prefetch) const;
+  bool HTMLsearchIndexAdd(HTMLSearchIndexShards *shards, std::string const &line) const;
+  bool HTMLwriteSearchIndexShards(HTMLSearchIndexShards *shards, std::ofstream &searchidx) const;
   void HTMLwriteCallLog(std::vector<long long int> const &threads, std::string const &directory,
                         std::string const &datewhereclause, std::map<long long int, RecipientInfo> *recipientinfo,
                         long long int notetoself_tid, bool overwrite, bool append, bool light, bool themeswitching,
@@ -578,9 +628,11 @@ class SignalBackup
   std::string getAvatarExtension(long long int recipient_id) const;
   void prepRanges(std::vector<Range> *ranges) const;
   void applyRanges(std::string *body, std::vector<Range> *ranges, std::set<int> *positions_excluded_from_escape) const;
+  static std::vector<EmojiTrieNode> buildEmojiTrie();
   std::vector<std::pair<unsigned int, unsigned int>> HTMLgetEmojiPos(std::string_view line) const;
   std::string getHostname(std::string_view host) const;
-  bool makeFilenameUnique(std::string const &path, std::string *file_or_dir) const;
+  bool makeFilenameUnique(std::string const &path, std::string *file_or_dir, ReservedFilenames *reserved = nullptr) const;
+  AttachmentFileResult writeAttachmentFile(FrameWithAttachment *a, std::string const &path, MediaDedupIndex *mediadedup) const;
   std::string decodeGroupV2UpdateMessage(DecryptedGroupV2Context const &groupv2ctx, long long int type, std::string const &name, IconType *icon) const;
   std::string decodeProfileChangeMessage(ProfileChangeDetails const &pcd, std::string const &name, IconType *icon) const;
   std::string decodePollTerminateMessage(PollTerminate const &body, long long int type, std::string const &name, IconType *icon) const;
@@ -660,6 +712,7 @@ inline SignalBackup::SignalBackup(bool verbose, bool truncate, bool showprogress
   d_selfid(-1),
   d_databaseversion(-1),
   d_backupfileversion(-1),
+  d_threads(1),
   d_aggressive_filename_sanitizing(false),
   d_showprogress(showprogress),
   d_stoponerror(false),
@@ -667,6 +720,7 @@ inline SignalBackup::SignalBackup(bool verbose, bool truncate, bool showprogress
   d_truncate(truncate),
   d_fulldecode(false),
   d_ok(false),
+  d_schemaorder_version(-1),
   d_found_sqlite_sequence_in_backup(false)
 {}
 
@@ -674,7 +728,7 @@ inline SignalBackup::SignalBackup(std::string const &filename, std::string const
                                   bool truncate, bool showprogress, bool replaceattachments, bool inserthugeattachments)
   :
   SignalBackup(filename, passphrase, verbose, truncate, showprogress, replaceattachments, false,
-               std::vector<long long int>(), inserthugeattachments, false, false)
+               std::vector<long long int>(), inserthugeattachments, false, false, 1, false, false)
 {}
 
 inline bool SignalBackup::ok() const
@@ -1110,6 +1164,16 @@ inline int SignalBackup::bytesToUtf8CharSize(std::string_view body, unsigned int
   return 1;
 }
 
+inline bool SignalBackup::FilenameLess::operator()(std::string const &lhs, std::string const &rhs) const
+{
+  if (!casefold)
+    return lhs < rhs;
+  return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](unsigned char a, unsigned char b) STATICLAMBDA
+  {
+    return std::tolower(a) < std::tolower(b);
+  });
+}
+
 inline std::string SignalBackup::utf8BytesToHexString(std::shared_ptr<unsigned char[]> const &data, size_t data_size) const
 {
   return utf8BytesToHexString(data.get(), data_size);
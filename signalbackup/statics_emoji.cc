@@ -3973,3 +3973,5 @@ std::string_view MAXCONST SignalBackup::s_emoji_unicode_list[3944] = {"\xf0\x9f\
                                                                       "\xe2\x8c\x9a"}; // static
 
 std::string_view MAXCONST SignalBackup::s_emoji_first_bytes("\xf0\xe2\xe3\xc2\x39\x38\x37\x36\x35\x34\x33\x32\x31\x30\x2a\x23"); // static
+
+std::vector<SignalBackup::EmojiTrieNode> const SignalBackup::s_emoji_trie = SignalBackup::buildEmojiTrie(); // static
@@ -0,0 +1,88 @@
+/*
+  Copyright (C) 2021-2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "signalbackup.ih"
+
+#include "mediadedupindex.h"
+
+// writes the data of attachment 'a' to 'path'. With a 'mediadedup' index, data
+// that was written before is linked to that first copy instead. If an earlier
+// attachment has the same size, this costs an extra (hash only) read of the
+// data, but nothing is written. On failure, the (partial) file is removed.
+SignalBackup::AttachmentFileResult SignalBackup::writeAttachmentFile(FrameWithAttachment *a, std::string const &path,
+                                                                     MediaDedupIndex *mediadedup) const
+{
+  uint64_t size = a->attachmentSize();
+  if (mediadedup && mediadedup->hasSize(size))
+  {
+    MediaDedupIndex::Hasher hasher;
+    MediaDedupIndex::Hash hash;
+    if (a->readAttachmentData([&](unsigned char const *data, uint64_t datasize) { return hasher.update(data, datasize); },
+                              d_verbose) != BaseAttachmentReader::ReturnCode::OK)
+      return AttachmentFileResult::READFAILED;
+
+    std::string original(hasher.final(&hash) ? mediadedup->find(size, hash) : std::string());
+    if (!original.empty())
+    {
+      switch (mediadedup->link(original, path, size))
+      {
+        case MediaDedupIndex::Link::CLONED:
+          return AttachmentFileResult::CLONED;
+        case MediaDedupIndex::Link::HARDLINKED:
+          return AttachmentFileResult::HARDLINKED;
+        case MediaDedupIndex::Link::FAILED:
+          if (d_verbose) [[unlikely]]
+            Logger::message("Failed to link '", path, "' to '", original, "', writing it instead");
+          break;
+      }
+    }
+  }
+
+  // an existing file could be a hard link from an earlier export, don't write through it
+  if (mediadedup)
+  {
+    std::error_code ec;
+    std::filesystem::remove(WIN_LONGPATH(path), ec);
+  }
+
+  std::ofstream file(WIN_LONGPATH(path), std::ios_base::binary);
+  if (!file.is_open())
+    return AttachmentFileResult::OPENFAILED;
+
+  std::unique_ptr<MediaDedupIndex::Hasher> hasher(mediadedup ? new MediaDedupIndex::Hasher : nullptr);
+  bool writeok = true;
+  BaseAttachmentReader::ReturnCode ret =
+    a->readAttachmentData([&](unsigned char const *data, uint64_t datasize)
+                          {
+                            if (hasher)
+                              hasher->update(data, datasize);
+                            return (writeok = static_cast<bool>(file.write(reinterpret_cast<char const *>(data), datasize)));
+                          }, d_verbose);
+  file.close();
+  if (ret != BaseAttachmentReader::ReturnCode::OK || !file) [[unlikely]]
+  {
+    std::error_code ec;
+    std::filesystem::remove(WIN_LONGPATH(path), ec);
+    return (writeok && file) ? AttachmentFileResult::READFAILED : AttachmentFileResult::WRITEFAILED;
+  }
+
+  if (MediaDedupIndex::Hash hash; hasher && hasher->final(&hash))
+    mediadedup->add(size, hash, path);
+  return AttachmentFileResult::WRITTEN;
+}
@@ -0,0 +1,60 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "signalbackup.ih"
+#include "frameencryptionqueue.h"
+
+// waits for the first frame in 'queue' to be encrypted, and writes it
+bool SignalBackup::writeQueuedFrame(std::ofstream &outputfile, FrameEncryptionQueue *queue) const
+{
+  FrameEncryptionQueue::Pending &pending = queue->pending.front();
+
+  std::pair<std::unique_ptr<unsigned char[]>, uint64_t> encryptedframe = pending.frame.get();
+  if (!encryptedframe.first) [[unlikely]]
+  {
+    Logger::error("Failed to encrypt framedata");
+    return false;
+  }
+  if (!outputfile.write(reinterpret_cast<char *>(encryptedframe.first.get()), encryptedframe.second)) [[unlikely]]
+  {
+    Logger::error("Failed to write encrypted frame data to file");
+    return false;
+  }
+
+  if (pending.attachment.valid())
+  {
+    std::pair<std::unique_ptr<unsigned char[]>, uint64_t> encryptedattachment = pending.attachment.get();
+    if (!encryptedattachment.first) [[unlikely]]
+    {
+      Logger::error("Failed to encrypt attachment data");
+      return false;
+    }
+    if (!outputfile.write(reinterpret_cast<char *>(encryptedattachment.first.get()), encryptedattachment.second)) [[unlikely]]
+    {
+      Logger::error("Failed to write encrypted attachmentdata to file");
+      return false;
+    }
+    if (pending.clearafterwrite)
+      pending.clearafterwrite->clearData();
+  }
+
+  queue->pendingbytes -= pending.size;
+  queue->pending.pop_front();
+  return true;
+}
@@ -44,6 +44,7 @@ class SignalPlainTextBackupAttachmentReader final : public AttachmentReader<Sign
   virtual ~SignalPlainTextBackupAttachmentReader() override = default;
 
   inline virtual ReturnCode getAttachment(FrameWithAttachment *frame, bool verbose) override;
+  inline virtual ReturnCode readAttachment(Sink const &sink, bool verbose) override;
   inline ReturnCode getAttachmentData(unsigned char **data, bool verbose);
   inline long long int dataSize();
   //inline virtual void clearData() override;
@@ -68,6 +69,17 @@ inline BaseAttachmentReader::ReturnCode SignalPlainTextBackupAttachmentReader::g
   return ret;
 }
 
+inline BaseAttachmentReader::ReturnCode SignalPlainTextBackupAttachmentReader::readAttachment(Sink const &sink, bool verbose) // virtual
+{
+  // the base64 data is decoded in one go, the result is passed on in chunks
+  unsigned char *data = nullptr;
+  ReturnCode ret = getAttachmentData(&data, verbose);
+  std::unique_ptr<unsigned char[]> attdata(data);
+  if (ret != ReturnCode::OK) [[unlikely]]
+    return ret;
+  return sinkChunked(attdata.get(), d_truesize, sink);
+}
+
 inline BaseAttachmentReader::ReturnCode SignalPlainTextBackupAttachmentReader::getAttachmentData(unsigned char **data, bool verbose)
 {
   // read the data if needed
@@ -0,0 +1,150 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "sqlcipherdecryptor.ih"
+
+#include "../common_bytes.h"
+
+/*
+  PAGE
+
+                                                         page_size
+   -------------------------------------------------------------------------------------------------------------------------------
+  /                                                                     real_page_size                                            \
+  |                                 -----------------------------------------------------------------------------------------------|
+  |                                /                                                                                               |
+  |                                |                                                                                               |
+  |                                |     page + (real_page_size - (digest_size + page_padding) - iv_size)                          |
+  |                                |                v                                                                              |
+
+  [salt, 16 bytes, only first page][encrypted bytes][iv, 16 bytes][mac, padded to 16 bytes (for version < 3, 20 bytes, padded to 32]
+
+  Every page has its own iv and mac, so pages can be decrypted independently
+  (and in any order). 'raw' points to the start of the page in the file, 'out'
+  to the start of the page in the decrypted database. Errors are only logged
+  when 'report' is set, this function is called from the decryption threads.
+*/
+
+bool SqlCipherDecryptor::decryptPage(evp_cipher_ctx_st *dctx, uint64_t pagenumber, unsigned char const *raw,
+                                     unsigned char *out, bool *empty, bool report) const
+{
+  *empty = false;
+
+  if (!dctx) [[unlikely]]
+  {
+    if (report)
+      Logger::error("CTX INIT FAILED");
+    return false;
+  }
+
+  // write header
+  if (pagenumber == 1)
+  {
+    std::memcpy(out, s_sqlliteheader, s_sqlliteheader_size);
+    raw += d_saltsize;
+    out += s_sqlliteheader_size;
+  }
+
+  unsigned int iv_size = 16;
+  unsigned int page_padding = (((d_digestsize - 1) | 15) + 1) - d_digestsize;  // pad to multiple of 16 bytes ??? (maybe 32?)
+  unsigned int real_page_size = pagenumber == 1 ? d_pagesize - d_saltsize : d_pagesize;
+
+  // these pointers all point to specific data inside 'raw'
+  unsigned char const *page_data_to_hash = raw;
+  unsigned int page_data_to_hash_size = real_page_size - (d_digestsize + page_padding);
+  unsigned char const *iv = raw + page_data_to_hash_size - iv_size;
+  unsigned char const *page_encrypted_data = raw;
+  unsigned int page_encrypted_data_size = page_data_to_hash_size - iv_size;
+
+  // calculate MAC
+  unsigned int pgno = pagenumber;
+  CryptContext::HmacCtx hctx(d_cryptcontext->hmac());
+  unsigned int macsize = d_digestsize;
+  std::unique_ptr<unsigned char[]> calculatedmac(new unsigned char[macsize]);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  if (!hctx ||
+      EVP_MAC_update(hctx.get(), page_data_to_hash, page_data_to_hash_size) != 1 ||
+      EVP_MAC_update(hctx.get(), reinterpret_cast<unsigned char *>(&pgno), sizeof(pgno)) != 1 ||
+      EVP_MAC_final(hctx.get(), calculatedmac.get(), nullptr, macsize) != 1)
+#else
+  if (!hctx ||
+      HMAC_Update(hctx.get(), page_data_to_hash, page_data_to_hash_size) != 1 ||
+      HMAC_Update(hctx.get(), reinterpret_cast<unsigned char *>(&pgno), sizeof(pgno)) != 1 ||
+      HMAC_Final(hctx.get(), calculatedmac.get(), &macsize) != 1)
+#endif
+  {
+    if (report)
+      Logger::error("Failed to update/finalize hmac");
+    return false;
+  }
+
+  int decodedframelength = real_page_size;
+
+  // compare calculated mac to the mac from file
+  if (std::memcmp(raw + (real_page_size - (d_digestsize + page_padding)), calculatedmac.get(), d_digestsize) != 0) [[unlikely]]
+  {
+    // note: a bad mac can occur if the page is empty (all 0x00). An empty page is not an error, and should simply be skipped.
+    bool containsdata = false;
+    for (unsigned int i = 0; i < page_data_to_hash_size; ++i)
+    {
+      if (page_data_to_hash[i] != 0x00)
+      {
+        containsdata = true;
+        break;
+      }
+    }
+    if (!containsdata) // UNTESTED  // skip decryption, but set entire page of zeros??
+    {
+      std::memset(out, 0, decodedframelength); // write all-zero page
+      *empty = true;
+      return true;
+    }
+
+    // mac did not match, but page contained data -> ERROR
+    if (report)
+    {
+      Logger::error("BAD MAC! (pagenumber: ", pagenumber, " (at ", pagenumber * d_pagesize - (d_digestsize + page_padding), "/", d_decrypteddatasize, "))");
+      Logger::error_indent("MAC in file: ", bepaald::bytesToHexString(raw + (real_page_size - (d_digestsize + page_padding)), d_digestsize));
+      Logger::error_indent("Calculated : ", bepaald::bytesToHexString(calculatedmac.get(), d_digestsize));
+    }
+    return false;
+  }
+
+  // init decryptor (set the iv for this page, the key is kept)
+  if (!d_cryptcontext->resetCipher(dctx, iv))
+  {
+    if (report)
+      Logger::error("CTX INIT FAILED");
+    return false;
+  }
+
+  int actualdecodedframelength = 0;
+  if (EVP_DecryptUpdate(dctx, out, &actualdecodedframelength, page_encrypted_data, page_encrypted_data_size) != 1)
+  {
+    if (report)
+    {
+      Logger::error("Failed to update decryption context");
+      ERR_print_errors_fp(stderr);
+    }
+    return false;
+  }
+  std::memset(out + page_encrypted_data_size, 0, decodedframelength - page_encrypted_data_size); // append zeros
+
+  return true;
+}
@@ -0,0 +1,44 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "sqlcipherdecryptor.ih"
+
+// decrypts 'count' consecutive pages, starting at (1-based) 'firstpage'. Safe to
+// call from multiple threads at once (for distinct pages), nothing is logged here.
+SqlCipherDecryptor::PageRangeResult SqlCipherDecryptor::decryptPages(uint64_t firstpage, uint64_t count,
+                                                                     unsigned char const *raw, unsigned char *out) const
+{
+  PageRangeResult result{0, 0};
+
+  // every range gets its own decryption context, the key is shared
+  CryptContext::CipherCtx dctx(d_cryptcontext->cipher(nullptr));
+
+  for (uint64_t i = 0; i < count; ++i)
+  {
+    bool empty = false;
+    if (!decryptPage(dctx.get(), firstpage + i, raw + i * d_pagesize, out + i * d_pagesize, &empty, false)) [[unlikely]]
+    {
+      result.failedpage = firstpage + i;
+      return result;
+    }
+    if (empty) [[unlikely]]
+      ++result.emptypages;
+  }
+  return result;
+}
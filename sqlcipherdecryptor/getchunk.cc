@@ -0,0 +1,55 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "sqlcipherdecryptor.ih"
+
+// lazy mode: returns the decrypted data of chunk 'index' (s_chunkpages pages),
+// decrypting it first if it is not in the cache. Returns nullptr on error.
+unsigned char *SqlCipherDecryptor::getChunk(uint64_t index)
+{
+  ++d_chunkclock;
+  for (auto &c : d_chunks)
+    if (c.index == index)
+    {
+      c.lastuse = d_chunkclock;
+      return c.data.get();
+    }
+
+  // take a new slot while there is room, otherwise reuse the least recently
+  // used one (but never the first, it holds the database header)
+  Chunk *slot = nullptr;
+  if (d_chunks.size() < s_maxcachedchunks)
+    slot = &d_chunks.emplace_back(Chunk{index, 0, std::unique_ptr<unsigned char[]>(new unsigned char[static_cast<uint64_t>(s_chunkpages) * d_pagesize])});
+  else
+  {
+    slot = &d_chunks[1];
+    for (unsigned int i = 2; i < d_chunks.size(); ++i)
+      if (d_chunks[i].lastuse < slot->lastuse)
+        slot = &d_chunks[i];
+  }
+
+  uint64_t firstpage = index * s_chunkpages + 1;
+  slot->index = static_cast<uint64_t>(-1);
+  if (!loadPages(firstpage, std::min<uint64_t>(s_chunkpages, d_pagecount - firstpage + 1), slot->data.get())) [[unlikely]]
+    return nullptr;
+
+  slot->index = index;
+  slot->lastuse = d_chunkclock;
+  return slot->data.get();
+}
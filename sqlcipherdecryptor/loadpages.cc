@@ -0,0 +1,76 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "sqlcipherdecryptor.ih"
+
+#include <future>
+
+// reads 'count' pages from the database file and decrypts them into 'out'. The
+// pages are divided over the worker threads if there are any.
+bool SqlCipherDecryptor::loadPages(uint64_t firstpage, uint64_t count, unsigned char *out)
+{
+  if (count == 0) [[unlikely]]
+    return true;
+
+  if (!d_dbfile.seekg((firstpage - 1) * d_pagesize) ||
+      !d_dbfile.read(reinterpret_cast<char *>(d_rawpages.get()), count * d_pagesize)) [[unlikely]]
+  {
+    Logger::error("Failed to read pages ", firstpage, "-", firstpage + count - 1, " from database file",
+                  (d_dbfile.eof() ? " (EOF)" : ""));
+    d_dbfile.clear();
+    return false;
+  }
+
+  std::vector<PageRangeResult> results;
+  if (!d_threadpool || count < d_threadpool->size())
+    results.emplace_back(decryptPages(firstpage, count, d_rawpages.get(), out));
+  else
+  {
+    uint64_t pagesperthread = (count + d_threadpool->size() - 1) / d_threadpool->size();
+    std::vector<std::future<PageRangeResult>> futures;
+    for (uint64_t start = 0; start < count; start += pagesperthread)
+    {
+      uint64_t n = std::min(pagesperthread, count - start);
+      futures.emplace_back(d_threadpool->submit([this, firstpage, start, n, out]()
+      {
+        return decryptPages(firstpage + start, n, d_rawpages.get() + start * d_pagesize, out + start * d_pagesize);
+      }));
+    }
+    for (auto &f : futures)
+      results.emplace_back(f.get());
+  }
+
+  for (auto const &r : results)
+  {
+    if (r.emptypages && d_verbose) [[unlikely]]
+      Logger::message("Read ", r.emptypages, " empty page", (r.emptypages > 1 ? "s" : ""),
+                      " from SqlCipherDatabase. Inserting empty page", (r.emptypages > 1 ? "s" : ""), " in output...");
+
+    if (r.failedpage) [[unlikely]]
+    {
+      // run the failing page again (on this thread) to log what went wrong
+      bool empty = false;
+      CryptContext::CipherCtx dctx(d_cryptcontext->cipher(nullptr));
+      decryptPage(dctx.get(), r.failedpage, d_rawpages.get() + (r.failedpage - firstpage) * d_pagesize,
+                  out + (r.failedpage - firstpage) * d_pagesize, &empty, true);
+      return false;
+    }
+  }
+  return true;
+}
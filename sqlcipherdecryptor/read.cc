@@ -0,0 +1,48 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "sqlcipherdecryptor.ih"
+
+// copies decrypted database data. In lazy mode, the pages needed are decrypted
+// now (if not cached). The caller makes sure offset + size does not exceed the
+// database size.
+bool SqlCipherDecryptor::read(unsigned char *buffer, uint64_t size, uint64_t offset)
+{
+  if (!d_lazy)
+  {
+    std::memcpy(buffer, d_decrypteddata + offset, size);
+    return true;
+  }
+
+  uint64_t chunksize = static_cast<uint64_t>(s_chunkpages) * d_pagesize;
+  while (size)
+  {
+    unsigned char *chunk = getChunk(offset / chunksize);
+    if (!chunk) [[unlikely]]
+      return false;
+
+    uint64_t chunkoffset = offset % chunksize;
+    uint64_t n = std::min(size, chunksize - chunkoffset);
+    std::memcpy(buffer, chunk + chunkoffset, n);
+    buffer += n;
+    offset += n;
+    size -= n;
+  }
+  return true;
+}
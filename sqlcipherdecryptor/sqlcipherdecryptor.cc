@@ -35,7 +35,7 @@
 */
 
 SqlCipherDecryptor::SqlCipherDecryptor(std::string const &databasepath, std::string const &hexkey,
-                                       int version, bool verbose)
+                                       int version, unsigned int threads, bool lazy, bool verbose)
   :
   d_databasepath(databasepath),
   d_key(nullptr),
@@ -53,8 +53,12 @@ SqlCipherDecryptor::SqlCipherDecryptor(std::string const &databasepath, std::str
   d_saltsize(0),
   d_digestsize(EVP_MD_size(d_digest)),
   d_pagesize(version >= 4 ? 4096 : 1024),
+  d_pagecount(0),
+  d_threads(threads ? threads : ThreadPool::hardwareThreads()),
+  d_lazy(lazy),
   d_verbose(verbose),
-  d_ok(false)
+  d_ok(false),
+  d_chunkclock(0)
 {
   if (hexkey.empty())
     return;
@@ -68,8 +72,8 @@ SqlCipherDecryptor::SqlCipherDecryptor(std::string const &databasepath, std::str
   }
 
   // open database file
-  std::ifstream dbfile(d_databasepath, std::ios_base::in | std::ios_base::binary);
-  if (!dbfile.is_open())
+  d_dbfile.open(d_databasepath, std::ios_base::in | std::ios_base::binary);
+  if (!d_dbfile.is_open())
   {
     Logger::error("Failed to open database file '", d_databasepath, "'");
     return;
@@ -84,7 +88,7 @@ SqlCipherDecryptor::SqlCipherDecryptor(std::string const &databasepath, std::str
   d_saltsize = 16;
   d_salt = new unsigned char[d_saltsize];
 
-  if (!dbfile.read(reinterpret_cast<char *>(d_salt), d_saltsize))
+  if (!d_dbfile.read(reinterpret_cast<char *>(d_salt), d_saltsize))
   {
     Logger::error("Failed to read salt from database file");
     return;
@@ -93,12 +97,41 @@ SqlCipherDecryptor::SqlCipherDecryptor(std::string const &databasepath, std::str
   if (!getHmacKey())
     return;
 
-  if (d_verbose) [[unlikely]]
-    Logger::message("Starting decrypt...");
-  if (!decryptData(&dbfile))
+  if (d_decrypteddatasize % d_pagesize != 0) [[unlikely]]
+  {
+    Logger::error("Unexpected size of database file (", d_decrypteddatasize, " bytes is not a multiple of the page size (", d_pagesize, "))");
     return;
-  if (d_verbose) [[unlikely]]
-    Logger::message("Done!");
+  }
+  d_pagecount = d_decrypteddatasize / d_pagesize;
+
+  // set up the cipher and hmac once, every page only gets a copy of the hmac
+  // context and a new iv on the decryption context
+  d_cryptcontext.reset(new CryptContext(EVP_aes_256_cbc(), d_key, false, d_hmackey, d_hmackeysize, d_digestname));
+  if (!d_cryptcontext->ok()) [[unlikely]]
+    return;
+
+  if (d_threads > 1)
+    d_threadpool.reset(new ThreadPool(d_threads));
+  d_rawpages.reset(new unsigned char[static_cast<uint64_t>(s_chunkpages) * (d_lazy ? 1 : d_threads) * d_pagesize]);
+
+  if (d_lazy)
+  {
+    // only the first chunk (with the header) is decrypted now, which also
+    // verifies the key. All other pages are decrypted when they are read.
+    if (d_verbose) [[unlikely]]
+      Logger::message("Decrypting database on demand");
+    if (!getChunk(0))
+      return;
+  }
+  else
+  {
+    if (d_verbose) [[unlikely]]
+      Logger::message("Starting decrypt", (d_threads > 1 ? " (" + bepaald::toString(d_threads) + " threads)" : ""), "...");
+    if (!decryptData())
+      return;
+    if (d_verbose) [[unlikely]]
+      Logger::message("Done!");
+  }
 
   // std::cout << "CIPHER KEY: " << bepaald::bytesToHexString(d_key, d_keysize) << std::endl;
   // std::cout << "  HMAC KEY: " << bepaald::bytesToHexString(d_hmackey, d_hmackeysize) << std::endl;
@@ -1,5 +1,5 @@
 /*
-  Copyright (C) 2019-2025  Selwin van Dijk
+  Copyright (C) 2019-2026  Selwin van Dijk
 
   This file is part of signalbackup-tools.
 
@@ -22,11 +22,16 @@
 
 #include <string>
 #include <fstream>
+#include <memory>
+#include <vector>
 
 #include "../common_filesystem.h"
 #include "../logger/logger.h"
+#include "../threadpool/threadpool.h"
 
 struct evp_md_st;
+struct evp_cipher_ctx_st;
+class CryptContext;
 
 class SqlCipherDecryptor
 {
@@ -44,12 +49,39 @@ class SqlCipherDecryptor
   unsigned int d_saltsize;
   unsigned int d_digestsize;
   unsigned int d_pagesize;
+  uint64_t d_pagecount;
+  unsigned int d_threads;
+  bool d_lazy;
   bool d_verbose;
   bool d_ok;
+  std::ifstream d_dbfile;
+  std::unique_ptr<CryptContext> d_cryptcontext;
+  std::unique_ptr<unsigned char[]> d_rawpages;
+
+  // lazy mode: decrypted chunks of pages, the first chunk (containing the
+  // database header) is never evicted
+  struct Chunk
+  {
+    uint64_t index;
+    uint64_t lastuse;
+    std::unique_ptr<unsigned char[]> data;
+  };
+  std::vector<Chunk> d_chunks;
+  uint64_t d_chunkclock;
+
+  std::unique_ptr<ThreadPool> d_threadpool; // declared last: workers are joined before anything else is destroyed
 
   static unsigned char constexpr s_saltmask = 0x3a;
   static int constexpr s_sqlliteheader_size = 16;
   static char constexpr s_sqlliteheader[s_sqlliteheader_size] = {'S', 'Q', 'L', 'i', 't', 'e', ' ', 'f', 'o', 'r', 'm', 'a', 't', ' ', '3', '\0'};
+  static unsigned int constexpr s_chunkpages = 256;     // pages read and decrypted in one go
+  static unsigned int constexpr s_maxcachedchunks = 16; // lazy mode only
+
+  struct PageRangeResult
+  {
+    uint64_t failedpage; // 0 when all pages were decrypted
+    uint64_t emptypages;
+  };
 
   struct DecodedData
   {
@@ -59,16 +91,25 @@ class SqlCipherDecryptor
 
  public:
   explicit SqlCipherDecryptor(std::string const &databasepath, std::string const &hexkey,
-                              int version, bool verbose);
+                              int version, unsigned int threads, bool lazy, bool verbose);
   SqlCipherDecryptor(SqlCipherDecryptor const &other) = delete;
   SqlCipherDecryptor &operator=(SqlCipherDecryptor const &other) = delete;
   ~SqlCipherDecryptor();
   inline bool ok() const;
   inline DecodedData data() const;
+  inline bool lazy() const;
+  inline uint64_t size() const;
+  inline unsigned char *header();
+  bool read(unsigned char *buffer, uint64_t size, uint64_t offset);
   inline bool writeToFile(std::string const &filename, bool overwrite) const;
  private:
   bool getHmacKey();
-  bool decryptData(std::ifstream *dbfile);
+  bool decryptData();
+  bool loadPages(uint64_t firstpage, uint64_t count, unsigned char *out);
+  PageRangeResult decryptPages(uint64_t firstpage, uint64_t count, unsigned char const *raw, unsigned char *out) const;
+  bool decryptPage(evp_cipher_ctx_st *dctx, uint64_t pagenumber, unsigned char const *raw, unsigned char *out,
+                   bool *empty, bool report) const;
+  unsigned char *getChunk(uint64_t index);
 };
 
 inline bool SqlCipherDecryptor::ok() const
@@ -81,8 +122,33 @@ inline SqlCipherDecryptor::DecodedData SqlCipherDecryptor::data() const
   return {d_decrypteddata, d_decrypteddatasize};
 }
 
+inline bool SqlCipherDecryptor::lazy() const
+{
+  return d_lazy;
+}
+
+inline uint64_t SqlCipherDecryptor::size() const
+{
+  return d_decrypteddatasize;
+}
+
+// the (decrypted) first page of the database, containing the sqlite header. In
+// lazy mode, changes made to this page are seen by read().
+inline unsigned char *SqlCipherDecryptor::header()
+{
+  if (d_lazy)
+    return d_chunks.empty() ? nullptr : d_chunks.front().data.get();
+  return d_decrypteddata;
+}
+
 inline bool SqlCipherDecryptor::writeToFile(std::string const &filename, bool overwrite) const
 {
+  if (d_lazy) [[unlikely]]
+  {
+    Logger::error("Decrypted data is not available when decrypting on demand");
+    return false;
+  }
+
   if (!overwrite && bepaald::fileOrDirExists(filename))
   {
     Logger::error("File ", filename, " exists, use --overwrite to overwrite");
@@ -0,0 +1,85 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "sqlitedb.ih"
+
+/*
+  Turns a query into the key it is profiled under: literals (numbers, strings
+  and blobs) become '?' and runs of whitespace become a single space. This way,
+  queries that have values pasted into them are counted as one statement.
+*/
+std::string SqliteDB::normalizeQuery(std::string_view q) // static
+{
+  auto isidentchar = [](char c) STATICLAMBDA
+  {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$' || static_cast<unsigned char>(c) >= 0x80;
+  };
+
+  std::string result;
+  result.reserve(q.size());
+  for (unsigned int i = 0; i < q.size(); ++i)
+  {
+    char c = q[i];
+    if (std::isspace(static_cast<unsigned char>(c)))
+    {
+      while (i + 1 < q.size() && std::isspace(static_cast<unsigned char>(q[i + 1])))
+        ++i;
+      if (!result.empty())
+        result += ' ';
+    }
+    else if (c == '\'') // string literal ('' is an escaped quote)
+    {
+      while (++i < q.size())
+        if (q[i] == '\'')
+        {
+          if (i + 1 < q.size() && q[i + 1] == '\'')
+            ++i;
+          else
+            break;
+        }
+      // blob literal (X'...')
+      if (!result.empty() && (result.back() == 'x' || result.back() == 'X') &&
+          (result.size() == 1 || !isidentchar(result[result.size() - 2])))
+        result.pop_back();
+      result += '?';
+    }
+    else if (c == '"' || c == '`' || c == '[') // quoted identifier, copied as is
+    {
+      std::string_view::size_type end = q.find(c == '[' ? ']' : c, i + 1);
+      if (end == std::string_view::npos)
+        end = q.size() - 1;
+      result.append(q.substr(i, end - i + 1));
+      i = end;
+    }
+    else if (std::isdigit(static_cast<unsigned char>(c)) && (result.empty() || !isidentchar(result.back()))) // numeric literal
+    {
+      while (i + 1 < q.size() &&
+             (isidentchar(q[i + 1]) || q[i + 1] == '.' ||
+              ((q[i + 1] == '+' || q[i + 1] == '-') && (q[i] == 'e' || q[i] == 'E'))))
+        ++i;
+      result += '?';
+    }
+    else
+      result += c;
+  }
+
+  while (!result.empty() && result.back() == ' ')
+    result.pop_back();
+  return result;
+}
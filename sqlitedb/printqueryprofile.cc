@@ -0,0 +1,44 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "sqlitedb.ih"
+
+void SqliteDB::printQueryProfile(unsigned int topn) // static
+{
+  std::lock_guard<std::mutex> lock(s_profile_mutex);
+
+  std::vector<std::pair<std::string const *, QueryProfile const *>> sorted;
+  sorted.reserve(s_query_profile.size());
+  uint64_t total_ns = 0;
+  for (auto const &[query, profile] : s_query_profile)
+  {
+    sorted.emplace_back(&query, &profile);
+    total_ns += profile.time_ns;
+  }
+  std::sort(sorted.begin(), sorted.end(), [](auto const &lhs, auto const &rhs) STATICLAMBDA { return lhs.second->time_ns > rhs.second->time_ns; });
+
+  Logger::message("Query profile: ", sorted.size(), " distinct statements, ", total_ns / 1000000, "ms total");
+  for (unsigned int i = 0; i < std::min(static_cast<size_t>(topn), sorted.size()); ++i)
+  {
+    QueryProfile const &p = *sorted[i].second;
+    std::string_view query(*sorted[i].first);
+    Logger::message(" ", i + 1, ". ", std::fixed, std::setprecision(3), p.time_ns / 1000000.0, std::defaultfloat, "ms, ", p.calls, " calls, ", p.rows, " rows, ",
+                    p.prepares, " prepares: ", query.substr(0, 200), (query.size() > 200 ? "..." : ""));
+  }
+}
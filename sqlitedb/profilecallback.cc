@@ -0,0 +1,69 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "sqlitedb.ih"
+
+/*
+  Called by sqlite for every statement of a profiled database (see
+  registerProfiler()). The time of a statement is measured here, from its
+  first step until it is done or reset: the time sqlite reports itself only
+  has millisecond resolution, which loses all the short statements.
+*/
+int SqliteDB::profileCallback(unsigned int type, void *, void *p, void *) // static
+{
+  sqlite3_stmt *stmt = reinterpret_cast<sqlite3_stmt *>(p);
+
+  std::lock_guard<std::mutex> lock(s_profile_mutex);
+
+  if (type == SQLITE_TRACE_STMT) // statement starts (or a trigger in it does)
+  {
+    s_profile_running.try_emplace(stmt, std::chrono::steady_clock::now(), 0);
+    return 0;
+  }
+
+  if (type == SQLITE_TRACE_ROW)
+  {
+    if (auto running = s_profile_running.find(stmt); running != s_profile_running.end()) [[likely]]
+      ++running->second.second;
+    return 0;
+  }
+
+  if (type == SQLITE_TRACE_PROFILE) // statement finished
+  {
+    auto running = s_profile_running.find(stmt);
+    if (running == s_profile_running.end()) [[unlikely]]
+      return 0;
+    auto [start, rows] = running->second;
+    s_profile_running.erase(running);
+
+    char const *sql = sqlite3_sql(stmt);
+    if (!sql) [[unlikely]]
+      return 0;
+
+    std::string query = normalizeQuery(sql);
+    auto it = s_query_profile.find(query);
+    if (it == s_query_profile.end())
+      it = s_query_profile.emplace(std::move(query), QueryProfile{0, 0, 0, 0}).first;
+
+    ++it->second.calls;
+    it->second.rows += rows;
+    it->second.time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  }
+  return 0;
+}
@@ -0,0 +1,31 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "sqlitedb.ih"
+
+void SqliteDB::profilePrepare(std::string_view q) // static
+{
+  std::string query = normalizeQuery(q);
+
+  std::lock_guard<std::mutex> lock(s_profile_mutex);
+  auto it = s_query_profile.find(query);
+  if (it == s_query_profile.end())
+    it = s_query_profile.emplace(std::move(query), QueryProfile{0, 0, 0, 0}).first;
+  ++it->second.prepares;
+}
@@ -21,15 +21,12 @@
 
 bool SqliteDB::QueryResults::removeColumn(unsigned int idx)
 {
-  if (idx >= d_headers.size())
+  if (idx >= d_headers.size() || idx >= d_columns.size())
     return false;
-  for (auto const &v : d_values)
-    if (idx >= v.size())
-      return false;
 
   d_headers.erase(d_headers.begin() + idx);
-  for (auto &v : d_values)
-    v.erase(v.begin() + idx);
+  d_columns.erase(d_columns.begin() + idx);
+  rebuildHeaderIndex();
 
   return true;
 }
@@ -25,6 +25,7 @@ bool SqliteDB::QueryResults::renameColumn(unsigned int idx, std::string const &n
     return false;
 
   d_headers[idx] = name;
+  rebuildHeaderIndex();
 
   return true;
 }
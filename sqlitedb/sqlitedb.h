@@ -26,9 +26,15 @@
 #include <set>
 #include <vector>
 #include <any>
+#include <atomic>
+#include <bit>
+#include <chrono>
 #include <iterator>
 #include <limits>
 #include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #if __cpp_lib_ranges >= 201911L
 #include <ranges>
 #endif
@@ -40,11 +46,44 @@
 class SqliteDB
 {
  public:
+  /*
+    Results are stored per column: for every cell a type tag (which also marks
+    NULLs) and a 64-bit value. For integers and doubles this is the value itself,
+    for text it indexes a list of (offset, length) pairs into one shared string
+    arena, for blobs it indexes the list of blobs. The std::any based accessors
+    are still available, the values are converted on access.
+  */
   class QueryResults
   {
+    enum class ValueType : uint8_t
+    {
+      NUL,
+      INT,
+      DOUBLE,
+      TEXT,
+      BLOB,
+    };
+
+    struct Column
+    {
+      std::vector<ValueType> types;
+      std::vector<int64_t> values;
+    };
+
+    struct HeaderHash
+    {
+      using is_transparent = void;
+      inline size_t operator()(std::string_view h) const { return std::hash<std::string_view>{}(h); }
+    };
+
     std::vector<std::string> d_headers;
-    std::vector<std::vector<std::any>> d_values;
-    int d_columncount{0};
+    std::unordered_map<std::string, int, HeaderHash, std::equal_to<>> d_headerindex;
+    std::vector<Column> d_columns;
+    std::string d_textarena;
+    std::vector<std::pair<uint64_t, uint64_t>> d_text; // offset and length in d_textarena
+    std::vector<std::pair<std::shared_ptr<unsigned char []>, size_t>> d_blobs;
+    size_t d_rows{0};
+    size_t d_nextcolumn{0};
 
    public:
     inline void reserveColumnCount(int cnt);
@@ -52,14 +91,19 @@ class SqliteDB
     inline std::vector<std::string> const &headers() const;
     inline std::string const &header(size_t idx) const;
     inline bool hasColumn(std::string const &h) const;
-    inline void emplaceValue(size_t row, std::any &&a);
+    inline void emplaceValue(size_t row, long long int v);
+    inline void emplaceValue(size_t row, double v);
+    inline void emplaceValue(size_t row, std::nullptr_t);
+    inline void emplaceValue(size_t row, std::string_view v);
+    inline void emplaceValue(size_t row, std::pair<std::shared_ptr<unsigned char []>, size_t> &&v);
     inline std::any value(size_t row, std::string_view header) const;
     template <typename T>
     inline T getValueAs(size_t row, std::string_view header) const;
     template <typename T>
     inline T getValueAs(size_t row, size_t idx) const;
-    inline std::any const &value(size_t row, size_t idx) const;
-    inline std::vector<std::any> const &row(size_t row) const;
+    inline std::string_view textView(size_t row, size_t idx) const;
+    inline std::any value(size_t row, size_t idx) const;
+    inline std::vector<std::any> row(size_t row) const;
     template <typename T>
     inline bool valueHasType(size_t row, size_t idx) const;
     template <typename T>
@@ -86,21 +130,113 @@ class SqliteDB
     bool renameColumn(unsigned int idx, std::string const &name);
     inline bool removeRow(unsigned int idx);
     inline QueryResults getRow(unsigned int idx);
+    inline QueryResults getRows(unsigned int first, unsigned int last, unsigned int firstcolumn = 0) const;
 
    private:
     inline int idxOfHeader(std::string_view header) const;
+    inline void rebuildHeaderIndex();
+    inline Column &nextColumn(size_t row);
     int availableWidth() const;
     inline uint64_t charCount(std::string const &utf8) const;
   };
 
+  /*
+    A view on the current row of a statement stepped by forEachRow(). Values are
+    read directly from the statement, nothing is copied. Text and blob views are
+    only valid until the callback returns.
+  */
+  class RowView
+  {
+    sqlite3_stmt *d_stmt;
+    int d_columns;
+
+   public:
+    inline explicit RowView(sqlite3_stmt *stmt);
+    inline int columns() const;
+    inline std::string_view header(int idx) const;
+    inline int idxOfHeader(std::string_view header) const;
+    template <typename T>
+    inline bool valueHasType(int idx) const;
+    inline bool isNull(int idx) const;
+    inline long long int getInt(int idx) const;
+    inline double getDouble(int idx) const;
+    inline std::string_view getText(int idx) const;
+    inline std::pair<unsigned char const *, size_t> getBlob(int idx) const;
+    inline std::any value(int idx) const;
+    std::string valueAsString(int idx) const;
+  };
+
+  /*
+    A prepared statement with compile-time typed parameter binding: every
+    argument goes straight to the matching execParamFiller() overload, no
+    std::any is involved. A Statement from prepare() owns its sqlite3_stmt
+    and can be reused for as many executions as needed. One from
+    cachedStatement() borrows it from the statement cache, and is only valid
+    until the next query is run on the database.
+  */
+  class Statement
+  {
+    friend class SqliteDB;
+
+    SqliteDB const *d_database;
+    sqlite3_stmt *d_stmt;
+    bool d_owned;
+
+    inline Statement(SqliteDB const *db, sqlite3_stmt *stmt, bool owned);
+   public:
+    inline Statement(Statement &&other) noexcept;
+    Statement(Statement const &other) = delete;
+    Statement &operator=(Statement const &other) = delete;
+    Statement &operator=(Statement &&other) = delete;
+    inline ~Statement();
+    inline bool ok() const;
+    inline int parameterCount() const;
+    template <typename... Args>
+    inline bool bind(Args const &... args);
+    template <typename T>
+    inline bool bindAt(int idx, T const &value);
+    inline bool step();
+    inline bool execute();
+    inline bool reset();
+    template <typename T>
+    inline T get(int col) const;
+    inline bool isNull(int col) const;
+    inline RowView row() const;
+  };
+
+  // counted over all databases of this process (from any thread, updated with relaxed
+  // atomics). Databases used in forked worker processes (--exporthtml) are not counted
+  struct StatementCacheStats
+  {
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    std::atomic<uint64_t> evictions;
+    std::atomic<uint64_t> preparetime_us; // total time spent in sqlite3_prepare_v2()
+  };
+
+  struct QueryProfile
+  {
+    uint64_t calls;    // completed executions
+    uint64_t rows;     // result rows stepped
+    uint64_t prepares;
+    uint64_t time_ns;  // total time from the first step until the statement finished
+  };
+
  private:
+  struct CachedStatement
+  {
+    std::string query;
+    sqlite3_stmt *stmt;
+  };
   mutable std::map<std::string, bool, std::less<>> d_tables; // cache results of containsTable/tableContainsColumn
   mutable std::map<std::string, std::map<std::string, bool, std::less<>>, std::less<>> d_columns;
   std::string d_name;
   sqlite3 *d_db;
   sqlite3_vfs *d_vfs;
-  mutable std::list<sqlite3_stmt *> d_stmt_cache; // cache (prepared) statements for reuse in subsequent transactions
-  unsigned int d_cache_size;
+  mutable std::list<CachedStatement> d_stmt_cache; // cache (prepared) statements for reuse, most recently used first
+  mutable std::unordered_map<std::string_view, std::list<CachedStatement>::iterator> d_stmt_cache_index; // keys point into d_stmt_cache
+  mutable std::unordered_set<size_t> d_stmt_evicted; // hashes of recently evicted queries
+  mutable unsigned int d_cache_size;
   sqlite3_stmt *d_stmt_pragma_schema_version;
   mutable char const *d_error_tail;
   std::pair<unsigned char *, uint64_t> *d_data;  // non-owning pointer!
@@ -113,6 +249,7 @@ class SqliteDB
   inline explicit SqliteDB();
   inline explicit SqliteDB(std::string const &name, bool readonly = true);
   inline explicit SqliteDB(std::pair<unsigned char *, uint64_t> *data);
+  inline explicit SqliteDB(MemFileDB::LazyData *data);
   inline SqliteDB(SqliteDB const &other);
   inline SqliteDB &operator=(SqliteDB const &other);
   inline ~SqliteDB();
@@ -126,6 +263,14 @@ class SqliteDB
   inline bool exec(std::string_view q, R &&params, QueryResults *results = nullptr, bool verbose = false) const;
 #endif
   inline bool exec(std::string_view q, std::vector<std::any> const &params, QueryResults *results = nullptr, bool verbose = false) const;
+  template <typename F>
+  inline bool forEachRow(std::string_view q, F &&fn) const;
+  template <typename F>
+  inline bool forEachRow(std::string_view q, std::any const &param, F &&fn) const;
+  template <typename F>
+  inline bool forEachRow(std::string_view q, std::vector<std::any> const &params, F &&fn) const;
+  inline Statement prepare(std::string_view q) const;
+  inline Statement cachedStatement(std::string_view q) const;
   template <typename T>
   inline T getSingleResultAs(std::string_view q, T const &defaultval) const;
   template <typename T>
@@ -155,14 +300,21 @@ class SqliteDB
   inline void freeMemory();
   void checkDatabaseWriteVersion() const;
   inline bool getStatement(std::string_view q, sqlite3_stmt **statement) const;
-  inline void setCacheSize(unsigned int size = 1);
+  inline void setCacheSize(unsigned int size = s_default_cache_size);
+  inline static StatementCacheStats const &statementCacheStats();
   static inline void setConfigOptions();
+  inline static void setProfiling(bool enable);
+  static void printQueryProfile(unsigned int topn);
+  static bool writeQueryProfile(std::string const &filename);
   inline int transactionState(bool quiet) const;
 
  private:
   inline bool initFromFile();
   inline bool initFromMemory();
   inline void destroy();
+  inline bool prepareStatement(std::string_view q, sqlite3_stmt **statement) const;
+  template <typename R>
+  inline bool bindParameters(sqlite3_stmt *stmt, std::string_view q, R &&params) const;
   inline int execParamFiller(int count, sqlite3_stmt *stmt, std::string const &param) const;
   inline int execParamFiller(int count, sqlite3_stmt *stmt, std::string_view param) const;
   inline int execParamFiller(int count, sqlite3_stmt *stmt, char const *param) const;
@@ -190,6 +342,18 @@ class SqliteDB
   static inline void tokencount(sqlite3_context *context, int argc, sqlite3_value **argv);
   static inline void token(sqlite3_context *context, int argc, sqlite3_value **argv);
   static inline void jsonlong(sqlite3_context *context, int argc, sqlite3_value **argv);
+  inline void registerProfiler() const;
+  static int profileCallback(unsigned int type, void *context, void *p, void *x);
+  static void profilePrepare(std::string_view q);
+  static std::string normalizeQuery(std::string_view q);
+
+  static unsigned int constexpr s_default_cache_size = 16;
+  static unsigned int constexpr s_max_cache_size = 256;
+  static inline StatementCacheStats s_stmt_cache_stats;
+  static inline bool s_profiling = false;
+  static inline std::mutex s_profile_mutex;
+  static inline std::map<std::string, QueryProfile, std::less<>> s_query_profile; // by normalized query
+  static inline std::unordered_map<sqlite3_stmt *, std::pair<std::chrono::steady_clock::time_point, uint64_t>> s_profile_running; // start, rows
 };
 
 inline SqliteDB::SqliteDB()
@@ -202,7 +366,7 @@ inline SqliteDB::SqliteDB(std::string const &name, bool readonly)
   d_name(name),
   d_db(nullptr),
   d_vfs(nullptr),
-  d_cache_size(1),
+  d_cache_size(s_default_cache_size),
   d_stmt_pragma_schema_version(nullptr),
   d_error_tail(nullptr),
   d_data(nullptr),
@@ -218,7 +382,7 @@ inline SqliteDB::SqliteDB(std::pair<unsigned char *, uint64_t> *data)
   :
   d_db(nullptr),
   d_vfs(MemFileDB::sqlite3_memfilevfs(data)),
-  d_cache_size(1),
+  d_cache_size(s_default_cache_size),
   d_stmt_pragma_schema_version(nullptr),
   d_error_tail(nullptr),
   d_data(data),
@@ -230,6 +394,22 @@ inline SqliteDB::SqliteDB(std::pair<unsigned char *, uint64_t> *data)
   d_ok = initFromMemory();
 }
 
+inline SqliteDB::SqliteDB(MemFileDB::LazyData *data)
+  :
+  d_db(nullptr),
+  d_vfs(MemFileDB::sqlite3_memfilevfs(data)),
+  d_cache_size(s_default_cache_size),
+  d_stmt_pragma_schema_version(nullptr),
+  d_error_tail(nullptr),
+  d_data(&data->header),
+  d_databasewriteversion(0),
+  d_readonly(true),
+  d_ok(false),
+  d_schema_version(std::numeric_limits<int32_t>::min())
+{
+  d_ok = initFromMemory();
+}
+
 inline SqliteDB::SqliteDB(SqliteDB const &other)
   :
   SqliteDB(":memory:")
@@ -250,6 +430,8 @@ inline SqliteDB &SqliteDB::operator=(SqliteDB const &other)
     d_db = nullptr;
     d_vfs = nullptr;
     d_stmt_cache.clear();
+    d_stmt_cache_index.clear();
+    d_stmt_evicted.clear();
     d_cache_size = other.d_cache_size;
     d_stmt_pragma_schema_version = nullptr;
     d_error_tail = nullptr;
@@ -289,6 +471,9 @@ inline bool SqliteDB::initFromFile()
 
   //sqlite3_set_authorizer(d_db, authorizer, &d_schema_changed);
 
+  if (s_profiling) [[unlikely]]
+    registerProfiler();
+
   return registerCustoms();
 }
 
@@ -308,6 +493,9 @@ inline bool SqliteDB::initFromMemory()
 
   //sqlite3_set_authorizer(d_db, authorizer, &d_schema_changed);
 
+  if (s_profiling) [[unlikely]]
+    registerProfiler();
+
   return registerCustoms();
 }
 
@@ -315,9 +503,9 @@ inline void SqliteDB::destroy()
 {
   //if (d_stmt)
   //  sqlite3_finalize(d_stmt);
-  for (auto &stmt : d_stmt_cache)
-    if (stmt)
-      sqlite3_finalize(stmt);
+  for (auto &cached : d_stmt_cache)
+    if (cached.stmt)
+      sqlite3_finalize(cached.stmt);
 
 
   if (d_stmt_pragma_schema_version)
@@ -371,6 +559,89 @@ inline bool SqliteDB::exec(std::string_view q, std::vector<std::any> const &para
   if (!getStatement(q, &stmt)) // get prepared statment from cache, or prepare a new one (and cache it, and return it)
     return false;
 
+  if (!bindParameters(stmt, q, params))
+    return false;
+
+  if (results)
+  {
+    results->clear();
+    results->reserveColumnCount(sqlite3_column_count(stmt));
+  }
+
+  int rc;
+  int row = 0;
+
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+  {
+    if (!results)
+      continue;
+
+    // if headers aren't set, set them
+    if (results->columns() == 0)
+      for (int c = 0; c < sqlite3_column_count(stmt); ++c)
+        results->emplaceHeader(sqlite3_column_name(stmt, c));
+
+    // set values
+    for (int c = 0; c < sqlite3_column_count(stmt); ++c)
+    {
+      auto coltype = sqlite3_column_type(stmt, c);
+      // order empirically determined
+      if (coltype == SQLITE_INTEGER)
+        results->emplaceValue(row, sqlite3_column_int64(stmt, c));
+      else if (coltype == SQLITE_NULL)
+        results->emplaceValue(row, nullptr);
+      else if (coltype == SQLITE_TEXT)
+        results->emplaceValue(row, std::string_view(reinterpret_cast<char const *>(sqlite3_column_text(stmt, c))));
+      else if (coltype == SQLITE_BLOB)
+      {
+        size_t blobsize = sqlite3_column_bytes(stmt, c);
+        std::shared_ptr<unsigned char []> blob;
+        if (blobsize) [[likely]]
+        {
+          blob.reset(new unsigned char[blobsize]);
+          std::memcpy(blob.get(), reinterpret_cast<unsigned char const *>(sqlite3_column_blob(stmt, c)), blobsize);
+        }
+        results->emplaceValue(row, std::make_pair(std::move(blob), blobsize));
+      }
+      else if (coltype == SQLITE_FLOAT)
+        results->emplaceValue(row, sqlite3_column_double(stmt, c));
+    }
+    ++row;
+  }
+
+  if (rc != SQLITE_DONE) [[unlikely]]
+  {
+    Logger::error("After sqlite3_step(): ", sqlite3_errmsg(d_db));
+    char *expanded_query = sqlite3_expanded_sql(stmt);
+    if (expanded_query)
+    {
+      Logger::error_indent("-> Query: \"", expanded_query, "\"");
+      sqlite3_free(expanded_query);
+    }
+
+    return false;
+  }
+
+  if (schemaVersionChanged()) [[unlikely]]
+  {
+    //Logger::message("QUERY CHANGED SCHEMA VERSION: ", q);
+    //Logger::message("VERSION NOW AT: ", d_schema_version);
+    clearTableCache();
+  }
+
+  return true;
+}
+
+#if __cpp_lib_ranges >= 201911L
+inline bool SqliteDB::exec(std::string_view q, std::vector<std::any> const &params, QueryResults *results, bool verbose) const
+{
+  return exec(q, std::views::all(params), results, verbose);
+}
+#endif
+
+template <typename R>
+inline bool SqliteDB::bindParameters(sqlite3_stmt *stmt, std::string_view q, R &&params) const
+{
   if (static_cast<int>(params.size()) != sqlite3_bind_parameter_count(stmt)) [[unlikely]]
   {
     if (sqlite3_bind_parameter_count(stmt) < static_cast<int>(params.size()))
@@ -568,84 +839,70 @@ inline bool SqliteDB::exec(std::string_view q, std::vector<std::any> const &para
     }
     ++i;
   }
+  return true;
+}
 
-  if (results)
-  {
-    results->clear();
-    results->reserveColumnCount(sqlite3_column_count(stmt));
-  }
+template <typename F>
+inline bool SqliteDB::forEachRow(std::string_view q, F &&fn) const
+{
+  return forEachRow(q, std::vector<std::any>(), std::forward<F>(fn));
+}
 
-  int rc;
-  int row = 0;
+template <typename F>
+inline bool SqliteDB::forEachRow(std::string_view q, std::any const &param, F &&fn) const
+{
+  return forEachRow(q, std::vector<std::any>{param}, std::forward<F>(fn));
+}
 
-  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
-  {
-    if (!results)
-      continue;
+/*
+  Runs the query and calls fn(RowView const &) for every result row as it is
+  stepped, so the full result set is never held in memory. When fn returns a
+  bool, returning false stops the iteration (this is not an error).
 
-    // if headers aren't set, set them
-    if (results->columns() == 0)
-      for (int c = 0; c < sqlite3_column_count(stmt); ++c)
-        results->emplaceHeader(sqlite3_column_name(stmt, c));
+  The statement is prepared for this call only, not taken from the statement
+  cache: it stays active while fn runs, and fn may well run other queries,
+  which could otherwise reset or evict it.
+*/
+template <typename F>
+inline bool SqliteDB::forEachRow(std::string_view q, std::vector<std::any> const &params, F &&fn) const
+{
+  sqlite3_stmt *s;
+  if (!prepareStatement(q, &s))
+    return false;
+  std::unique_ptr<sqlite3_stmt, decltype(&::sqlite3_finalize)> stmt(s, &::sqlite3_finalize);
 
-    // set values
-    for (int c = 0; c < sqlite3_column_count(stmt); ++c)
+  if (!bindParameters(stmt.get(), q, params))
+    return false;
+
+  RowView row(stmt.get());
+  int rc;
+  while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW)
+  {
+    if constexpr (std::is_same_v<std::invoke_result_t<F, RowView const &>, bool>)
     {
-      auto coltype = sqlite3_column_type(stmt, c);
-      // order empirically determined
-      if (coltype == SQLITE_INTEGER)
-        results->emplaceValue(row, sqlite3_column_int64(stmt, c));
-      else if (coltype == SQLITE_NULL)
-        results->emplaceValue(row, nullptr);
-      else if (coltype == SQLITE_TEXT)
-        results->emplaceValue(row, std::string(reinterpret_cast<char const *>(sqlite3_column_text(stmt, c))));
-      else if (coltype == SQLITE_BLOB)
+      if (!fn(std::as_const(row)))
       {
-        size_t blobsize = sqlite3_column_bytes(stmt, c);
-        std::shared_ptr<unsigned char []> blob;
-        if (blobsize) [[likely]]
-        {
-          blob.reset(new unsigned char[blobsize]);
-          std::memcpy(blob.get(), reinterpret_cast<unsigned char const *>(sqlite3_column_blob(stmt, c)), blobsize);
-        }
-        results->emplaceValue(row, std::make_pair(blob, blobsize));
+        rc = SQLITE_DONE;
+        break;
       }
-      else if (coltype == SQLITE_FLOAT)
-        results->emplaceValue(row, sqlite3_column_double(stmt, c));
     }
-    ++row;
+    else
+      fn(std::as_const(row));
   }
 
   if (rc != SQLITE_DONE) [[unlikely]]
   {
     Logger::error("After sqlite3_step(): ", sqlite3_errmsg(d_db));
-    char *expanded_query = sqlite3_expanded_sql(stmt);
-    if (expanded_query)
-    {
-      Logger::error_indent("-> Query: \"", expanded_query, "\"");
-      sqlite3_free(expanded_query);
-    }
-
+    Logger::error_indent("-> Query: \"", q, "\"");
     return false;
   }
 
   if (schemaVersionChanged()) [[unlikely]]
-  {
-    //Logger::message("QUERY CHANGED SCHEMA VERSION: ", q);
-    //Logger::message("VERSION NOW AT: ", d_schema_version);
     clearTableCache();
-  }
 
   return true;
 }
 
-#if __cpp_lib_ranges >= 201911L
-inline bool SqliteDB::exec(std::string_view q, std::vector<std::any> const &params, QueryResults *results, bool verbose) const
-{
-  return exec(q, std::views::all(params), results, verbose);
-}
-#endif
-
 template <typename T>
 inline T SqliteDB::getSingleResultAs(std::string_view q, T const &defaultval) const
 {
@@ -926,13 +1183,15 @@ inline void SqliteDB::freeMemory()
 
 inline void SqliteDB::QueryResults::reserveColumnCount(int cnt)
 {
-  d_columncount = cnt;
-  d_headers.reserve(d_columncount);
+  d_headers.reserve(cnt);
+  d_columns.reserve(cnt);
 }
 
 inline void SqliteDB::QueryResults::emplaceHeader(std::string &&h)
 {
-  d_headers.emplace_back(h);
+  d_headerindex.emplace(h, d_headers.size()); // if a name is used twice, the first column is found
+  d_headers.emplace_back(std::move(h));
+  d_columns.emplace_back();
 }
 
 inline std::string const &SqliteDB::QueryResults::header(size_t idx) const
@@ -947,30 +1206,96 @@ inline std::vector<std::string> const &SqliteDB::QueryResults::headers() const
 
 inline bool SqliteDB::QueryResults::hasColumn(std::string const &h) const
 {
-  return bepaald::contains(d_headers, h);
+  return d_headerindex.find(h) != d_headerindex.end();
 }
 
-inline void SqliteDB::QueryResults::emplaceValue(size_t row, std::any &&a)
+inline void SqliteDB::QueryResults::rebuildHeaderIndex()
 {
-  if (d_values.size() < row + 1)
-  {
-    d_values.resize(row + 1);
-    d_values[row].reserve(d_columncount);
-  }
+  d_headerindex.clear();
+  for (unsigned int i = 0; i < d_headers.size(); ++i)
+    d_headerindex.emplace(d_headers[i], i);
+}
 
-  d_values[row].emplace_back(a);
+// values are added row by row, each row from the first to the last column
+inline SqliteDB::QueryResults::Column &SqliteDB::QueryResults::nextColumn(size_t row)
+{
+  if (d_nextcolumn >= d_columns.size())
+    d_nextcolumn = 0;
+  if (d_rows < row + 1)
+    d_rows = row + 1;
+  return d_columns[d_nextcolumn++];
+}
+
+inline void SqliteDB::QueryResults::emplaceValue(size_t row, long long int v)
+{
+  Column &c = nextColumn(row);
+  c.types.push_back(ValueType::INT);
+  c.values.push_back(v);
+}
+
+inline void SqliteDB::QueryResults::emplaceValue(size_t row, double v)
+{
+  Column &c = nextColumn(row);
+  c.types.push_back(ValueType::DOUBLE);
+  c.values.push_back(std::bit_cast<int64_t>(v));
+}
+
+inline void SqliteDB::QueryResults::emplaceValue(size_t row, std::nullptr_t)
+{
+  Column &c = nextColumn(row);
+  c.types.push_back(ValueType::NUL);
+  c.values.push_back(0);
+}
+
+inline void SqliteDB::QueryResults::emplaceValue(size_t row, std::string_view v)
+{
+  Column &c = nextColumn(row);
+  c.types.push_back(ValueType::TEXT);
+  c.values.push_back(d_text.size());
+  d_text.emplace_back(d_textarena.size(), v.size());
+  d_textarena.append(v);
 }
 
-inline std::any const &SqliteDB::QueryResults::value(size_t row, size_t idx) const
+inline void SqliteDB::QueryResults::emplaceValue(size_t row, std::pair<std::shared_ptr<unsigned char []>, size_t> &&v)
 {
-  return d_values[row][idx];
+  Column &c = nextColumn(row);
+  c.types.push_back(ValueType::BLOB);
+  c.values.push_back(d_blobs.size());
+  d_blobs.emplace_back(std::move(v));
+}
+
+inline std::string_view SqliteDB::QueryResults::textView(size_t row, size_t idx) const
+{
+  if (d_columns[idx].types[row] != ValueType::TEXT) [[unlikely]]
+    return std::string_view();
+  auto const &[offset, length] = d_text[d_columns[idx].values[row]];
+  return std::string_view(d_textarena.data() + offset, length);
+}
+
+inline std::any SqliteDB::QueryResults::value(size_t row, size_t idx) const
+{
+  int64_t v = d_columns[idx].values[row];
+  switch (d_columns[idx].types[row])
+  {
+    case ValueType::INT:
+      return std::any{static_cast<long long int>(v)};
+    case ValueType::TEXT:
+      return std::any{std::string(textView(row, idx))};
+    case ValueType::BLOB:
+      return std::any{d_blobs[v]};
+    case ValueType::DOUBLE:
+      return std::any{std::bit_cast<double>(v)};
+    case ValueType::NUL:
+      break;
+  }
+  return std::any{nullptr};
 }
 
 inline int SqliteDB::QueryResults::idxOfHeader(std::string_view header) const
 {
-  for (int i = 0; i < static_cast<int>(d_headers.size()); ++i)
-    if (d_headers[i] == header)
-      return i;
+  auto it = d_headerindex.find(header);
+  if (it != d_headerindex.end()) [[likely]]
+    return it->second;
   [[unlikely]] return -1;
 }
 
@@ -982,7 +1307,7 @@ inline std::any SqliteDB::QueryResults::value(size_t row, std::string_view heade
     Logger::warning("Column `", header, "' not found in query results");
     return std::any{nullptr};
   }
-  return d_values[row][i];
+  return value(row, i);
 }
 
 template <typename T>
@@ -1000,13 +1325,24 @@ inline T SqliteDB::QueryResults::getValueAs(size_t row, std::string_view header)
 template <typename T>
 inline T SqliteDB::QueryResults::getValueAs(size_t row, size_t idx) const
 {
-  if (d_values[row][idx].type() != typeid(T)) [[unlikely]]
+  if (valueHasType<T>(row, idx)) [[likely]]
   {
-    Logger::message("Getting value of field '", d_headers[idx], "' (idx ", idx, "). Value as string: ", valueAsString(row, idx));
-    Logger::message("Type: ", d_values[row][idx].type().name(), " Requested type: ", typeid(T).name());
-    //return T{};
+    if constexpr (std::is_same_v<T, long long int>)
+      return d_columns[idx].values[row];
+    else if constexpr (std::is_same_v<T, std::string>)
+      return std::string(textView(row, idx));
+    else if constexpr (std::is_same_v<T, double>)
+      return std::bit_cast<double>(d_columns[idx].values[row]);
+    else if constexpr (std::is_same_v<T, std::pair<std::shared_ptr<unsigned char []>, size_t>>)
+      return d_blobs[d_columns[idx].values[row]];
+    else if constexpr (std::is_same_v<T, std::nullptr_t>)
+      return nullptr;
   }
-  return std::any_cast<T>(d_values[row][idx]);
+
+  std::any v(value(row, idx));
+  Logger::message("Getting value of field '", d_headers[idx], "' (idx ", idx, "). Value as string: ", valueAsString(row, idx));
+  Logger::message("Type: ", v.type().name(), " Requested type: ", typeid(T).name());
+  return std::any_cast<T>(v);
 }
 
 template <typename T>
@@ -1024,7 +1360,18 @@ inline bool SqliteDB::QueryResults::valueHasType(size_t row, std::string_view he
 template <typename T>
 inline bool SqliteDB::QueryResults::valueHasType(size_t row, size_t idx) const
 {
-  return (d_values[row][idx].type() == typeid(T));
+  if constexpr (std::is_same_v<T, long long int>)
+    return d_columns[idx].types[row] == ValueType::INT;
+  else if constexpr (std::is_same_v<T, std::string>)
+    return d_columns[idx].types[row] == ValueType::TEXT;
+  else if constexpr (std::is_same_v<T, std::nullptr_t>)
+    return d_columns[idx].types[row] == ValueType::NUL;
+  else if constexpr (std::is_same_v<T, std::pair<std::shared_ptr<unsigned char []>, size_t>>)
+    return d_columns[idx].types[row] == ValueType::BLOB;
+  else if constexpr (std::is_same_v<T, double>)
+    return d_columns[idx].types[row] == ValueType::DOUBLE;
+  else // other types are never stored
+    return false;
 }
 
 inline bool SqliteDB::QueryResults::isNull(size_t row, size_t idx) const
@@ -1039,12 +1386,12 @@ inline bool SqliteDB::QueryResults::isNull(size_t row, std::string_view header)
 
 inline bool SqliteDB::QueryResults::empty() const
 {
-  return d_values.empty();
+  return d_rows == 0;
 }
 
 inline size_t SqliteDB::QueryResults::rows() const
 {
-  return d_values.size();
+  return d_rows;
 }
 
 inline size_t SqliteDB::QueryResults::columns() const
@@ -1055,7 +1402,13 @@ inline size_t SqliteDB::QueryResults::columns() const
 inline void SqliteDB::QueryResults::clear()
 {
   d_headers.clear();
-  d_values.clear();
+  d_headerindex.clear();
+  d_columns.clear();
+  d_textarena.clear();
+  d_text.clear();
+  d_blobs.clear();
+  d_rows = 0;
+  d_nextcolumn = 0;
 }
 
 inline std::string SqliteDB::QueryResults::operator()(size_t row, std::string_view header) const
@@ -1071,17 +1424,21 @@ inline std::string SqliteDB::QueryResults::operator()(std::string_view header) c
 template <typename T>
 inline bool SqliteDB::QueryResults::contains(T const &value) const
 {
-  for (unsigned int i = 0; i < d_values.size(); ++i)
-    for (unsigned int j = 0; j < d_values[i].size(); ++j)
-      if (d_values[i][j].type() == typeid(T))
-        if (std::any_cast<T>(d_values[i][j]) == value)
+  for (unsigned int i = 0; i < d_rows; ++i)
+    for (unsigned int j = 0; j < d_columns.size(); ++j)
+      if (valueHasType<T>(i, j))
+        if (getValueAs<T>(i, j) == value)
           return true;
   return false;
 }
 
-inline std::vector<std::any> const &SqliteDB::QueryResults::row(size_t row) const
+inline std::vector<std::any> SqliteDB::QueryResults::row(size_t row) const
 {
-  return d_values[row];
+  std::vector<std::any> r;
+  r.reserve(d_columns.size());
+  for (unsigned int j = 0; j < d_columns.size(); ++j)
+    r.emplace_back(value(row, j));
+  return r;
 }
 
 /*
@@ -1110,23 +1467,329 @@ inline uint64_t SqliteDB::QueryResults::charCount(std::string const &utf8) const
   return ret;
 }
 
+// note: text and blob data of the removed row stay allocated until clear()
 inline bool SqliteDB::QueryResults::removeRow(unsigned int idx)
 {
-  if (idx >= d_values.size())
+  if (idx >= d_rows)
     return false;
 
-  d_values.erase(d_values.begin() + idx);
+  for (auto &c : d_columns)
+  {
+    c.types.erase(c.types.begin() + idx);
+    c.values.erase(c.values.begin() + idx);
+  }
+  --d_rows;
   return true;
 }
 
 inline SqliteDB::QueryResults SqliteDB::QueryResults::getRow(unsigned int idx)
+{
+  return getRows(idx, idx + 1);
+}
+
+// copies rows [first, last), and columns [firstcolumn, columns())
+inline SqliteDB::QueryResults SqliteDB::QueryResults::getRows(unsigned int first, unsigned int last, unsigned int firstcolumn) const
 {
   QueryResults tmp;
-  tmp.d_headers = d_headers;
-  tmp.d_values.push_back(d_values[idx]);
+  tmp.reserveColumnCount(d_headers.size() - firstcolumn);
+  for (unsigned int j = firstcolumn; j < d_headers.size(); ++j)
+    tmp.emplaceHeader(std::string(d_headers[j]));
+  for (unsigned int idx = first; idx < last; ++idx)
+    for (unsigned int j = firstcolumn; j < d_columns.size(); ++j)
+    {
+      switch (d_columns[j].types[idx])
+      {
+        case ValueType::INT:
+          tmp.emplaceValue(idx - first, static_cast<long long int>(d_columns[j].values[idx]));
+          break;
+        case ValueType::DOUBLE:
+          tmp.emplaceValue(idx - first, std::bit_cast<double>(d_columns[j].values[idx]));
+          break;
+        case ValueType::TEXT:
+          tmp.emplaceValue(idx - first, textView(idx, j));
+          break;
+        case ValueType::BLOB:
+          tmp.emplaceValue(idx - first, std::pair<std::shared_ptr<unsigned char []>, size_t>(d_blobs[d_columns[j].values[idx]]));
+          break;
+        case ValueType::NUL:
+          tmp.emplaceValue(idx - first, nullptr);
+          break;
+      }
+    }
   return tmp;
 }
 
+inline SqliteDB::RowView::RowView(sqlite3_stmt *stmt)
+  :
+  d_stmt(stmt),
+  d_columns(sqlite3_column_count(stmt))
+{}
+
+inline int SqliteDB::RowView::columns() const
+{
+  return d_columns;
+}
+
+inline std::string_view SqliteDB::RowView::header(int idx) const
+{
+  return sqlite3_column_name(d_stmt, idx);
+}
+
+inline int SqliteDB::RowView::idxOfHeader(std::string_view header) const
+{
+  for (int i = 0; i < d_columns; ++i)
+    if (header == sqlite3_column_name(d_stmt, i))
+      return i;
+  return -1;
+}
+
+template <typename T>
+inline bool SqliteDB::RowView::valueHasType(int idx) const
+{
+  if constexpr (std::is_same_v<T, long long int>)
+    return sqlite3_column_type(d_stmt, idx) == SQLITE_INTEGER;
+  else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>)
+    return sqlite3_column_type(d_stmt, idx) == SQLITE_TEXT;
+  else if constexpr (std::is_same_v<T, std::nullptr_t>)
+    return sqlite3_column_type(d_stmt, idx) == SQLITE_NULL;
+  else if constexpr (std::is_same_v<T, std::pair<std::shared_ptr<unsigned char []>, size_t>> ||
+                     std::is_same_v<T, std::pair<unsigned char const *, size_t>>)
+    return sqlite3_column_type(d_stmt, idx) == SQLITE_BLOB;
+  else if constexpr (std::is_same_v<T, double>)
+    return sqlite3_column_type(d_stmt, idx) == SQLITE_FLOAT;
+  else
+    return false;
+}
+
+inline bool SqliteDB::RowView::isNull(int idx) const
+{
+  return sqlite3_column_type(d_stmt, idx) == SQLITE_NULL;
+}
+
+inline long long int SqliteDB::RowView::getInt(int idx) const
+{
+  return sqlite3_column_int64(d_stmt, idx);
+}
+
+inline double SqliteDB::RowView::getDouble(int idx) const
+{
+  return sqlite3_column_double(d_stmt, idx);
+}
+
+inline std::string_view SqliteDB::RowView::getText(int idx) const
+{
+  // call _text() before _bytes(), so the size is that of the utf-8 representation
+  char const *text = reinterpret_cast<char const *>(sqlite3_column_text(d_stmt, idx));
+  if (!text) [[unlikely]]
+    return std::string_view();
+  return std::string_view(text, sqlite3_column_bytes(d_stmt, idx));
+}
+
+inline std::pair<unsigned char const *, size_t> SqliteDB::RowView::getBlob(int idx) const
+{
+  unsigned char const *blob = reinterpret_cast<unsigned char const *>(sqlite3_column_blob(d_stmt, idx));
+  return {blob, blob ? sqlite3_column_bytes(d_stmt, idx) : 0};
+}
+
+// returns a copy of the value, in the same form as QueryResults::value()
+inline std::any SqliteDB::RowView::value(int idx) const
+{
+  switch (sqlite3_column_type(d_stmt, idx))
+  {
+    case SQLITE_INTEGER:
+      return getInt(idx);
+    case SQLITE_FLOAT:
+      return getDouble(idx);
+    case SQLITE_TEXT:
+      return std::string(getText(idx));
+    case SQLITE_BLOB:
+    {
+      auto [data, size] = getBlob(idx);
+      std::shared_ptr<unsigned char []> blob;
+      if (size) [[likely]]
+      {
+        blob.reset(new unsigned char[size]);
+        std::memcpy(blob.get(), data, size);
+      }
+      return std::make_pair(std::move(blob), size);
+    }
+    default:
+      return nullptr;
+  }
+}
+
+inline SqliteDB::Statement::Statement(SqliteDB const *db, sqlite3_stmt *stmt, bool owned)
+  :
+  d_database(db),
+  d_stmt(stmt),
+  d_owned(owned)
+{}
+
+inline SqliteDB::Statement::Statement(Statement &&other) noexcept
+  :
+  d_database(other.d_database),
+  d_stmt(other.d_stmt),
+  d_owned(other.d_owned)
+{
+  other.d_stmt = nullptr;
+}
+
+inline SqliteDB::Statement::~Statement()
+{
+  if (!d_stmt)
+    return;
+  if (d_owned)
+    sqlite3_finalize(d_stmt);
+  else
+    sqlite3_reset(d_stmt);
+}
+
+inline bool SqliteDB::Statement::ok() const
+{
+  return d_stmt != nullptr;
+}
+
+inline int SqliteDB::Statement::parameterCount() const
+{
+  return sqlite3_bind_parameter_count(d_stmt);
+}
+
+// resets the statement and binds all its parameters, in order
+template <typename... Args>
+inline bool SqliteDB::Statement::bind(Args const &... args)
+{
+  if (!reset())
+    return false;
+
+  if (static_cast<int>(sizeof...(Args)) != sqlite3_bind_parameter_count(d_stmt)) [[unlikely]]
+  {
+    Logger::error("Wrong number of parameters for query (parameters: ", sizeof...(Args),
+                  ", placeholders: ", sqlite3_bind_parameter_count(d_stmt), ")");
+    Logger::error_indent("-> Query: \"", sqlite3_sql(d_stmt), "\"");
+    return false;
+  }
+
+  [[maybe_unused]] int idx = 0;
+  return (bindAt(++idx, args) && ...);
+}
+
+// binds a single parameter (idx is 1-based). The statement must not be mid-execution
+template <typename T>
+inline bool SqliteDB::Statement::bindAt(int idx, T const &value)
+{
+  if (d_database->execParamFiller(idx, d_stmt, value) != SQLITE_OK) [[unlikely]]
+  {
+    Logger::error("During sqlite3_bind_*(): ", sqlite3_errmsg(d_database->d_db));
+    Logger::error_indent("-> Query: \"", sqlite3_sql(d_stmt), "\"");
+    return false;
+  }
+  return true;
+}
+
+// returns true while there is a result row to read. Returns false when done,
+// or on error (which is logged)
+inline bool SqliteDB::Statement::step()
+{
+  int rc = sqlite3_step(d_stmt);
+  if (rc == SQLITE_ROW)
+    return true;
+
+  if (rc != SQLITE_DONE) [[unlikely]]
+  {
+    Logger::error("After sqlite3_step(): ", sqlite3_errmsg(d_database->d_db));
+    char *expanded_query = sqlite3_expanded_sql(d_stmt);
+    if (expanded_query)
+    {
+      Logger::error_indent("-> Query: \"", expanded_query, "\"");
+      sqlite3_free(expanded_query);
+    }
+  }
+  else if (d_database->schemaVersionChanged()) [[unlikely]]
+    d_database->clearTableCache();
+  return false;
+}
+
+// runs the statement to completion, ignoring any result rows
+inline bool SqliteDB::Statement::execute()
+{
+  int rc;
+  while ((rc = sqlite3_step(d_stmt)) == SQLITE_ROW)
+    ;
+
+  if (rc != SQLITE_DONE) [[unlikely]]
+  {
+    Logger::error("After sqlite3_step(): ", sqlite3_errmsg(d_database->d_db));
+    char *expanded_query = sqlite3_expanded_sql(d_stmt);
+    if (expanded_query)
+    {
+      Logger::error_indent("-> Query: \"", expanded_query, "\"");
+      sqlite3_free(expanded_query);
+    }
+    return false;
+  }
+
+  if (d_database->schemaVersionChanged()) [[unlikely]]
+    d_database->clearTableCache();
+
+  return true;
+}
+
+inline bool SqliteDB::Statement::reset()
+{
+  if (sqlite3_reset(d_stmt) != SQLITE_OK) [[unlikely]]
+  {
+    Logger::error("During sqlite3_reset(): ", sqlite3_errmsg(d_database->d_db));
+    Logger::error_indent("-> Query: \"", sqlite3_sql(d_stmt), "\"");
+    return false;
+  }
+  return true;
+}
+
+template <typename T>
+inline T SqliteDB::Statement::get(int col) const
+{
+  if constexpr (std::is_same_v<T, long long int>)
+    return sqlite3_column_int64(d_stmt, col);
+  else if constexpr (std::is_same_v<T, double>)
+    return sqlite3_column_double(d_stmt, col);
+  else if constexpr (std::is_same_v<T, std::string_view>)
+    return RowView(d_stmt).getText(col);
+  else if constexpr (std::is_same_v<T, std::string>)
+    return std::string(RowView(d_stmt).getText(col));
+  else if constexpr (std::is_same_v<T, std::pair<unsigned char const *, size_t>>)
+    return RowView(d_stmt).getBlob(col);
+  else
+    static_assert(!sizeof(T), "Unsupported type for Statement::get<T>()");
+}
+
+inline bool SqliteDB::Statement::isNull(int col) const
+{
+  return sqlite3_column_type(d_stmt, col) == SQLITE_NULL;
+}
+
+inline SqliteDB::RowView SqliteDB::Statement::row() const
+{
+  return RowView(d_stmt);
+}
+
+// prepares a new statement, owned by the returned handle
+inline SqliteDB::Statement SqliteDB::prepare(std::string_view q) const
+{
+  sqlite3_stmt *stmt = nullptr;
+  if (!prepareStatement(q, &stmt))
+    stmt = nullptr;
+  return Statement(this, stmt, true);
+}
+
+// get a handle on a statement from the cache (prepared and cached if needed)
+inline SqliteDB::Statement SqliteDB::cachedStatement(std::string_view q) const
+{
+  sqlite3_stmt *stmt = nullptr;
+  if (!getStatement(q, &stmt))
+    stmt = nullptr;
+  return Statement(this, stmt, false);
+}
+
 inline bool SqliteDB::prepareSchemaVersionStatement()
 {
   if (!d_stmt_pragma_schema_version) [[likely]]
@@ -1321,77 +1984,112 @@ inline void SqliteDB::jsonlong(sqlite3_context *context, int argc, sqlite3_value
   sqlite3_result_null(context);
 }
 
+/*
+  Prepared statements are kept in an LRU cache, looked up by (a hash of) the
+  query text. The cache grows when a query that was evicted recently is needed
+  again: that means the working set of the current caller does not fit.
+*/
 inline bool SqliteDB::getStatement(std::string_view q, sqlite3_stmt **statement) const
 {
-  auto it = std::find_if(d_stmt_cache.begin(), d_stmt_cache.end(),
-                         [&](sqlite3_stmt *stmt) { return sqlite3_sql(stmt) == q; });
-  if (it == d_stmt_cache.end()) // query not cached
+  auto it = d_stmt_cache_index.find(q);
+  if (it == d_stmt_cache_index.end()) // query not cached
   {
     //std::cout << std::endl << "NEW STATEMENT :'" << q << "'" << std::endl;
+    s_stmt_cache_stats.misses.fetch_add(1, std::memory_order_relaxed);
+
+    // if this query was needed before, the cache is too small for the current working set
+    size_t qhash = std::hash<std::string_view>{}(q);
+    if (d_stmt_evicted.erase(qhash) && d_cache_size < s_max_cache_size)
+      ++d_cache_size;
 
     // cache is full, make room for new statement
-    if (d_stmt_cache.size() >= d_cache_size)
+    while (d_stmt_cache.size() >= d_cache_size)
     {
-      sqlite3_finalize(d_stmt_cache.back());
+      if (d_stmt_evicted.size() >= s_max_cache_size * 4) [[unlikely]]
+        d_stmt_evicted.clear();
+      d_stmt_evicted.insert(std::hash<std::string_view>{}(d_stmt_cache.back().query));
+      d_stmt_cache_index.erase(d_stmt_cache.back().query);
+      sqlite3_finalize(d_stmt_cache.back().stmt);
       d_stmt_cache.pop_back();
+      s_stmt_cache_stats.evictions.fetch_add(1, std::memory_order_relaxed);
     }
 
     // create new statement and prepare it.
     sqlite3_stmt *result;
-    // prepare the statement, and put it in front of list
-    if (sqlite3_prepare_v2(d_db, q.data(), q.size(), &result, &d_error_tail) != SQLITE_OK) [[unlikely]]
-    {
-      Logger::error("During sqlite3_prepare_v2(): ", sqlite3_errmsg(d_db));
-      // attempt to mark the token that sqlite choked on
-      long long int error_pos = std::distance(q.data(), d_error_tail);
-      long long int error_start = error_pos; // find the token where the error starts...
-      while (error_start > 0 &&
-             ((q[error_start - 1] >= 'a' && q[error_start - 1] <= 'z') ||
-              (q[error_start - 1] >= 'A' && q[error_start - 1] <= 'Z') ||
-              (q[error_start - 1] >= '0' && q[error_start - 1] <= '9')))
-        --error_start;
-      Logger::error_indent("-> Query: \"",
-                           q.substr(0, error_start),
-                           Logger::Control::BOLD,
-                           q.substr(error_start, error_pos - error_start),
-                           Logger::Control::NORMAL,
-                           q.substr(error_pos),
-                           "\"");
-
+    if (!prepareStatement(q, &result))
       return false;
-    }
-    // cache it
-    d_stmt_cache.push_front(result);
+
+    // cache it, put it in front of list
+    d_stmt_cache.emplace_front(CachedStatement{std::string(q), result});
+    d_stmt_cache_index.emplace(d_stmt_cache.front().query, d_stmt_cache.begin());
     // set return, done!
     *statement = result;
     return true;
   }
   // else statement found in cache!
-  d_stmt_cache.splice(d_stmt_cache.begin(), d_stmt_cache, it); // move it to front
-  if (sqlite3_reset(*it) != SQLITE_OK) [[unlikely]] // reuse existing prepared statement
+  s_stmt_cache_stats.hits.fetch_add(1, std::memory_order_relaxed);
+  d_stmt_cache.splice(d_stmt_cache.begin(), d_stmt_cache, it->second); // move it to front
+  if (sqlite3_reset(it->second->stmt) != SQLITE_OK) [[unlikely]] // reuse existing prepared statement
   {
     Logger::error("During sqlite3_reset(): ", sqlite3_errmsg(d_db));
     Logger::error_indent("-> Query: \"", q, "\"");
     return false;
   }
-  *statement = *it;
+  *statement = it->second->stmt;
+  return true;
+}
+
+inline bool SqliteDB::prepareStatement(std::string_view q, sqlite3_stmt **statement) const
+{
+  if (s_profiling) [[unlikely]]
+    profilePrepare(q);
+
+  auto t1 = std::chrono::steady_clock::now();
+  int rc = sqlite3_prepare_v2(d_db, q.data(), q.size(), statement, &d_error_tail);
+  s_stmt_cache_stats.preparetime_us.fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t1).count(),
+                                            std::memory_order_relaxed);
+  if (rc != SQLITE_OK) [[unlikely]]
+  {
+    Logger::error("During sqlite3_prepare_v2(): ", sqlite3_errmsg(d_db));
+    // attempt to mark the token that sqlite choked on
+    long long int error_pos = std::distance(q.data(), d_error_tail);
+    long long int error_start = error_pos; // find the token where the error starts...
+    while (error_start > 0 &&
+           ((q[error_start - 1] >= 'a' && q[error_start - 1] <= 'z') ||
+            (q[error_start - 1] >= 'A' && q[error_start - 1] <= 'Z') ||
+            (q[error_start - 1] >= '0' && q[error_start - 1] <= '9')))
+      --error_start;
+    Logger::error_indent("-> Query: \"",
+                         q.substr(0, error_start),
+                         Logger::Control::BOLD,
+                         q.substr(error_start, error_pos - error_start),
+                         Logger::Control::NORMAL,
+                         q.substr(error_pos),
+                         "\"");
+
+    return false;
+  }
   return true;
 }
 
+// sets the (initial) size of the statement cache, it will grow from here if needed
 inline void SqliteDB::setCacheSize(unsigned int size)
 {
   //Logger::message("Setting statement cache size to ", size);
-  d_cache_size = size;
-  if (d_stmt_cache.size() > d_cache_size)
+  d_cache_size = std::max(size, 1u);
+  while (d_stmt_cache.size() > d_cache_size)
   {
-    unsigned int i = 0;
-    for (auto it = d_stmt_cache.begin(); it != d_stmt_cache.end(); ++it, ++i)
-      if (i >= d_cache_size && *it)
-        sqlite3_finalize(*it);
-    d_stmt_cache.resize(d_cache_size);
+    d_stmt_cache_index.erase(d_stmt_cache.back().query);
+    sqlite3_finalize(d_stmt_cache.back().stmt);
+    d_stmt_cache.pop_back();
   }
 }
 
+inline SqliteDB::StatementCacheStats const &SqliteDB::statementCacheStats() // static
+{
+  return s_stmt_cache_stats;
+}
+
 // only call this once, before any other sqlite functions,
 // subsequent calls will fail (though it shouldn't do harm).
 // Also, we don't check the return code as it could fail
@@ -1410,6 +2108,19 @@ inline void SqliteDB::setConfigOptions() //static
   sqlite3_config(SQLITE_CONFIG_URI, 1);
 }
 
+// when enabled, every database opened from here on reports its statements to the query profiler
+inline void SqliteDB::setProfiling(bool enable) // static
+{
+  s_profiling = enable;
+}
+
+inline void SqliteDB::registerProfiler() const
+{
+#if SQLITE_VERSION_NUMBER >= 3014000 // sqlite3_trace_v2() was added in 3.14.0
+  sqlite3_trace_v2(d_db, SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE | SQLITE_TRACE_ROW, &SqliteDB::profileCallback, nullptr);
+#endif
+}
+
 inline int SqliteDB::transactionState(bool quiet) const
 {
 #if SQLITE_VERSION_NUMBER >= 3034000
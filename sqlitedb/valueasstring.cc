@@ -60,3 +60,23 @@ std::string SqliteDB::QueryResults::valueAsString(size_t row, std::string_view h
   }
   return valueAsString(row, i);
 }
+
+std::string SqliteDB::RowView::valueAsString(int idx) const
+{
+  switch (sqlite3_column_type(d_stmt, idx))
+  {
+    case SQLITE_TEXT:
+      return std::string(getText(idx));
+    case SQLITE_INTEGER:
+      return bepaald::toString(getInt(idx));
+    case SQLITE_BLOB:
+    {
+      auto [data, size] = getBlob(idx);
+      return Base64::bytesToBase64String(data, size);
+    }
+    case SQLITE_FLOAT:
+      return bepaald::toString(getDouble(idx));
+    default: // SQLITE_NULL
+      return std::string();
+  }
+}
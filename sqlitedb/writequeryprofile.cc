@@ -0,0 +1,61 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "sqlitedb.ih"
+
+#include <fstream>
+
+// writes all profiled statements to filename as JSON, sorted by total time
+bool SqliteDB::writeQueryProfile(std::string const &filename) // static
+{
+  std::ofstream out(filename, std::ios_base::binary);
+  if (!out.is_open()) [[unlikely]]
+  {
+    Logger::error("Failed to open '", filename, "' for writing");
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(s_profile_mutex);
+
+  std::vector<std::pair<std::string const *, QueryProfile const *>> sorted;
+  sorted.reserve(s_query_profile.size());
+  for (auto const &[query, profile] : s_query_profile)
+    sorted.emplace_back(&query, &profile);
+  std::sort(sorted.begin(), sorted.end(), [](auto const &lhs, auto const &rhs) STATICLAMBDA { return lhs.second->time_ns > rhs.second->time_ns; });
+
+  out << "{\n  \"statements\": [";
+  for (unsigned int i = 0; i < sorted.size(); ++i)
+  {
+    std::string query;
+    bepaald::appendJsonString(&query, *sorted[i].first);
+
+    QueryProfile const &p = *sorted[i].second;
+    out << (i ? ",\n" : "\n") << "    {\"query\": " << query << ", \"calls\": " << p.calls << ", \"rows\": " << p.rows
+        << ", \"prepares\": " << p.prepares << ", \"time_ns\": " << p.time_ns << "}";
+  }
+  out << "\n  ]\n}\n";
+
+  if (!out) [[unlikely]]
+  {
+    Logger::error("Failed to write query profile to '", filename, "'");
+    return false;
+  }
+  Logger::message("Wrote query profile to '", filename, "'");
+  return true;
+}
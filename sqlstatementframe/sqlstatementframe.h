@@ -80,8 +80,9 @@ class SqlStatementFrame final : public BackupFrame
   inline std::pair<unsigned char *, uint64_t> getData() const override;
 
   inline void setStatementField(std::string const &val);
-  inline void addStringParameter(std::string const &val);
+  inline void addStringParameter(std::string_view val);
   inline void addBlobParameter(std::pair<std::shared_ptr<unsigned char []>, size_t> const &val);
+  inline void addBlobParameter(unsigned char const *data, size_t size);
   inline void addIntParameter(int64_t val);
   inline void addNullParameter();
   inline void addDoubleParameter(double val);
@@ -90,6 +91,9 @@ class SqlStatementFrame final : public BackupFrame
   inline std::string bindStatement() const;
   inline std::string_view bindStatementView() const;
   inline std::vector<std::any> parametersView() const;
+  inline size_t parameterCount() const;
+  template <typename F>
+  inline bool forEachParameter(F &&fn) const;
 
   // inline void setParameter(unsigned int idx, unsigned char *data, uint32_t length);
   // inline void getParameter(unsigned int idx) const;
@@ -468,20 +472,26 @@ inline void SqlStatementFrame::setStatementField(std::string const &val)
   d_framedata.emplace_back(std::make_tuple(static_cast<unsigned int>(FIELD::STATEMENT), temp, val.length()));
 }
 
-inline void SqlStatementFrame::addStringParameter(std::string const &val)
+inline void SqlStatementFrame::addStringParameter(std::string_view val)
 {
   //std::cout << "Adding string parameter: " << val << std::endl;
   unsigned char *temp = new unsigned char[val.length()];
-  std::memcpy(temp, val.c_str(), val.length());
+  std::memcpy(temp, val.data(), val.length());
   d_parameterdata.emplace_back(std::make_tuple(PARAMETER_FIELD::STRING, temp, val.length()));
   d_framedata.emplace_back(std::make_tuple(FIELD::PARAMETERS, nullptr, 0));
 }
 
 inline void SqlStatementFrame::addBlobParameter(std::pair<std::shared_ptr<unsigned char []>, size_t> const &val)
 {
-  unsigned char *temp = new unsigned char[val.second];
-  std::memcpy(temp, val.first.get(), val.second);
-  d_parameterdata.emplace_back(std::make_tuple(PARAMETER_FIELD::BLOB, temp, val.second));
+  addBlobParameter(val.first.get(), val.second);
+}
+
+inline void SqlStatementFrame::addBlobParameter(unsigned char const *data, size_t size)
+{
+  unsigned char *temp = new unsigned char[size];
+  if (size) [[likely]]
+    std::memcpy(temp, data, size);
+  d_parameterdata.emplace_back(std::make_tuple(PARAMETER_FIELD::BLOB, temp, size));
   d_framedata.emplace_back(std::make_tuple(FIELD::PARAMETERS, nullptr, 0));
 }
 
@@ -664,6 +674,50 @@ inline std::vector<std::any> SqlStatementFrame::parametersView() const
   return parameters;
 }
 
+inline size_t SqlStatementFrame::parameterCount() const
+{
+  return d_parameterdata.size();
+}
+
+/*
+  Calls fn(idx, value) for every parameter, idx is 1-based (like sqlite's bind
+  index). The value is passed in its actual type (long long int, std::nullptr_t,
+  std::string_view, a (pointer, size) pair for blobs, or double) so fn can be a
+  generic lambda that binds without going through std::any. Stops and returns
+  false as soon as fn returns false.
+*/
+template <typename F>
+inline bool SqlStatementFrame::forEachParameter(F &&fn) const
+{
+  int idx = 1;
+  for (auto const &p : d_parameterdata)
+  {
+    bool ok = true;
+    switch (std::get<0>(p))
+    {
+      case PARAMETER_FIELD::INT:
+        ok = fn(idx, static_cast<long long int>(bytesToUint64(std::get<1>(p), std::get<2>(p))));
+        break;
+      case PARAMETER_FIELD::NULLPARAMETER:
+        ok = fn(idx, nullptr);
+        break;
+      case PARAMETER_FIELD::STRING:
+        ok = fn(idx, std::string_view(reinterpret_cast<char const *>(std::get<1>(p)), std::get<2>(p)));
+        break;
+      case PARAMETER_FIELD::BLOB:
+        ok = fn(idx, std::pair<unsigned char *, uint64_t>{std::get<1>(p), std::get<2>(p)});
+        break;
+      case PARAMETER_FIELD::DOUBLE:
+        ok = fn(idx, bepaald::reinterpret<double>(std::get<1>(p)));
+        break;
+    }
+    if (!ok) [[unlikely]]
+      return false;
+    ++idx;
+  }
+  return true;
+}
+
 inline bool SqlStatementFrame::validate(uint64_t) const
 {
   if (d_framedata.empty())
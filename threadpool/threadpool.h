@@ -0,0 +1,126 @@
+/*
+  Copyright (C) 2026  Selwin van Dijk
+
+  This file is part of signalbackup-tools.
+
+  signalbackup-tools is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  signalbackup-tools is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with signalbackup-tools.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// a simple fixed size pool of worker threads. Tasks are run in the order
+// they are submitted, the returned future can be used to collect the result.
+// On destruction, all queued tasks are finished before the workers are joined.
+
+class ThreadPool
+{
+  std::vector<std::thread> d_workers;
+  std::deque<std::function<void()>> d_tasks;
+  std::mutex d_mutex;
+  std::condition_variable d_cv;
+  bool d_stop;
+
+ public:
+  inline explicit ThreadPool(unsigned int threads);
+  ThreadPool(ThreadPool const &other) = delete;
+  ThreadPool &operator=(ThreadPool const &other) = delete;
+  ThreadPool(ThreadPool &&other) = delete;
+  ThreadPool &operator=(ThreadPool &&other) = delete;
+  inline ~ThreadPool();
+  template <typename F>
+  inline std::future<std::invoke_result_t<F>> submit(F &&task);
+  inline unsigned int size() const;
+  inline static unsigned int hardwareThreads();
+
+ private:
+  inline void work();
+};
+
+inline ThreadPool::ThreadPool(unsigned int threads)
+  :
+  d_stop(false)
+{
+  if (threads == 0) [[unlikely]]
+    threads = 1;
+  d_workers.reserve(threads);
+  for (unsigned int i = 0; i < threads; ++i)
+    d_workers.emplace_back(&ThreadPool::work, this);
+}
+
+inline ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(d_mutex);
+    d_stop = true;
+  }
+  d_cv.notify_all();
+  for (auto &w : d_workers)
+    if (w.joinable())
+      w.join();
+}
+
+template <typename F>
+inline std::future<std::invoke_result_t<F>> ThreadPool::submit(F &&task)
+{
+  // std::function needs a copyable target, packaged_task is move-only
+  auto pt = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::forward<F>(task));
+  std::future<std::invoke_result_t<F>> result = pt->get_future();
+  {
+    std::lock_guard<std::mutex> lock(d_mutex);
+    d_tasks.emplace_back([pt]() { (*pt)(); });
+  }
+  d_cv.notify_one();
+  return result;
+}
+
+inline unsigned int ThreadPool::size() const
+{
+  return d_workers.size();
+}
+
+inline unsigned int ThreadPool::hardwareThreads() // static
+{
+  unsigned int hc = std::thread::hardware_concurrency();
+  return hc ? hc : 1;
+}
+
+inline void ThreadPool::work()
+{
+  while (true)
+  {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(d_mutex);
+      d_cv.wait(lock, [this]() { return d_stop || !d_tasks.empty(); });
+      if (d_tasks.empty()) // implies d_stop
+        return;
+      task = std::move(d_tasks.front());
+      d_tasks.pop_front();
+    }
+    task();
+  }
+}
+
+#endif